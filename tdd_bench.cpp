@@ -0,0 +1,315 @@
+//======== Copyright (c) 2023, FIT VUT Brno, All rights reserved. ============//
+//
+// Purpose:     Test Driven Development - graph benchmarks
+//
+// $NoKeywords: $ivs_project_1 $tdd_bench.cpp
+// $Author:     Kirill Shchetiniuk <xshche05@stud.fit.vutbr.cz>
+// $Date:       $2023-02-20
+//============================================================================//
+/**
+ * @file tdd_bench.cpp
+ * @author Kirill Shchetiniuk
+ *
+ * @brief Mereni vykonu tridy reprezentujici graf.
+ *
+ * Vsechny benchmarky jsou parametrizovany poctem uzlu a spousteny nad tremi
+ * rodinami syntetickych grafu: nahodny graf, graf s mocninnym rozdelenim
+ * stupnu a ctvercova mrizka. Samostatne se meri propustnost generatoru
+ * pri sestavovani CSR grafu.
+ */
+
+#include <cmath>
+#include <cstdlib>
+#include <queue>
+#include <random>
+#include <unordered_set>
+
+#include "benchmark/benchmark.h"
+
+#include "tdd_code.h"
+#include "tdd_generators.h"
+
+//============================================================================//
+// Synteticke grafy
+//============================================================================//
+
+/** Seed pro generovani grafu, aby byly behy porovnatelne. */
+static const uint64_t BENCH_SEED = 20230220;
+
+/**
+ * @brief Nahodny graf G(n, m) s prumernym stupnem 4.
+ */
+static Graph& randomFamily(Graph& graph, size_t n)
+{
+    generateInto(graph, ErdosRenyiGenerator(n, 2 * n, BENCH_SEED));
+    return graph;
+}
+
+/**
+ * @brief Graf s mocninnym rozdelenim stupnu (2 hrany na novy uzel).
+ */
+static Graph& powerLawFamily(Graph& graph, size_t n)
+{
+    generateInto(graph, BarabasiAlbertGenerator(n, 2, BENCH_SEED));
+    return graph;
+}
+
+/**
+ * @brief Ctvercova mrizka s priblizne n uzly.
+ */
+static Graph& gridFamily(Graph& graph, size_t n)
+{
+    size_t side = (size_t)std::ceil(std::sqrt((double)n));
+    generateInto(graph, GridGenerator(side, side));
+    return graph;
+}
+
+typedef Graph& (*Family)(Graph&, size_t);
+
+/**
+ * @brief Mycielskiho graf myciel<k> z instanci DIMACS (myciel3 ma 11 uzlu).
+ */
+static Graph& mycielskiInstance(Graph& graph, size_t k)
+{
+    std::vector<Edge> edges{{0, 1}, {1, 2}, {2, 3}, {3, 4}, {4, 0}};
+    size_t n = 5;
+    for (size_t level = 3; level <= k; level++) {
+        std::vector<Edge> next = edges;
+        for (auto edge : edges) {
+            next.emplace_back(edge.a, n + edge.b);
+            next.emplace_back(edge.b, n + edge.a);
+        }
+        for (size_t v = 0; v < n; v++) {
+            next.emplace_back(n + v, 2 * n);
+        }
+        edges.swap(next);
+        n = 2 * n + 1;
+    }
+    graph.addMultipleEdges(edges);
+    return graph;
+}
+
+/**
+ * @brief Graf damy queen<k>_<k> z instanci DIMACS.
+ */
+static Graph& queenInstance(Graph& graph, size_t k)
+{
+    for (size_t a = 0; a < k * k; a++) {
+        for (size_t b = a + 1; b < k * k; b++) {
+            long ra = (long)(a / k), ca = (long)(a % k);
+            long rb = (long)(b / k), cb = (long)(b % k);
+            if (ra == rb || ca == cb || std::labs(ra - rb) == std::labs(ca - cb)) {
+                graph.addEdge(Edge(a, b));
+            }
+        }
+    }
+    return graph;
+}
+
+/**
+ * @brief Graf s pristupem k obema variantam barveni.
+ */
+class BenchGraph : public Graph {
+public:
+    using Graph::coloringDense;
+    using Graph::coloringSparse;
+};
+
+//============================================================================//
+// Benchmarky
+//============================================================================//
+
+template<Family family>
+static void BM_Construction(benchmark::State& state)
+{
+    size_t edges = 0;
+    for (auto _ : state) {
+        Graph graph;
+        edges = family(graph, (size_t)state.range(0)).edgeCount();
+        benchmark::DoNotOptimize(edges);
+    }
+    state.SetItemsProcessed(state.iterations() * (int64_t)edges);
+}
+
+template<Family family>
+static void BM_NodeLookup(benchmark::State& state)
+{
+    size_t n = (size_t)state.range(0);
+    Graph graph;
+    family(graph, n);
+    std::mt19937_64 rng(BENCH_SEED);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(graph.getNode(rng() % n));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+template<Family family>
+static void BM_EdgeLookup(benchmark::State& state)
+{
+    size_t n = (size_t)state.range(0);
+    Graph graph;
+    family(graph, n);
+    std::mt19937_64 rng(BENCH_SEED);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(graph.containsEdge(Edge(rng() % n, rng() % n)));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+template<Family family>
+static void BM_NodeRemoval(benchmark::State& state)
+{
+    for (auto _ : state) {
+        state.PauseTiming();
+        Graph graph;
+        family(graph, (size_t)state.range(0));
+        std::vector<size_t> ids;
+        for (auto node : graph.nodes()) {
+            ids.push_back(node->id);
+        }
+        state.ResumeTiming();
+        for (size_t i = 0; i < ids.size(); i += 2) {
+            graph.removeNode(ids[i]);
+        }
+        benchmark::DoNotOptimize(graph.nodeCount());
+        state.PauseTiming();
+        graph.clear();
+        state.ResumeTiming();
+    }
+}
+
+template<Family family>
+static void BM_Coloring(benchmark::State& state)
+{
+    Graph graph;
+    family(graph, (size_t)state.range(0));
+    for (auto _ : state) {
+        graph.coloring();
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * (int64_t)graph.nodeCount());
+}
+
+/**
+ * @brief Barveni husteho nahodneho grafu s hustotou 1/4.
+ */
+template<bool dense>
+static void BM_DenseColoring(benchmark::State& state)
+{
+    size_t n = (size_t)state.range(0);
+    BenchGraph graph;
+    generateInto(graph, ErdosRenyiGenerator(n, n * n / 8, BENCH_SEED));
+    for (auto _ : state) {
+        if (dense) {
+            graph.coloringDense();
+        }
+        else {
+            graph.coloringSparse();
+        }
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * (int64_t)graph.nodeCount());
+}
+
+/**
+ * @brief Presne barveni instanci ve stylu DIMACS s limitem 2 s.
+ */
+static void BM_ExactColoring(benchmark::State& state, Family instance, size_t k)
+{
+    Graph graph;
+    instance(graph, k);
+    ColoringResult result{};
+    for (auto _ : state) {
+        result = graph.coloringExact(std::chrono::seconds(2));
+    }
+    state.counters["nodes"] = (double)graph.nodeCount();
+    state.counters["colors"] = (double)result.colors;
+    state.counters["lower_bound"] = (double)result.lowerBound;
+    state.counters["optimal"] = result.optimal;
+}
+
+template<Family family>
+static void BM_Traversal(benchmark::State& state)
+{
+    Graph graph;
+    family(graph, (size_t)state.range(0));
+    Node* start = graph.nodes().front();
+    for (auto _ : state) {
+        // prohledavani do sirky pres seznamy sousednich hran
+        std::unordered_set<size_t> visited{start->id};
+        std::queue<Node*> open;
+        open.push(start);
+        while (!open.empty()) {
+            Node* node = open.front();
+            open.pop();
+            for (auto edge : *node->edges) {
+                size_t next = edge->a == node->id ? edge->b : edge->a;
+                if (visited.insert(next).second) {
+                    open.push(graph.getNode(next));
+                }
+            }
+        }
+        benchmark::DoNotOptimize(visited.size());
+    }
+    state.SetItemsProcessed(state.iterations() * (int64_t)graph.nodeCount());
+}
+
+template<class Generator>
+static void BM_CsrGeneration(benchmark::State& state, Generator generator)
+{
+    size_t edges = 0;
+    for (auto _ : state) {
+        CsrGraph csr = CsrGraph::build(generator);
+        edges = csr.edgeCount();
+        benchmark::DoNotOptimize(csr.nodeCount());
+    }
+    state.counters["edges"] = (double)edges;
+    state.counters["edges_per_second"] = benchmark::Counter((double)edges * state.iterations(), benchmark::Counter::kIsRate);
+}
+
+#define GRAPH_BENCHMARK(bench, family) \
+    BENCHMARK_TEMPLATE(bench, family)->RangeMultiplier(4)->Range(64, 4096)
+
+GRAPH_BENCHMARK(BM_Construction, randomFamily);
+GRAPH_BENCHMARK(BM_Construction, powerLawFamily);
+GRAPH_BENCHMARK(BM_Construction, gridFamily);
+GRAPH_BENCHMARK(BM_NodeLookup, randomFamily);
+GRAPH_BENCHMARK(BM_NodeLookup, powerLawFamily);
+GRAPH_BENCHMARK(BM_NodeLookup, gridFamily);
+GRAPH_BENCHMARK(BM_EdgeLookup, randomFamily);
+GRAPH_BENCHMARK(BM_EdgeLookup, powerLawFamily);
+GRAPH_BENCHMARK(BM_EdgeLookup, gridFamily);
+GRAPH_BENCHMARK(BM_NodeRemoval, randomFamily);
+GRAPH_BENCHMARK(BM_NodeRemoval, powerLawFamily);
+GRAPH_BENCHMARK(BM_NodeRemoval, gridFamily);
+GRAPH_BENCHMARK(BM_Coloring, randomFamily);
+GRAPH_BENCHMARK(BM_Coloring, powerLawFamily);
+GRAPH_BENCHMARK(BM_Coloring, gridFamily);
+GRAPH_BENCHMARK(BM_Traversal, randomFamily);
+GRAPH_BENCHMARK(BM_Traversal, powerLawFamily);
+GRAPH_BENCHMARK(BM_Traversal, gridFamily);
+
+BENCHMARK_TEMPLATE(BM_DenseColoring, false)->RangeMultiplier(2)->Range(128, 512)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_DenseColoring, true)->RangeMultiplier(2)->Range(128, 512)->Unit(benchmark::kMillisecond);
+
+BENCHMARK_CAPTURE(BM_ExactColoring, myciel3, mycielskiInstance, 3)->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_ExactColoring, myciel4, mycielskiInstance, 4)->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_ExactColoring, myciel5, mycielskiInstance, 5)->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_ExactColoring, queen5_5, queenInstance, 5)->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_ExactColoring, queen6_6, queenInstance, 6)->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_ExactColoring, queen7_7, queenInstance, 7)->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_ExactColoring, queen8_8, queenInstance, 8)->Unit(benchmark::kMillisecond);
+
+BENCHMARK_CAPTURE(BM_CsrGeneration, erdos_renyi, ErdosRenyiGenerator(1 << 20, 16 << 20, BENCH_SEED))
+        ->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK_CAPTURE(BM_CsrGeneration, barabasi_albert, BarabasiAlbertGenerator(1 << 20, 16, BENCH_SEED))
+        ->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK_CAPTURE(BM_CsrGeneration, rmat, RmatGenerator(20, 16, BENCH_SEED))
+        ->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK_CAPTURE(BM_CsrGeneration, grid, GridGenerator(4096, 4096))
+        ->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK_CAPTURE(BM_CsrGeneration, complete_bipartite, CompleteBipartiteGenerator(4096, 4096))
+        ->Unit(benchmark::kMillisecond)->UseRealTime();
+
+/*** Konec souboru tdd_bench.cpp ***/
@@ -16,6 +16,331 @@
 
 #include "tdd_code.h"
 #include <algorithm>
+#include <cstdint>
+#include <unordered_map>
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace {
+
+/** Minimální počet uzlů, od kterého má smysl barvit přes bitovou matici. */
+const size_t DENSE_MIN_NODES = 64;
+/** Maximální počet uzlů pro bitovou matici (16384^2 bitů = 32 MiB). */
+const size_t DENSE_MAX_NODES = 16384;
+/** Hustota grafu 2|E| / (|V| (|V| - 1)), od které se graf považuje za hustý. */
+const double DENSE_THRESHOLD = 0.125;
+
+/**
+ * @return index nejnižšího nastaveného bitu nenulového slova
+ */
+inline size_t lowestBit(uint64_t word)
+{
+#if defined(_MSC_VER)
+	unsigned long idx;
+	_BitScanForward64(&idx, word);
+	return idx;
+#else
+	return (size_t)__builtin_ctzll(word);
+#endif
+}
+
+/**
+ * @brief Odhad skutečné velikosti bloku alokovaného přes malloc/new (glibc).
+ * @param[in] size požadovaná velikost
+ * @return velikost bloku včetně hlavičky a zarovnání
+ */
+inline size_t mallocChunk(size_t size)
+{
+	size_t chunk = (size + sizeof(size_t) + 15) & ~(size_t)15;
+	return chunk < 32 ? 32 : chunk;
+}
+
+/**
+ * @return počet nastavených bitů slova
+ */
+inline size_t bitCount(uint64_t word)
+{
+#if defined(_MSC_VER)
+	return (size_t)__popcnt64(word);
+#else
+	return (size_t)__builtin_popcountll(word);
+#endif
+}
+
+/**
+ * @brief Čtvercová bitová matice, délka řádku je násobkem 128 bitů.
+ */
+class BitMatrix {
+public:
+	explicit BitMatrix(size_t size) : m_words(((size + 127) / 128) * 2), m_bits(size * m_words, 0) { }
+
+	size_t words() const { return m_words; }
+	uint64_t* row(size_t i) { return m_bits.data() + i * m_words; }
+	const uint64_t* row(size_t i) const { return m_bits.data() + i * m_words; }
+	void set(size_t i, size_t j) { m_bits[i * m_words + j / 64] |= (uint64_t)1 << (j % 64); }
+
+private:
+	size_t m_words;
+	std::vector<uint64_t> m_bits;
+};
+
+/**
+ * @brief Zavolá @p visit(bit) pro každý bit nastavený v @p a i @p b.
+ *
+ * Dvojice slov se zpracovávají po 128 bitech; bloky bez společného bitu se
+ * přeskočí jedním porovnáním.
+ */
+template<class Visit>
+inline void forEachCommonBit(const uint64_t* a, const uint64_t* b, size_t words, Visit visit)
+{
+	for (size_t w = 0; w < words; w += 2) {
+#if defined(__SSE2__) || defined(_M_X64)
+		__m128i both = _mm_and_si128(_mm_loadu_si128((const __m128i*)(a + w)),
+		                             _mm_loadu_si128((const __m128i*)(b + w)));
+		if (_mm_movemask_epi8(_mm_cmpeq_epi8(both, _mm_setzero_si128())) == 0xFFFF) {
+			continue;
+		}
+#endif
+		for (size_t k = w; k < w + 2; k++) {
+			for (uint64_t bits = a[k] & b[k]; bits; bits &= bits - 1) {
+				visit(k * 64 + lowestBit(bits));
+			}
+		}
+	}
+}
+
+
+/**
+ * @brief Přesné barvení grafu metodou DSatur s ořezáváním.
+ *
+ * Uzly jsou očíslovány pořadím v poli uzlů grafu. Barvy jsou číslovány od 1,
+ * 0 značí neobarvený uzel.
+ */
+class ExactColoring {
+public:
+	ExactColoring(const std::vector<Node*>& nodes, const std::vector<Edge*>& edges,
+	              std::chrono::steady_clock::time_point deadline)
+		: m_n(nodes.size()), m_adjacency(nodes.size()), m_degree(nodes.size(), 0),
+		  m_color(nodes.size(), 0), m_saturation(nodes.size(), 0), m_deadline(deadline)
+	{
+		std::unordered_map<size_t, size_t> position;
+		for (size_t i = 0; i < m_n; i++) {
+			position[nodes[i]->id] = i;
+		}
+		for (auto edge : edges) {
+			size_t a = position[edge->a];
+			size_t b = position[edge->b];
+			m_adjacency.set(a, b);
+			m_adjacency.set(b, a);
+			m_degree[a]++;
+			m_degree[b]++;
+		}
+		m_words = m_adjacency.words();
+		m_uncolored.assign(m_words, 0);
+	}
+
+	ColoringResult solve()
+	{
+		if (m_n == 0) {
+			return ColoringResult{0, 0, true};
+		}
+		m_best = heuristic();
+		std::vector<size_t> clique = maxClique();
+		m_lowerBound = clique.size();
+		if (m_best > m_lowerBound) {
+			m_width = m_best + 1;
+			m_conflicts.assign(m_n * m_width, 0);
+			for (size_t v = 0; v < m_n; v++) {
+				m_uncolored[v / 64] |= (uint64_t)1 << (v % 64);
+			}
+			// uzly kliky musi mit ruzne barvy, jejich predbarveni odstrani symetricka reseni
+			for (size_t i = 0; i < clique.size(); i++) {
+				assign(clique[i], i + 1);
+			}
+			search(clique.size(), clique.size());
+		}
+		return ColoringResult{m_best, m_lowerBound, !m_expired};
+	}
+
+	const std::vector<size_t>& colors() const { return m_bestColor; }
+
+private:
+	/**
+	 * @brief Heuristické DSatur barvení, uloží jej jako nejlepší a vrátí počet barev.
+	 */
+	size_t heuristic()
+	{
+		std::vector<std::vector<bool>> forbidden(m_n, std::vector<bool>(m_n + 2, false));
+		std::vector<size_t> saturation(m_n, 0);
+		std::vector<size_t> color(m_n, 0);
+		size_t used = 0;
+		for (size_t step = 0; step < m_n; step++) {
+			size_t v = m_n;
+			for (size_t u = 0; u < m_n; u++) {
+				if (color[u] == 0 && (v == m_n || saturation[u] > saturation[v] ||
+				                      (saturation[u] == saturation[v] && m_degree[u] > m_degree[v]))) {
+					v = u;
+				}
+			}
+			size_t c = 1;
+			while (forbidden[v][c]) {
+				c++;
+			}
+			color[v] = c;
+			used = std::max(used, c);
+			const uint64_t* row = m_adjacency.row(v);
+			for (size_t w = 0; w < m_words; w++) {
+				for (uint64_t bits = row[w]; bits; bits &= bits - 1) {
+					size_t u = w * 64 + lowestBit(bits);
+					if (!forbidden[u][c]) {
+						forbidden[u][c] = true;
+						saturation[u]++;
+					}
+				}
+			}
+		}
+		m_bestColor = color;
+		return used;
+	}
+
+	/**
+	 * @brief Hladově hledá velkou kliku z každého počátečního uzlu.
+	 */
+	std::vector<size_t> maxClique() const
+	{
+		std::vector<size_t> best;
+		std::vector<uint64_t> candidates(m_words);
+		for (size_t start = 0; start < m_n; start++) {
+			if (m_degree[start] < best.size()) {
+				continue;
+			}
+			std::vector<size_t> clique{start};
+			const uint64_t* row = m_adjacency.row(start);
+			std::copy(row, row + m_words, candidates.begin());
+			while (true) {
+				// vyber kandidata s nejvice sousedy mezi zbyvajicimi kandidaty
+				size_t pick = m_n;
+				size_t pickDegree = 0;
+				for (size_t w = 0; w < m_words; w++) {
+					for (uint64_t bits = candidates[w]; bits; bits &= bits - 1) {
+						size_t u = w * 64 + lowestBit(bits);
+						const uint64_t* urow = m_adjacency.row(u);
+						size_t degree = 0;
+						for (size_t k = 0; k < m_words; k++) {
+							degree += bitCount(urow[k] & candidates[k]);
+						}
+						if (pick == m_n || degree > pickDegree) {
+							pick = u;
+							pickDegree = degree;
+						}
+					}
+				}
+				if (pick == m_n) {
+					break;
+				}
+				clique.push_back(pick);
+				const uint64_t* prow = m_adjacency.row(pick);
+				for (size_t k = 0; k < m_words; k++) {
+					candidates[k] &= prow[k];
+				}
+			}
+			if (clique.size() > best.size()) {
+				best = clique;
+			}
+		}
+		return best;
+	}
+
+	void assign(size_t v, size_t c)
+	{
+		m_color[v] = c;
+		m_uncolored[v / 64] &= ~((uint64_t)1 << (v % 64));
+		forEachCommonBit(m_adjacency.row(v), m_uncolored.data(), m_words, [&](size_t u) {
+			if (m_conflicts[u * m_width + c]++ == 0) {
+				m_saturation[u]++;
+			}
+		});
+	}
+
+	void unassign(size_t v, size_t c)
+	{
+		forEachCommonBit(m_adjacency.row(v), m_uncolored.data(), m_words, [&](size_t u) {
+			if (--m_conflicts[u * m_width + c] == 0) {
+				m_saturation[u]--;
+			}
+		});
+		m_uncolored[v / 64] |= (uint64_t)1 << (v % 64);
+		m_color[v] = 0;
+	}
+
+	bool expired()
+	{
+		if (!m_expired && (++m_steps & 255) == 0 && std::chrono::steady_clock::now() >= m_deadline) {
+			m_expired = true;
+		}
+		return m_expired;
+	}
+
+	/**
+	 * @param[in] colored počet obarvených uzlů
+	 * @param[in] used počet použitých barev
+	 */
+	void search(size_t colored, size_t used)
+	{
+		if (colored == m_n) {
+			m_best = used;
+			m_bestColor = m_color;
+			return;
+		}
+		if (expired()) {
+			return;
+		}
+		// nejvyssi saturace, pri shode nejvyssi stupen
+		size_t v = m_n;
+		for (size_t w = 0; w < m_words; w++) {
+			for (uint64_t bits = m_uncolored[w]; bits; bits &= bits - 1) {
+				size_t u = w * 64 + lowestBit(bits);
+				if (v == m_n || m_saturation[u] > m_saturation[v] ||
+				    (m_saturation[u] == m_saturation[v] && m_degree[u] > m_degree[v])) {
+					v = u;
+				}
+			}
+		}
+		for (size_t c = 1; c <= used + 1 && c < m_best; c++) {
+			if (m_conflicts[v * m_width + c] != 0) {
+				continue;
+			}
+			assign(v, c);
+			search(colored + 1, std::max(used, c));
+			unassign(v, c);
+			if (m_best == m_lowerBound || m_expired) {
+				return;
+			}
+		}
+	}
+
+	size_t m_n;
+	size_t m_words = 0;
+	size_t m_width = 0;
+	BitMatrix m_adjacency;
+	std::vector<size_t> m_degree;
+	std::vector<size_t> m_color;
+	std::vector<size_t> m_saturation;
+	std::vector<uint32_t> m_conflicts;
+	std::vector<uint64_t> m_uncolored;
+	std::vector<size_t> m_bestColor;
+	size_t m_best = 0;
+	size_t m_lowerBound = 0;
+	size_t m_steps = 0;
+	bool m_expired = false;
+	std::chrono::steady_clock::time_point m_deadline;
+};
+
+}
 
 
 Graph::Graph()
@@ -130,7 +455,9 @@ void Graph::removeNode(size_t nodeId){
 	if (!node_c) {
 		throw std::out_of_range("Node does not exist");
 	}
-	for (auto edge : *node_c->edges) {
+	// removeEdge meni seznam hran uzlu, proto se prochazi jeho kopie
+	std::vector<Edge*> edges = *node_c->edges;
+	for (auto edge : edges) {
 		this->removeEdge(*edge);
 	}
 	for (auto node : m_nodes) {
@@ -199,7 +526,24 @@ size_t Graph::graphDegree() {
 }
 
 void Graph::coloring(){
-for (auto node : m_nodes) {
+	if (isDense()) {
+		coloringDense();
+	}
+	else {
+		coloringSparse();
+	}
+}
+
+bool Graph::isDense() const{
+	size_t n = m_nodes.size();
+	if (n < DENSE_MIN_NODES || n > DENSE_MAX_NODES) {
+		return false;
+	}
+	return 2.0 * (double)m_edges.size() >= DENSE_THRESHOLD * (double)n * (double)(n - 1);
+}
+
+void Graph::coloringSparse(){
+	for (auto node : m_nodes) {
 		node->color = 0;
 	}
 	for (auto node : m_nodes) {
@@ -223,6 +567,51 @@ for (auto node : m_nodes) {
 	}
 }
 
+void Graph::coloringDense(){
+	size_t n = m_nodes.size();
+	std::unordered_map<size_t, size_t> position;
+	position.reserve(n);
+	for (size_t i = 0; i < n; i++) {
+		position[m_nodes[i]->id] = i;
+	}
+	BitMatrix adjacency(n);
+	for (auto edge : m_edges) {
+		size_t a = position[edge->a];
+		size_t b = position[edge->b];
+		adjacency.set(a, b);
+		adjacency.set(b, a);
+	}
+
+	size_t words = adjacency.words();
+	std::vector<uint64_t> colored(words, 0);
+	std::vector<size_t> color(n, 0);
+	std::vector<uint64_t> used;
+	for (size_t v = 0; v < n; v++) {
+		// barvy 1 .. graphDegree + 1, bit c - 1 znaci obsazenou barvu c
+		used.assign(n / 64 + 1, 0);
+		forEachCommonBit(adjacency.row(v), colored.data(), words, [&](size_t u) {
+			size_t c = color[u] - 1;
+			used[c / 64] |= (uint64_t)1 << (c % 64);
+		});
+		size_t w = 0;
+		while (~used[w] == 0) {
+			w++;
+		}
+		color[v] = w * 64 + lowestBit(~used[w]) + 1;
+		colored[v / 64] |= (uint64_t)1 << (v % 64);
+		m_nodes[v]->color = color[v];
+	}
+}
+
+ColoringResult Graph::coloringExact(std::chrono::milliseconds budget){
+	ExactColoring solver(m_nodes, m_edges, std::chrono::steady_clock::now() + budget);
+	ColoringResult result = solver.solve();
+	for (size_t i = 0; i < m_nodes.size(); i++) {
+		m_nodes[i]->color = solver.colors()[i];
+	}
+	return result;
+}
+
 void Graph::clear() {
 	for (auto node : m_nodes) {
 		delete node->edges;
@@ -237,4 +626,61 @@ void Graph::clear() {
 	m_edgeCount = 0;
 }
 
+GraphMemoryUsage Graph::memoryUsage() const{
+	GraphMemoryUsage usage{};
+	usage.nodeStorage = m_nodes.size() * (sizeof(Node) + sizeof(std::vector<Edge*>));
+	usage.edgeStorage = m_edges.size() * sizeof(Edge);
+	usage.indexStorage = m_nodes.capacity() * sizeof(Node*) + m_edges.capacity() * sizeof(Edge*);
+	usage.allocatorOverhead = m_nodes.size() * (mallocChunk(sizeof(Node)) - sizeof(Node))
+	                        + m_nodes.size() * (mallocChunk(sizeof(std::vector<Edge*>)) - sizeof(std::vector<Edge*>))
+	                        + m_edges.size() * (mallocChunk(sizeof(Edge)) - sizeof(Edge));
+	for (auto node : m_nodes) {
+		usage.adjacency += node->edges->size() * sizeof(Edge*);
+		usage.adjacencySlack += (node->edges->capacity() - node->edges->size()) * sizeof(Edge*);
+		if (node->edges->capacity()) {
+			size_t bytes = node->edges->capacity() * sizeof(Edge*);
+			usage.allocatorOverhead += mallocChunk(bytes) - bytes;
+		}
+	}
+	if (m_nodes.capacity()) {
+		usage.allocatorOverhead += mallocChunk(m_nodes.capacity() * sizeof(Node*)) - m_nodes.capacity() * sizeof(Node*);
+	}
+	if (m_edges.capacity()) {
+		usage.allocatorOverhead += mallocChunk(m_edges.capacity() * sizeof(Edge*)) - m_edges.capacity() * sizeof(Edge*);
+	}
+	return usage;
+}
+
+void Graph::shrinkToFit(){
+	// nove hrany se alokuji drive, nez se stare uvolni, aby zaplnily diry po smazanych hranach
+	std::unordered_map<Edge*, Edge*> relocated;
+	relocated.reserve(m_edges.size());
+	std::vector<Edge*> edges;
+	edges.reserve(m_edges.size());
+	for (auto edge : m_edges) {
+		Edge* edge_c = (Edge*)malloc(sizeof(Edge));
+		if (!edge_c) {
+			for (auto created : edges) {
+				free(created);
+			}
+			return;
+		}
+		edge_c->a = edge->a;
+		edge_c->b = edge->b;
+		relocated[edge] = edge_c;
+		edges.push_back(edge_c);
+	}
+	for (auto node : m_nodes) {
+		for (auto& edge : *node->edges) {
+			edge = relocated[edge];
+		}
+		node->edges->shrink_to_fit();
+	}
+	for (auto edge : m_edges) {
+		free(edge);
+	}
+	m_edges.swap(edges);
+	m_nodes.shrink_to_fit();
+}
+
 /*** Konec souboru tdd_code.cpp ***/
@@ -21,6 +21,7 @@
 #include <vector>
 #include <stdexcept>
 #include <iostream>
+#include <chrono>
 
 class Edge;
 /**
@@ -80,6 +81,34 @@ public:
     }
 };
 
+/**
+ * @brief výsledek přesného barvení grafu
+ */
+struct ColoringResult{
+    size_t colors;  ///< počet použitých barev
+    size_t lowerBound;  ///< dolní odhad chromatického čísla (velikost nalezené kliky)
+    bool optimal;  ///< true pokud je obarvení prokazatelně minimální
+};
+
+/**
+ * @brief rozpis paměti alokované grafem v bajtech
+ */
+struct GraphMemoryUsage{
+    size_t nodeStorage;  ///< struktury uzlů a hlavičky jejich seznamů hran
+    size_t edgeStorage;  ///< struktury hran
+    size_t adjacency;  ///< využitá část seznamů hran jednotlivých uzlů
+    size_t adjacencySlack;  ///< nevyužitá kapacita seznamů hran jednotlivých uzlů
+    size_t indexStorage;  ///< pole ukazatelů na všechny uzly a hrany včetně nevyužité kapacity
+    size_t allocatorOverhead;  ///< odhad režie alokátoru (hlavičky a zarovnání bloků)
+
+    /**
+     * @return celková paměť v bajtech
+     */
+    size_t total() const{
+        return nodeStorage + edgeStorage + adjacency + adjacencySlack + indexStorage + allocatorOverhead;
+    }
+};
+
 /**
  * @brief Třída reprezentující neorientovaný graf bez smyček.
  *
@@ -194,15 +223,64 @@ public:
      * ale musí být splněny testy.
      *
      * Barvením se rozumí, že přiřadíte každému uzlu barvu tak, že sousední uzly nemají stejnou barvu.
+     *
+     * Podle hustoty grafu se automaticky volí barvení přes seznamy hran nebo přes bitovou matici sousednosti.
      */
     void coloring();
 
+    /**
+     * Provede obarvení uzlů minimálním počtem barev. Obarvení je uloženo v atributu color v daném uzlu.
+     *
+     * Používá se prohledávání s návratem podle DSatur s ořezáváním: horní mez dává heuristické DSatur
+     * obarvení, dolní mez největší nalezená klika, jejíž uzly jsou předbarveny. Kandidátní uzly i sousedé
+     * se procházejí po bitových slovech. Určeno pro malé grafy (do cca 200 uzlů).
+     *
+     * Pokud vyprší časový limit, v uzlech zůstane nejlepší dosud nalezené obarvení a ve výsledku je
+     * optimal == false.
+     *
+     * @param[in] budget časový limit prohledávání
+     * @return počet použitých barev, dolní mez a příznak optimality
+     */
+    ColoringResult coloringExact(std::chrono::milliseconds budget = std::chrono::milliseconds(1000));
+
     /**
      * Smazání všech uzlů a hran v grafu.
      */
     void clear();
 
+    /**
+     * Spočítá paměť alokovanou grafem. Režie alokátoru je odhadnuta podle glibc malloc
+     * (8 B hlavička, zarovnání na 16 B, minimálně 32 B na blok).
+     *
+     * @return rozpis paměti po jednotlivých částech grafu
+     */
+    GraphMemoryUsage memoryUsage() const;
+
+    /**
+     * Uvolní nevyužitou kapacitu seznamů hran a polí uzlů a hran a přealokuje hrany v pořadí
+     * jejich vložení, aby po mazání vyplnily uvolněná místa na haldě. Uzly se nepřesouvají,
+     * ukazatele na ně zůstávají platné.
+     */
+    void shrinkToFit();
+
 protected:
+    /**
+     * Hladové barvení přes seznamy hran, vhodné pro řídké grafy.
+     */
+    void coloringSparse();
+
+    /**
+     * Hladové barvení nad bitovou maticí sousednosti, vhodné pro husté grafy.
+     * Obsazené barvy sousedů se hledají po 64bitových slovech (AND s maskou
+     * již obarvených uzlů) a nejnižší volná barva pomocí ctz.
+     */
+    void coloringDense();
+
+    /**
+     * @return true pokud je graf dost hustý na barvení přes bitovou matici
+     */
+    bool isDense() const;
+
     std::vector<Node*> m_nodes;
 	std::vector<Edge*> m_edges;
 	size_t m_nodeCount;
@@ -0,0 +1,78 @@
+//======== Copyright (c) 2023, FIT VUT Brno, All rights reserved. ============//
+//
+// Purpose:     Test Driven Development - synthetic graph generators
+//
+// $NoKeywords: $ivs_project_1 $tdd_generators.cpp
+// $Author:     Kirill Shchetiniuk <xshche05@stud.fit.vutbr.cz>
+// $Date:       $2023-02-20
+//============================================================================//
+/**
+ * @file tdd_generators.cpp
+ * @author Kirill Shchetiniuk
+ *
+ * @brief Implementace sestaveni CSR grafu z generatoru.
+ */
+
+#include "tdd_generators.h"
+#include <algorithm>
+#include <thread>
+
+
+void CsrGraph::parallelFor(size_t partitions, unsigned threads, const std::function<void(size_t)>& work)
+{
+	if (threads == 0) {
+		threads = std::max(1u, std::thread::hardware_concurrency());
+	}
+	if (threads > partitions) {
+		threads = (unsigned)std::max<size_t>(1, partitions);
+	}
+	if (threads == 1) {
+		for (size_t p = 0; p < partitions; p++) {
+			work(p);
+		}
+		return;
+	}
+	std::atomic<size_t> next(0);
+	std::vector<std::thread> pool;
+	for (unsigned t = 0; t < threads; t++) {
+		pool.emplace_back([&]() {
+			for (size_t p = next.fetch_add(1); p < partitions; p = next.fetch_add(1)) {
+				work(p);
+			}
+		});
+	}
+	for (auto& thread : pool) {
+		thread.join();
+	}
+}
+
+void CsrGraph::finalize(unsigned threads)
+{
+	size_t n = nodeCount();
+	std::vector<size_t> degrees(n);
+	const size_t chunk = 4096;
+	parallelFor((n + chunk - 1) / chunk, threads, [&](size_t p) {
+		size_t end = std::min(n, (p + 1) * chunk);
+		for (size_t v = p * chunk; v < end; v++) {
+			uint32_t* begin = m_targets.data() + m_offsets[v];
+			uint32_t* last = m_targets.data() + m_offsets[v + 1];
+			std::sort(begin, last);
+			degrees[v] = std::unique(begin, last) - begin;
+		}
+	});
+	// zhusteni poli po odstraneni duplicitnich hran, data se posouvaji jen doleva
+	size_t write = 0;
+	for (size_t v = 0; v < n; v++) {
+		size_t read = m_offsets[v];
+		std::copy(m_targets.begin() + read, m_targets.begin() + read + degrees[v], m_targets.begin() + write);
+		m_offsets[v] = write;
+		write += degrees[v];
+	}
+	if (n) {
+		m_offsets[n] = write;
+	}
+	m_targets.resize(write);
+	m_targets.shrink_to_fit();
+}
+
+/*** Konec souboru tdd_generators.cpp ***/
@@ -0,0 +1,482 @@
+//======== Copyright (c) 2023, FIT VUT Brno, All rights reserved. ============//
+//
+// Purpose:     Test Driven Development - synthetic graph generators
+//
+// $NoKeywords: $ivs_project_1 $tdd_generators.h
+// $Author:     Kirill Shchetiniuk <xshche05@stud.fit.vutbr.cz>
+// $Date:       $2023-02-20
+//============================================================================//
+/**
+ * @file tdd_generators.h
+ * @author Kirill Shchetiniuk
+ *
+ * @brief Deterministicke generatory syntetickych grafu.
+ *
+ * Kazdy generator rozdeli svuj vystup na pevny pocet oddilu (partition).
+ * Oddil je urcen pouze seedem a svym poradim, proto lze oddily generovat
+ * paralelne a v libovolnem poradi a vysledek je vzdy stejny. Hrany se
+ * posilaji primo do cile (sink) -- funkce s parametry @c (a, b) -- bez
+ * mezilehleho vektoru hran. Smycky a duplicitni hrany odstrani az cil.
+ */
+#pragma once
+
+#ifndef TDD_GENERATORS_H_
+#define TDD_GENERATORS_H_
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <stdexcept>
+#include <vector>
+
+#include "tdd_code.h"
+
+/**
+ * @brief Pseudonahodny generator SplitMix64.
+ *
+ * Maly a rychly generator, ktery se da levne inicializovat pro kazdy oddil
+ * (nebo kazdou hranu) zvlast.
+ */
+struct SplitMix64 {
+    uint64_t state;  ///< vnitrni stav generatoru
+
+    /**
+     * @param[in] seed pocatecni stav
+     */
+    explicit SplitMix64(uint64_t seed) : state(seed) { }
+
+    /**
+     * @brief Zamicha 64bitovou hodnotu (finalizer SplitMix64).
+     * @param[in] x vstupni hodnota
+     * @return zamichana hodnota
+     */
+    static uint64_t mix(uint64_t x) {
+        x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+        return x ^ (x >> 31);
+    }
+
+    /**
+     * @brief Odvodi seed oddilu ze seedu generatoru.
+     * @param[in] seed seed generatoru
+     * @param[in] stream cislo oddilu nebo hrany
+     * @return seed proudu
+     */
+    static uint64_t derive(uint64_t seed, uint64_t stream) {
+        return mix(seed ^ mix(stream + 0x9e3779b97f4a7c15ULL));
+    }
+
+    /**
+     * @return dalsi pseudonahodne cislo
+     */
+    uint64_t next() {
+        state += 0x9e3779b97f4a7c15ULL;
+        return mix(state);
+    }
+
+    /**
+     * @brief Zobrazi nahodne cislo do intervalu [0, bound) bez deleni.
+     * @param[in] x nahodne cislo
+     * @param[in] bound horni mez (nezahrnuta)
+     * @return cislo z intervalu [0, bound)
+     */
+    static uint64_t reduce(uint64_t x, uint64_t bound) {
+#if defined(__SIZEOF_INT128__)
+        return (uint64_t)(((unsigned __int128)x * bound) >> 64);
+#else
+        return x % bound;
+#endif
+    }
+
+    /**
+     * @param[in] bound horni mez (nezahrnuta)
+     * @return nahodne cislo z intervalu [0, bound)
+     */
+    uint64_t below(uint64_t bound) {
+        return reduce(next(), bound);
+    }
+
+    /**
+     * @return nahodne cislo z intervalu [0, 1)
+     */
+    double uniform() {
+        return (double)(next() >> 11) * (1.0 / 9007199254740992.0);
+    }
+};
+
+/**
+ * @brief Nahodny graf G(n, m) (Erdős–Rényi).
+ *
+ * Vygeneruje @c m nahodnych dvojic uzlu z @c n uzlu. Dvojice jsou vybirany
+ * s opakovanim, vysledny graf proto muze mit o nekolik hran mene.
+ */
+class ErdosRenyiGenerator {
+public:
+    /**
+     * @param[in] nodes pocet uzlu
+     * @param[in] edges pocet generovanych dvojic
+     * @param[in] seed seed generatoru
+     */
+    ErdosRenyiGenerator(size_t nodes, size_t edges, uint64_t seed)
+        : m_nodes(nodes), m_edges(edges), m_seed(seed) { }
+
+    /** @return pocet uzlu, id uzlu jsou 0 .. nodeCount() - 1 */
+    size_t nodeCount() const { return m_nodes; }
+
+    /** @return pocet oddilu */
+    size_t partitions() const { return (m_edges + CHUNK - 1) / CHUNK; }
+
+    /**
+     * @brief Vygeneruje hrany jednoho oddilu.
+     * @param[in] partition cislo oddilu
+     * @param[in] sink cil hran
+     */
+    template<class Sink>
+    void generate(size_t partition, Sink&& sink) const {
+        if (m_nodes < 2) return;
+        SplitMix64 rng(SplitMix64::derive(m_seed, partition));
+        size_t begin = partition * CHUNK;
+        size_t end = begin + CHUNK < m_edges ? begin + CHUNK : m_edges;
+        for (size_t i = begin; i < end; i++) {
+            size_t a = (size_t)rng.below(m_nodes);
+            size_t b = (size_t)rng.below(m_nodes);
+            sink(a, b);
+        }
+    }
+
+private:
+    static const size_t CHUNK = 1 << 16;
+    size_t m_nodes;
+    size_t m_edges;
+    uint64_t m_seed;
+};
+
+/**
+ * @brief Graf s mocninnym rozdelenim stupnu (Barabási–Albert).
+ *
+ * Kazdy uzel @c v se pripoji @c k hranami k uzlum vybranym umerne jejich
+ * stupni. Pouziva se formulace Batagelj–Brandes nad polem koncovych bodu,
+ * kde cil hrany je koncovy bod nahodne drivejsi pozice. Nahodna volba pozice
+ * zavisi pouze na seedu a cisle pozice, takze cil kazde hrany lze dopocitat
+ * nezavisle a generovani je paralelizovatelne.
+ */
+class BarabasiAlbertGenerator {
+public:
+    /**
+     * @param[in] nodes pocet uzlu
+     * @param[in] k pocet hran pridanych s kazdym uzlem
+     * @param[in] seed seed generatoru
+     */
+    BarabasiAlbertGenerator(size_t nodes, size_t k, uint64_t seed)
+        : m_nodes(nodes), m_k(k ? k : 1), m_seed(seed) { }
+
+    /** @return pocet uzlu, id uzlu jsou 0 .. nodeCount() - 1 */
+    size_t nodeCount() const { return m_nodes; }
+
+    /** @return pocet oddilu */
+    size_t partitions() const { return (m_nodes + CHUNK - 1) / CHUNK; }
+
+    /**
+     * @brief Vygeneruje hrany uzlu jednoho oddilu.
+     * @param[in] partition cislo oddilu
+     * @param[in] sink cil hran
+     */
+    template<class Sink>
+    void generate(size_t partition, Sink&& sink) const {
+        size_t begin = partition * CHUNK;
+        size_t end = begin + CHUNK < m_nodes ? begin + CHUNK : m_nodes;
+        for (size_t v = begin; v < end; v++) {
+            for (size_t i = 0; i < m_k; i++) {
+                uint64_t slot = 2 * (v * m_k + i);
+                sink(v, endpoint(slot + 1));
+            }
+        }
+    }
+
+private:
+    /**
+     * @brief Dopocita uzel na pozici @p slot pole koncovych bodu.
+     *
+     * Sude pozice jsou zdrojove uzly hran, liche pozice kopiruji nahodnou
+     * drivejsi pozici.
+     */
+    size_t endpoint(uint64_t slot) const {
+        while (slot & 1) {
+            slot = SplitMix64::reduce(SplitMix64::derive(m_seed, slot), slot);
+        }
+        return (size_t)(slot / 2 / m_k);
+    }
+
+    static const size_t CHUNK = 1 << 14;
+    size_t m_nodes;
+    size_t m_k;
+    uint64_t m_seed;
+};
+
+/**
+ * @brief Rekurzivni maticovy generator R-MAT (Kronecker).
+ *
+ * Graf ma 2^scale uzlu a edgeFactor * 2^scale generovanych hran. Kazda hrana
+ * vznikne opakovanym vyberem kvadrantu matice sousednosti s pravdepodobnostmi
+ * a, b, c a 1 - a - b - c.
+ */
+class RmatGenerator {
+public:
+    /**
+     * @param[in] scale dvojkovy logaritmus poctu uzlu
+     * @param[in] edgeFactor pomer poctu hran k poctu uzlu
+     * @param[in] seed seed generatoru
+     * @param[in] a pravdepodobnost leveho horniho kvadrantu
+     * @param[in] b pravdepodobnost praveho horniho kvadrantu
+     * @param[in] c pravdepodobnost leveho dolniho kvadrantu
+     */
+    RmatGenerator(unsigned scale, size_t edgeFactor, uint64_t seed,
+                  double a = 0.57, double b = 0.19, double c = 0.19)
+        : m_scale(scale), m_edges(edgeFactor << scale), m_seed(seed),
+          m_ab(a + b), m_cNorm(c / (1.0 - a - b)), m_aNorm(a / (a + b)) { }
+
+    /** @return pocet uzlu, id uzlu jsou 0 .. nodeCount() - 1 */
+    size_t nodeCount() const { return (size_t)1 << m_scale; }
+
+    /** @return pocet oddilu */
+    size_t partitions() const { return (m_edges + CHUNK - 1) / CHUNK; }
+
+    /**
+     * @brief Vygeneruje hrany jednoho oddilu.
+     * @param[in] partition cislo oddilu
+     * @param[in] sink cil hran
+     */
+    template<class Sink>
+    void generate(size_t partition, Sink&& sink) const {
+        SplitMix64 rng(SplitMix64::derive(m_seed, partition));
+        size_t begin = partition * CHUNK;
+        size_t end = begin + CHUNK < m_edges ? begin + CHUNK : m_edges;
+        for (size_t i = begin; i < end; i++) {
+            size_t a = 0, b = 0;
+            for (unsigned bit = 0; bit < m_scale; bit++) {
+                bool down = rng.uniform() > m_ab;
+                bool right = rng.uniform() > (down ? m_cNorm : m_aNorm);
+                a = (a << 1) | (size_t)down;
+                b = (b << 1) | (size_t)right;
+            }
+            sink(a, b);
+        }
+    }
+
+private:
+    static const size_t CHUNK = 1 << 16;
+    unsigned m_scale;
+    size_t m_edges;
+    uint64_t m_seed;
+    double m_ab;
+    double m_cNorm;
+    double m_aNorm;
+};
+
+/**
+ * @brief Dvourozmerna mrizka rows x cols, uzel (r, c) ma id r * cols + c.
+ */
+class GridGenerator {
+public:
+    /**
+     * @param[in] rows pocet radku
+     * @param[in] cols pocet sloupcu
+     */
+    GridGenerator(size_t rows, size_t cols) : m_rows(rows), m_cols(cols) { }
+
+    /** @return pocet uzlu, id uzlu jsou 0 .. nodeCount() - 1 */
+    size_t nodeCount() const { return m_rows * m_cols; }
+
+    /** @return pocet oddilu */
+    size_t partitions() const { return (m_rows + CHUNK - 1) / CHUNK; }
+
+    /**
+     * @brief Vygeneruje hrany radku jednoho oddilu.
+     * @param[in] partition cislo oddilu
+     * @param[in] sink cil hran
+     */
+    template<class Sink>
+    void generate(size_t partition, Sink&& sink) const {
+        size_t begin = partition * CHUNK;
+        size_t end = begin + CHUNK < m_rows ? begin + CHUNK : m_rows;
+        for (size_t r = begin; r < end; r++) {
+            for (size_t c = 0; c < m_cols; c++) {
+                size_t v = r * m_cols + c;
+                if (c + 1 < m_cols) sink(v, v + 1);
+                if (r + 1 < m_rows) sink(v, v + m_cols);
+            }
+        }
+    }
+
+private:
+    static const size_t CHUNK = 256;
+    size_t m_rows;
+    size_t m_cols;
+};
+
+/**
+ * @brief Uplny bipartitni graf K(left, right).
+ *
+ * Uzly leve partity maji id 0 .. left - 1, uzly prave partity
+ * left .. left + right - 1.
+ */
+class CompleteBipartiteGenerator {
+public:
+    /**
+     * @param[in] left pocet uzlu leve partity
+     * @param[in] right pocet uzlu prave partity
+     */
+    CompleteBipartiteGenerator(size_t left, size_t right) : m_left(left), m_right(right) { }
+
+    /** @return pocet uzlu, id uzlu jsou 0 .. nodeCount() - 1 */
+    size_t nodeCount() const { return m_left + m_right; }
+
+    /** @return pocet oddilu */
+    size_t partitions() const { return (m_left + CHUNK - 1) / CHUNK; }
+
+    /**
+     * @brief Vygeneruje hrany uzlu leve partity jednoho oddilu.
+     * @param[in] partition cislo oddilu
+     * @param[in] sink cil hran
+     */
+    template<class Sink>
+    void generate(size_t partition, Sink&& sink) const {
+        size_t begin = partition * CHUNK;
+        size_t end = begin + CHUNK < m_left ? begin + CHUNK : m_left;
+        for (size_t a = begin; a < end; a++) {
+            for (size_t b = 0; b < m_right; b++) {
+                sink(a, m_left + b);
+            }
+        }
+    }
+
+private:
+    static const size_t CHUNK = 64;
+    size_t m_left;
+    size_t m_right;
+};
+
+/**
+ * @brief Neorientovany graf bez smycek a duplicitnich hran v kompaktnim
+ * formatu CSR (compressed sparse row).
+ *
+ * Sousede uzlu @c v jsou serazeni v poli targets na pozicich
+ * offsets[v] .. offsets[v + 1] - 1. Kazda hrana je ulozena v obou smerech.
+ */
+class CsrGraph {
+public:
+    /**
+     * @return počet uzlů v grafu
+     */
+    size_t nodeCount() const { return m_offsets.empty() ? 0 : m_offsets.size() - 1; }
+
+    /**
+     * @return počet hran v grafu
+     */
+    size_t edgeCount() const { return m_targets.size() / 2; }
+
+    /**
+     * @param[in] nodeId id uzlu
+     * @return stupeň uzlu
+     */
+    size_t nodeDegree(size_t nodeId) const { return m_offsets[nodeId + 1] - m_offsets[nodeId]; }
+
+    /**
+     * @param[in] nodeId id uzlu
+     * @return ukazatel na prvniho souseda uzlu
+     */
+    const uint32_t* neighborsBegin(size_t nodeId) const { return m_targets.data() + m_offsets[nodeId]; }
+
+    /**
+     * @param[in] nodeId id uzlu
+     * @return ukazatel za posledniho souseda uzlu
+     */
+    const uint32_t* neighborsEnd(size_t nodeId) const { return m_targets.data() + m_offsets[nodeId + 1]; }
+
+    /**
+     * @brief Vytvori CSR graf z hran generatoru.
+     *
+     * Generator je spusten dvakrat: v prvnim pruchodu se spocitaji stupne
+     * uzlu, ve druhem se hrany zapisi primo na sve misto. Oddily se
+     * zpracovavaji paralelne, vysledek na poctu vlaken nezavisi.
+     *
+     * @param[in] generator generator hran
+     * @param[in] threads pocet vlaken, 0 znamena pocet jader
+     * @return vygenerovany graf
+     * @exception length_error pokud pocet uzlu presahuje rozsah uint32_t
+     */
+    template<class Generator>
+    static CsrGraph build(const Generator& generator, unsigned threads = 0);
+
+protected:
+    /**
+     * @brief Spusti @p work(partition) pro vsechny oddily na @p threads vlaknech.
+     */
+    static void parallelFor(size_t partitions, unsigned threads, const std::function<void(size_t)>& work);
+
+    /**
+     * @brief Seradi seznamy sousedu, odstrani duplicity a zhusti pole.
+     */
+    void finalize(unsigned threads);
+
+    std::vector<size_t> m_offsets;
+    std::vector<uint32_t> m_targets;
+};
+
+/**
+ * @brief Vlozi hrany generatoru do grafu.
+ *
+ * Oddily se zpracovavaji sekvencne, protoze Graph neni vlaknove bezpecny.
+ *
+ * @param[in, out] graph cilovy graf
+ * @param[in] generator generator hran
+ */
+template<class Generator>
+void generateInto(Graph& graph, const Generator& generator)
+{
+    for (size_t p = 0; p < generator.partitions(); p++) {
+        generator.generate(p, [&graph](size_t a, size_t b) { graph.addEdge(Edge(a, b)); });
+    }
+}
+
+template<class Generator>
+CsrGraph CsrGraph::build(const Generator& generator, unsigned threads)
+{
+    size_t n = generator.nodeCount();
+    if (n > UINT32_MAX) {
+        throw std::length_error("Too many nodes for CSR graph");
+    }
+    CsrGraph csr;
+    csr.m_offsets.assign(n + 1, 0);
+    std::vector<std::atomic<size_t>> counts(n);
+    for (auto& count : counts) count.store(0, std::memory_order_relaxed);
+
+    parallelFor(generator.partitions(), threads, [&](size_t p) {
+        generator.generate(p, [&](size_t a, size_t b) {
+            if (a == b) return;
+            counts[a].fetch_add(1, std::memory_order_relaxed);
+            counts[b].fetch_add(1, std::memory_order_relaxed);
+        });
+    });
+
+    for (size_t v = 0; v < n; v++) {
+        csr.m_offsets[v + 1] = csr.m_offsets[v] + counts[v].load(std::memory_order_relaxed);
+        counts[v].store(csr.m_offsets[v], std::memory_order_relaxed);
+    }
+    csr.m_targets.resize(csr.m_offsets[n]);
+
+    parallelFor(generator.partitions(), threads, [&](size_t p) {
+        generator.generate(p, [&](size_t a, size_t b) {
+            if (a == b) return;
+            csr.m_targets[counts[a].fetch_add(1, std::memory_order_relaxed)] = (uint32_t)b;
+            csr.m_targets[counts[b].fetch_add(1, std::memory_order_relaxed)] = (uint32_t)a;
+        });
+    });
+
+    csr.finalize(threads);
+    return csr;
+}
+
+#endif // TDD_GENERATORS_H_
+
+/*** Konec souboru tdd_generators.h ***/
@@ -18,6 +18,7 @@
 #include "gtest/gtest.h"
 #include <gmock/gmock.h>
 #include "tdd_code.h"
+#include "tdd_generators.h"
 
 using namespace ::testing;
 
@@ -352,4 +353,192 @@ TEST(Edges, toStringStream){
     EXPECT_EQ(ss.str(), "{1, 4}");
 }
 
+TEST(DenseGraph, coloringComplete){
+    Graph graph;
+    for (size_t a = 0; a < 100; a++) {
+        for (size_t b = a + 1; b < 100; b++) {
+            graph.addEdge(Edge(a, b));
+        }
+    }
+    graph.coloring();
+    std::set<size_t> colors;
+    for (auto node : graph.nodes()) {
+        colors.insert(node->color);
+    }
+    EXPECT_EQ(colors.size(), 100);
+    EXPECT_EQ(*colors.begin(), 1);
+}
+
+TEST(DenseGraph, coloringRandom){
+    Graph graph;
+    generateInto(graph, ErdosRenyiGenerator(150, 6000, 3));
+    graph.coloring();
+    std::set<size_t> colors;
+    for (auto node : graph.nodes()) {
+        EXPECT_NE(node->color, 0);
+        colors.insert(node->color);
+    }
+    EXPECT_LE(colors.size(), graph.graphDegree() + 1);
+    for (auto edge : graph.edges()) {
+        EXPECT_NE(graph.getNode(edge.a)->color, graph.getNode(edge.b)->color);
+    }
+}
+
+/**
+ * @brief Mycielskiho konstrukce, zvysi chromaticke cislo grafu o 1.
+ */
+static std::vector<Edge> mycielski(const std::vector<Edge>& edges, size_t n){
+    std::vector<Edge> result = edges;
+    for (auto edge : edges) {
+        result.emplace_back(edge.a, n + edge.b);
+        result.emplace_back(edge.b, n + edge.a);
+    }
+    for (size_t v = 0; v < n; v++) {
+        result.emplace_back(n + v, 2 * n);
+    }
+    return result;
+}
+
+TEST(ExactColoring, oddCycle){
+    Graph graph;
+    graph.addMultipleEdges({{0, 1}, {1, 2}, {2, 3}, {3, 4}, {4, 0}});
+    ColoringResult result = graph.coloringExact();
+    EXPECT_EQ(result.colors, 3);
+    EXPECT_TRUE(result.optimal);
+    for (auto edge : graph.edges()) {
+        EXPECT_NE(graph.getNode(edge.a)->color, graph.getNode(edge.b)->color);
+    }
+}
+
+TEST(ExactColoring, myciel4){
+    std::vector<Edge> cycle{{0, 1}, {1, 2}, {2, 3}, {3, 4}, {4, 0}};
+    Graph graph;
+    graph.addMultipleEdges(mycielski(mycielski(cycle, 5), 11));
+    ASSERT_EQ(graph.nodeCount(), 23);
+    ColoringResult result = graph.coloringExact(std::chrono::seconds(10));
+    EXPECT_EQ(result.colors, 5);
+    EXPECT_EQ(result.lowerBound, 2);
+    EXPECT_TRUE(result.optimal);
+    std::set<size_t> colors;
+    for (auto node : graph.nodes()) {
+        colors.insert(node->color);
+    }
+    EXPECT_THAT(colors, ElementsAre(1, 2, 3, 4, 5));
+    for (auto edge : graph.edges()) {
+        EXPECT_NE(graph.getNode(edge.a)->color, graph.getNode(edge.b)->color);
+    }
+}
+
+TEST(ExactColoring, beatsGreedy){
+    // korunovy graf, hladove barveni v poradi vlozeni potrebuje 4 barvy
+    Graph graph;
+    for (size_t a = 0; a < 4; a++) {
+        for (size_t b = 0; b < 4; b++) {
+            if (a != b) {
+                graph.addEdge(Edge(2 * a, 2 * b + 1));
+            }
+        }
+    }
+    ColoringResult result = graph.coloringExact();
+    EXPECT_EQ(result.colors, 2);
+    EXPECT_TRUE(result.optimal);
+}
+
+TEST(ExactColoring, zeroBudget){
+    Graph graph;
+    generateInto(graph, ErdosRenyiGenerator(120, 3000, 11));
+    ColoringResult result = graph.coloringExact(std::chrono::milliseconds(0));
+    EXPECT_GE(result.colors, result.lowerBound);
+    EXPECT_LE(result.colors, graph.graphDegree() + 1);
+    for (auto edge : graph.edges()) {
+        EXPECT_NE(graph.getNode(edge.a)->color, graph.getNode(edge.b)->color);
+    }
+}
+
+TEST_F(EmptyGraph, coloringExact){
+    ColoringResult result = graph.coloringExact();
+    EXPECT_EQ(result.colors, 0);
+    EXPECT_TRUE(result.optimal);
+}
+
+TEST_F(NonEmptyGraph, memoryUsage){
+    GraphMemoryUsage usage = graph.memoryUsage();
+    EXPECT_EQ(usage.edgeStorage, 6 * sizeof(Edge));
+    EXPECT_EQ(usage.adjacency, 12 * sizeof(Edge*));
+    EXPECT_GE(usage.indexStorage, 5 * sizeof(Node*) + 6 * sizeof(Edge*));
+    EXPECT_GT(usage.total(), usage.nodeStorage + usage.edgeStorage + usage.adjacency);
+
+    graph.addEdge(Edge(1, 8));
+    EXPECT_GT(graph.memoryUsage().edgeStorage, usage.edgeStorage);
+}
+
+TEST_F(NonEmptyGraph, shrinkToFit){
+    graph.removeEdge(Edge(5, 6));
+    graph.removeEdge(Edge(5, 7));
+    EXPECT_GT(graph.memoryUsage().adjacencySlack, 0);
+
+    graph.shrinkToFit();
+    GraphMemoryUsage usage = graph.memoryUsage();
+    EXPECT_EQ(usage.adjacencySlack, 0);
+    EXPECT_EQ(usage.indexStorage, 5 * sizeof(Node*) + 4 * sizeof(Edge*));
+    EXPECT_THAT(graph.edges(), UnorderedElementsAre(Eq(Edge(1, 4)), Eq(Edge(1, 5)), Eq(Edge(4, 6)), Eq(Edge(7, 6))));
+    EXPECT_EQ(graph.nodeDegree(5), 1);
+    graph.removeNode(6);
+    EXPECT_THAT(graph.edges(), UnorderedElementsAre(Eq(Edge(1, 4)), Eq(Edge(1, 5))));
+}
+
+TEST(Generators, grid){
+    Graph graph;
+    generateInto(graph, GridGenerator(3, 4));
+    EXPECT_EQ(graph.nodeCount(), 12);
+    EXPECT_EQ(graph.edgeCount(), 3 * 3 + 2 * 4);
+    EXPECT_TRUE(graph.containsEdge(Edge(0, 1)));
+    EXPECT_TRUE(graph.containsEdge(Edge(0, 4)));
+    EXPECT_FALSE(graph.containsEdge(Edge(3, 4)));
+}
+
+TEST(Generators, completeBipartite){
+    CsrGraph csr = CsrGraph::build(CompleteBipartiteGenerator(3, 5), 2);
+    EXPECT_EQ(csr.nodeCount(), 8);
+    EXPECT_EQ(csr.edgeCount(), 15);
+    EXPECT_EQ(csr.nodeDegree(0), 5);
+    EXPECT_EQ(csr.nodeDegree(7), 3);
+    EXPECT_THAT(std::vector<uint32_t>(csr.neighborsBegin(7), csr.neighborsEnd(7)), ElementsAre(0, 1, 2));
+}
+
+TEST(Generators, deterministic){
+    RmatGenerator generator(10, 8, 42);
+    CsrGraph single = CsrGraph::build(generator, 1);
+    CsrGraph parallel = CsrGraph::build(generator, 4);
+    ASSERT_EQ(single.nodeCount(), parallel.nodeCount());
+    ASSERT_EQ(single.edgeCount(), parallel.edgeCount());
+    for (size_t v = 0; v < single.nodeCount(); v++) {
+        EXPECT_TRUE(std::equal(single.neighborsBegin(v), single.neighborsEnd(v),
+                               parallel.neighborsBegin(v), parallel.neighborsEnd(v)));
+    }
+}
+
+TEST(Generators, csrMatchesGraph){
+    BarabasiAlbertGenerator generator(200, 3, 7);
+    Graph graph;
+    generateInto(graph, generator);
+    CsrGraph csr = CsrGraph::build(generator, 3);
+    EXPECT_EQ(csr.edgeCount(), graph.edgeCount());
+    for (auto node : graph.nodes()) {
+        EXPECT_EQ(csr.nodeDegree(node->id), graph.nodeDegree(node->id));
+    }
+}
+
+TEST(Generators, erdosRenyi){
+    ErdosRenyiGenerator generator(1000, 5000, 1);
+    CsrGraph csr = CsrGraph::build(generator);
+    EXPECT_EQ(csr.nodeCount(), 1000);
+    EXPECT_GT(csr.edgeCount(), 4900);
+    EXPECT_LE(csr.edgeCount(), 5000);
+    for (size_t v = 0; v < csr.nodeCount(); v++) {
+        EXPECT_TRUE(std::adjacent_find(csr.neighborsBegin(v), csr.neighborsEnd(v)) == csr.neighborsEnd(v));
+        EXPECT_TRUE(std::find(csr.neighborsBegin(v), csr.neighborsEnd(v), v) == csr.neighborsEnd(v));
+    }
+}
+
 /*** Konec souboru tdd_tests.cpp ***/
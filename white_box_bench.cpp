@@ -0,0 +1,1163 @@
+//======== Copyright (c) 2023, FIT VUT Brno, All rights reserved. ============//
+//
+// Purpose:     White Box - hash map benchmarks
+//
+// $NoKeywords: $ivs_project_1 $white_box_bench.cpp
+// $Author:     Kirill Shchetiniuk <xshche05@stud.fit.vutbr.cz>
+// $Date:       $2023-02-20
+//============================================================================//
+/**
+ * @file white_box_bench.cpp
+ * @author Kirill Shchetiniuk
+ *
+ * @brief Mereni vykonu hasovaci tabulky.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <list>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#if defined(__GLIBC__)
+#include <malloc.h>
+#endif
+
+#include "benchmark/benchmark.h"
+
+#include "white_box_code.h"
+
+//============================================================================//
+// Klice
+//============================================================================//
+
+/** Seed pro generovani klicu, aby byly behy porovnatelne. */
+static const unsigned BENCH_SEED = 20230220;
+
+/**
+ * @brief Vygeneruje @p n ruznych klicu podobnych identifikatorum v kodu
+ *        (napr. "getUserName_17").
+ */
+static std::vector<std::string> identifierKeys(size_t n)
+{
+    static const char* verbs[] = {"get", "set", "is", "has", "on", "to", "make", "find"};
+    static const char* nouns[] = {"User", "Name", "Item", "Node", "Edge", "Color", "Map", "Key",
+                                  "Value", "Index", "Size", "Hash", "Table", "List", "Tree", "Graph"};
+    std::vector<std::string> keys;
+    keys.reserve(n);
+    for (size_t i = 0; keys.size() < n; i++)
+    {
+        std::string key = verbs[i % 8];
+        key += nouns[(i / 8) % 16];
+        key += nouns[(i / 128) % 16];
+        key += "_" + std::to_string(i / 2048);
+        keys.push_back(key);
+    }
+    return keys;
+}
+
+/**
+ * @brief Vygeneruje @p n nahodnych klicu delky @p length.
+ */
+static std::vector<std::string> randomKeys(size_t n, size_t length)
+{
+    std::mt19937 rng(BENCH_SEED);
+    std::uniform_int_distribution<int> letter('a', 'z');
+    std::vector<std::string> keys(n, std::string(length, ' '));
+    for (auto& key : keys)
+    {
+        for (auto& c : key)
+        {
+            c = (char)letter(rng);
+        }
+    }
+    return keys;
+}
+
+/**
+ * @brief Pocet bajtu aktualne alokovanych na halde vcetne rezie alokatoru,
+ *        nebo 0 pokud to platforma neumi zjistit.
+ */
+static size_t heapInUse()
+{
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || __GLIBC_MINOR__ >= 33)
+    struct mallinfo2 info = mallinfo2();
+    // velke bloky alokuje glibc pres mmap a uordblks je nezapocitava
+    return info.uordblks + info.hblkhd;
+#else
+    return 0;
+#endif
+}
+
+/**
+ * @brief Rezidentni pamet procesu v bajtech, nebo 0 mimo Linux.
+ */
+static size_t residentBytes()
+{
+    std::ifstream statm("/proc/self/statm");
+    size_t pages = 0, resident = 0;
+    if (!(statm >> pages >> resident))
+    {
+        return 0;
+    }
+    return resident * 4096;
+}
+
+/**
+ * @brief Naplni tabulku klici, hodnotou je poradi klice.
+ */
+static void fill(hash_map_t* map, const std::vector<std::string>& keys)
+{
+    for (size_t i = 0; i < keys.size(); i++)
+    {
+        hash_map_put(map, keys[i].c_str(), (int)i);
+    }
+}
+
+//============================================================================//
+// Hasovaci funkce
+//============================================================================//
+
+/**
+ * @brief Propustnost hasovaci funkce pro klice dane delky.
+ */
+static void BM_HashThroughput(benchmark::State& state, hash_map_hash_function_t hash)
+{
+    std::vector<std::string> keys = randomKeys(1024, (size_t)state.range(0));
+    size_t i = 0;
+    for (auto _ : state)
+    {
+        const std::string& key = keys[i++ & 1023];
+        benchmark::DoNotOptimize(hash(key.data(), key.size()));
+    }
+    state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+
+/**
+ * @brief Mira kolizi nad klici podobnymi identifikatorum.
+ *
+ * hash_collisions je podil klicu, ktere sdili cely has s jinym klicem,
+ * slot_collisions podil klicu, jejichz vychozi pozici v indexu velikosti
+ * 2^k >= 2n uz obsadil jiny klic.
+ */
+static void BM_HashCollisions(benchmark::State& state, hash_map_hash_function_t hash)
+{
+    size_t n = (size_t)state.range(0);
+    std::vector<std::string> keys = identifierKeys(n);
+    size_t slots = 1;
+    while (slots < 2 * n)
+    {
+        slots <<= 1;
+    }
+    size_t hashCollisions = 0, slotCollisions = 0;
+    for (auto _ : state)
+    {
+        std::unordered_set<size_t> hashes, used;
+        hashCollisions = slotCollisions = 0;
+        for (auto& key : keys)
+        {
+            size_t h = hash(key.data(), key.size());
+            hashCollisions += !hashes.insert(h).second;
+            slotCollisions += !used.insert(h & (slots - 1)).second;
+        }
+    }
+    state.counters["hash_collisions"] = (double)hashCollisions / (double)n;
+    state.counters["slot_collisions"] = (double)slotCollisions / (double)n;
+}
+
+/**
+ * @brief Vlozeni a vyhledani identifikatoru v tabulce s danou hasovaci funkci.
+ */
+static void BM_MapPutGet(benchmark::State& state, hash_map_hash_function_t hash)
+{
+    std::vector<std::string> keys = identifierKeys((size_t)state.range(0));
+    int value;
+    for (auto _ : state)
+    {
+        hash_map_t* map = hash_map_ctor();
+        hash_map_set_hash_function(map, hash);
+        fill(map, keys);
+        for (auto& key : keys)
+        {
+            hash_map_get(map, key.c_str(), &value);
+        }
+        hash_map_dtor(map);
+    }
+    state.SetItemsProcessed(state.iterations() * (int64_t)keys.size() * 2);
+}
+
+//============================================================================//
+// Politika velikosti indexu
+//============================================================================//
+
+/**
+ * @brief Latence uspesneho vyhledani v tabulce s n klici.
+ *
+ * Index ma bud velikost mocniny dvou (maska), nebo o jednu vetsi
+ * (zobrazeni nasobenim a linearni prochazeni). Zaplneni je v obou pripadech
+ * stejne.
+ */
+static void BM_LookupLatency(benchmark::State& state, hash_map_capacity_policy_t policy)
+{
+    size_t n = (size_t)state.range(0);
+    std::vector<std::string> keys = randomKeys(n, 16);
+    hash_map_t* map = hash_map_ctor();
+    size_t size = 2;
+    while (size < 2 * n)
+    {
+        size <<= 1;
+    }
+    hash_map_set_capacity_policy(map, policy);
+    hash_map_reserve(map, policy == HASH_MAP_CAPACITY_POWER_OF_TWO ? size : size + 1);
+    fill(map, keys);
+    std::mt19937 rng(BENCH_SEED);
+    int value;
+    for (auto _ : state)
+    {
+        const std::string& key = keys[rng() % n];
+        benchmark::DoNotOptimize(hash_map_get(map, key.c_str(), &value));
+    }
+    state.counters["capacity"] = (double)hash_map_capacity(map);
+    hash_map_dtor(map);
+}
+
+/**
+ * @brief Latence neuspesneho vyhledani pri zaplneni tesne pod prahem
+ *        realokace.
+ *
+ * Hledane klice maji jinou delku nez ulozene, takze kazda shoda otisku je
+ * falesna. miss_ratio urcuje podil chybejicich klicu v dotazech.
+ */
+static void BM_MissLookup(benchmark::State& state)
+{
+    size_t n = (size_t)state.range(0);
+    size_t missPercent = (size_t)state.range(1);
+    std::vector<std::string> keys = randomKeys(n, 16);
+    std::vector<std::string> absent = randomKeys(n, 15);
+    hash_map_t* map = hash_map_ctor();
+    hash_map_set_capacity_policy(map, HASH_MAP_CAPACITY_POWER_OF_TWO);
+    size_t size = 2;
+    while ((float)n / (float)size >= HASH_MAP_REALLOCATION_THRESHOLD)
+    {
+        size <<= 1;
+    }
+    hash_map_reserve(map, size);
+    fill(map, keys);
+    std::mt19937 rng(BENCH_SEED);
+    int value;
+    for (auto _ : state)
+    {
+        size_t r = rng();
+        const std::string& key = (r % 100 < missPercent ? absent : keys)[(r >> 8) % n];
+        benchmark::DoNotOptimize(hash_map_get(map, key.c_str(), &value));
+    }
+    state.counters["load"] = (double)n / (double)hash_map_capacity(map);
+    hash_map_dtor(map);
+}
+
+//============================================================================//
+// Engine tabulky
+//============================================================================//
+
+/**
+ * @brief Latence vyhledani v indexu 2^k mist zaplnenem na load procent.
+ *
+ * Engine po jednom miste se zvetsuje uz pri zaplneni 3/5, vyssi zaplneni
+ * meri jen engine skupin (do 7/8) a Robin Hood (do 9/10). Polovina dotazu 
+ * hleda chybejici klic.
+ */
+static void BM_EngineLookup(benchmark::State& state, hash_map_engine_t engine)
+{
+    size_t size = (size_t)1 << state.range(0);
+    size_t load = (size_t)state.range(1);
+    hash_map_t* map = hash_map_ctor();
+    hash_map_set_engine(map, engine);
+    hash_map_set_capacity_policy(map, HASH_MAP_CAPACITY_POWER_OF_TWO);
+    hash_map_reserve(map, size);
+    size_t n = size * load / 100;
+    std::vector<std::string> keys = randomKeys(n, 16);
+    std::vector<std::string> absent = randomKeys(n, 15);
+    fill(map, keys);
+    if (hash_map_capacity(map) != size)
+    {
+        state.SkipWithError("zaplneni je nad mezi realokace");
+        hash_map_dtor(map);
+        return;
+    }
+    std::mt19937 rng(BENCH_SEED);
+    int value;
+    for (auto _ : state)
+    {
+        size_t r = rng();
+        const std::string& key = ((r & 1) ? absent : keys)[(r >> 1) % n];
+        benchmark::DoNotOptimize(hash_map_get(map, key.c_str(), &value));
+    }
+    hash_map_stats_t stats = hash_map_stats(map);
+    state.counters["load"] = (double)n / (double)size;
+    state.counters["hit_probe"] = stats.hit_probe_avg;
+    state.counters["miss_probe"] = stats.miss_probe_avg;
+}
+
+BENCHMARK_CAPTURE(BM_EngineLookup, probing, HASH_MAP_ENGINE_PROBING)->ArgsProduct({{12, 16, 20}, {50, 59}});
+BENCHMARK_CAPTURE(BM_EngineLookup, groups, HASH_MAP_ENGINE_GROUPS)->ArgsProduct({{12, 16, 20}, {50, 59, 75, 85}});
+BENCHMARK_CAPTURE(BM_EngineLookup, robin_hood, HASH_MAP_ENGINE_ROBIN_HOOD)->ArgsProduct({{12, 16, 20}, {50, 59, 75, 85, 89}});
+
+//============================================================================//
+// Odstranovani zaznamu
+//============================================================================//
+
+/**
+ * @brief Dlouhodoby beh s konstantnim poctem n zaznamu.
+ *
+ * Kazdy krok odstrani nejstarsi klic, vlozi novy a vyhleda nahodny klic
+ * z okna 2n klicu, polovina dotazu tedy hleda odstraneny klic. Pocet kroku
+ * je 64n, takze kazdy klic projde tabulkou mnohokrat.
+ */
+static void BM_Churn(benchmark::State& state)
+{
+    size_t n = (size_t)state.range(0);
+    size_t window = 2 * n;
+    std::vector<std::string> keys = randomKeys(window, 16);
+    std::mt19937 rng(BENCH_SEED);
+    int value;
+    for (auto _ : state)
+    {
+        hash_map_t* map = hash_map_ctor();
+        for (size_t i = 0; i < n; i++)
+        {
+            hash_map_put(map, keys[i].c_str(), (int)i);
+        }
+        for (size_t i = n; i < 64 * n; i++)
+        {
+            hash_map_remove(map, keys[(i - n) % window].c_str());
+            hash_map_put(map, keys[i % window].c_str(), (int)i);
+            benchmark::DoNotOptimize(hash_map_get(map, keys[(i + window - rng() % window) % window].c_str(), &value));
+        }
+        state.counters["capacity"] = (double)hash_map_capacity(map);
+        hash_map_dtor(map);
+    }
+    state.SetItemsProcessed(state.iterations() * (int64_t)(63 * n));
+}
+
+BENCHMARK(BM_Churn)->RangeMultiplier(16)->Range(1 << 8, 1 << 16)->Unit(benchmark::kMillisecond);
+
+//============================================================================//
+// Rozlozeni zaznamu
+//============================================================================//
+
+/**
+ * @brief Tabulka s n klici v danem rozlozeni.
+ */
+static hash_map_t* layoutMap(hash_map_layout_t layout, const std::vector<std::string>& keys)
+{
+    hash_map_t* map = hash_map_ctor();
+    hash_map_set_layout(map, layout);
+    fill(map, keys);
+    return map;
+}
+
+/**
+ * @brief Pamet tabulky na jeden zaznam bez samotnych klicu (vcetne rezie
+ *        alokatoru).
+ */
+static void BM_LayoutMemory(benchmark::State& state, hash_map_layout_t layout)
+{
+    std::vector<std::string> keys = randomKeys((size_t)state.range(0), 16);
+    size_t bytes = 0;
+    for (auto _ : state)
+    {
+        size_t before = heapInUse();
+        hash_map_t* map = layoutMap(layout, keys);
+        bytes = heapInUse() - before;
+        hash_map_dtor(map);
+    }
+    // klice (17 bajtu + rezie) maji v obou rozlozenich stejnou cenu
+    size_t keyBytes = 0;
+    {
+        size_t before = heapInUse();
+        std::vector<char*> copies;
+        copies.reserve(keys.size());
+        size_t reserved = heapInUse() - before;
+        for (auto& key : keys)
+        {
+            copies.push_back(strdup(key.c_str()));
+        }
+        keyBytes = heapInUse() - before - reserved;
+        for (char* copy : copies)
+        {
+            free(copy);
+        }
+    }
+    state.counters["bytes_per_entry"] = (double)(bytes - keyBytes) / (double)keys.size();
+}
+
+/**
+ * @brief Pruchod vsech zaznamu od first po last.
+ */
+static void BM_LayoutIterate(benchmark::State& state, hash_map_layout_t layout)
+{
+    std::vector<std::string> keys = randomKeys((size_t)state.range(0), 16);
+    hash_map_t* map = layoutMap(layout, keys);
+    for (auto _ : state)
+    {
+        long sum = 0;
+        for (hash_map_item_t* item = map->first; item != NULL; item = item->next)
+        {
+            sum += item->value;
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * (int64_t)keys.size());
+    hash_map_dtor(map);
+}
+
+/**
+ * @brief Uspesne vyhledani nahodneho klice.
+ */
+static void BM_LayoutLookup(benchmark::State& state, hash_map_layout_t layout)
+{
+    size_t n = (size_t)state.range(0);
+    std::vector<std::string> keys = randomKeys(n, 16);
+    hash_map_t* map = layoutMap(layout, keys);
+    std::mt19937 rng(BENCH_SEED);
+    int value;
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(hash_map_get(map, keys[rng() % n].c_str(), &value));
+    }
+    hash_map_dtor(map);
+}
+
+BENCHMARK_CAPTURE(BM_LayoutMemory, linked, HASH_MAP_LAYOUT_LINKED)->Arg(100)->Arg(10000)->Arg(1000000)->Iterations(1);
+BENCHMARK_CAPTURE(BM_LayoutMemory, compact, HASH_MAP_LAYOUT_COMPACT)->Arg(100)->Arg(10000)->Arg(1000000)->Iterations(1);
+BENCHMARK_CAPTURE(BM_LayoutIterate, linked, HASH_MAP_LAYOUT_LINKED)->RangeMultiplier(16)->Range(1 << 12, 1 << 20);
+BENCHMARK_CAPTURE(BM_LayoutIterate, compact, HASH_MAP_LAYOUT_COMPACT)->RangeMultiplier(16)->Range(1 << 12, 1 << 20);
+BENCHMARK_CAPTURE(BM_LayoutLookup, linked, HASH_MAP_LAYOUT_LINKED)->RangeMultiplier(16)->Range(1 << 12, 1 << 20);
+BENCHMARK_CAPTURE(BM_LayoutLookup, compact, HASH_MAP_LAYOUT_COMPACT)->RangeMultiplier(16)->Range(1 << 12, 1 << 20);
+
+//============================================================================//
+// Delka klicu
+//============================================================================//
+
+/**
+ * @brief Vlozeni, vyhledani a odstraneni n klicu dane delky.
+ */
+static void BM_KeyLength(benchmark::State& state)
+{
+    size_t n = (size_t)state.range(1);
+    std::vector<std::string> keys = randomKeys(n, (size_t)state.range(0));
+    int value;
+    for (auto _ : state)
+    {
+        hash_map_t* map = hash_map_ctor();
+        fill(map, keys);
+        for (auto& key : keys)
+        {
+            hash_map_get(map, key.c_str(), &value);
+        }
+        for (auto& key : keys)
+        {
+            hash_map_remove(map, key.c_str());
+        }
+        hash_map_dtor(map);
+    }
+    state.SetItemsProcessed(state.iterations() * (int64_t)n * 3);
+}
+
+BENCHMARK(BM_KeyLength)->ArgsProduct({{8, 16, 23, 24, 40}, {1 << 10, 1 << 16}});
+
+//============================================================================//
+// Alokator
+//============================================================================//
+
+/**
+ * @brief Propustnost dvojic put/pop pri konstantnim poctu n zaznamu a RSS
+ *        procesu pred a po 32n krocich.
+ *
+ * Delka klicu 16 se vejde do zaznamu, delka 40 jde do areny klicu.
+ */
+static void BM_AllocatorChurn(benchmark::State& state)
+{
+    size_t length = (size_t)state.range(0);
+    size_t n = (size_t)state.range(1);
+    std::vector<std::string> keys = randomKeys(2 * n, length);
+    size_t rssBefore = 0, rssAfter = 0;
+    for (auto _ : state)
+    {
+        hash_map_t* map = hash_map_ctor();
+        for (size_t i = 0; i < n; i++)
+        {
+            hash_map_put(map, keys[i].c_str(), (int)i);
+        }
+        rssBefore = residentBytes();
+        for (size_t i = n; i < 33 * n; i++)
+        {
+            hash_map_remove(map, keys[(i - n) % (2 * n)].c_str());
+            hash_map_put(map, keys[i % (2 * n)].c_str(), (int)i);
+        }
+        rssAfter = residentBytes();
+        hash_map_dtor(map);
+    }
+    state.SetItemsProcessed(state.iterations() * (int64_t)(32 * n));
+    state.counters["rss_growth_kb"] = ((double)rssAfter - (double)rssBefore) / 1024.0;
+}
+
+/**
+ * @brief Cena hash_map_clear pro tabulku s n zaznamy.
+ */
+static void BM_Clear(benchmark::State& state)
+{
+    size_t n = (size_t)state.range(1);
+    std::vector<std::string> keys = randomKeys(n, (size_t)state.range(0));
+    hash_map_t* map = hash_map_ctor();
+    for (auto _ : state)
+    {
+        state.PauseTiming();
+        fill(map, keys);
+        state.ResumeTiming();
+        hash_map_clear(map);
+    }
+    hash_map_dtor(map);
+}
+
+BENCHMARK(BM_AllocatorChurn)->ArgsProduct({{16, 40}, {1 << 12, 1 << 18}})->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_Clear)->ArgsProduct({{16, 40}, {1 << 12, 1 << 18}})->Iterations(20)->Unit(benchmark::kMicrosecond);
+
+/**
+ * @brief Vyhledani klicu, ktere lezi za sebou v jednom bufferu (jako pri
+ *        cteni ze site).
+ *
+ * Varianta copy klic nejdrive zkopiruje do retezce ukonceneho nulou a vola
+ * hash_map_get, varianta slice vola primo hash_map_get_n.
+ */
+static void BM_GetSlice(benchmark::State& state, bool slice)
+{
+    size_t n = (size_t)state.range(0);
+    std::vector<std::string> keys = identifierKeys(n);
+    hash_map_t* map = hash_map_ctor();
+    fill(map, keys);
+    std::string buffer;
+    std::vector<std::pair<size_t, size_t>> slices;
+    for (auto& key : keys)
+    {
+        slices.emplace_back(buffer.size(), key.size());
+        buffer += key;
+    }
+    std::string copy;
+    int value;
+    size_t i = 0;
+    for (auto _ : state)
+    {
+        const std::pair<size_t, size_t>& s = slices[i++ % n];
+        if (slice)
+        {
+            benchmark::DoNotOptimize(hash_map_get_n(map, buffer.data() + s.first, s.second, &value));
+        }
+        else
+        {
+            copy.assign(buffer, s.first, s.second);
+            benchmark::DoNotOptimize(hash_map_get(map, copy.c_str(), &value));
+        }
+    }
+    hash_map_dtor(map);
+}
+
+BENCHMARK_CAPTURE(BM_GetSlice, copy, false)->Arg(1 << 10)->Arg(1 << 16);
+BENCHMARK_CAPTURE(BM_GetSlice, slice, true)->Arg(1 << 10)->Arg(1 << 16);
+
+//============================================================================//
+// Pocitani vyskytu
+//============================================================================//
+
+/** Zpusob zvyseni citace v BM_Count. */
+enum class CountMethod { GetPut, GetOrInsert, Add };
+
+/**
+ * @brief Pocitani vyskytu klicu z Zipfova rozdeleni nad n ruznymi klici.
+ */
+static void BM_Count(benchmark::State& state, CountMethod method)
+{
+    size_t n = (size_t)state.range(0);
+    std::vector<std::string> keys = identifierKeys(n);
+    // priblizne Zipfovo rozdeleni: index i s pravdepodobnosti umernou 1/(i+1)
+    std::mt19937 rng(BENCH_SEED);
+    std::vector<uint32_t> events(1 << 16);
+    for (auto& e : events)
+    {
+        double u = std::uniform_real_distribution<double>(0.0, 1.0)(rng);
+        e = (uint32_t)std::min(n - 1, (size_t)std::exp(u * std::log((double)n)));
+    }
+    hash_map_t* map = hash_map_ctor();
+    size_t i = 0;
+    for (auto _ : state)
+    {
+        const char* key = keys[events[i++ & 0xFFFF]].c_str();
+        int value, *slot;
+        switch (method)
+        {
+            case CountMethod::GetPut:
+                value = 0;
+                hash_map_get(map, key, &value);
+                hash_map_put(map, key, value + 1);
+                break;
+            case CountMethod::GetOrInsert:
+                hash_map_get_or_insert(map, key, &slot);
+                ++*slot;
+                break;
+            case CountMethod::Add:
+                hash_map_add(map, key, 1);
+                break;
+        }
+    }
+    hash_map_dtor(map);
+}
+
+BENCHMARK_CAPTURE(BM_Count, get_put, CountMethod::GetPut)->Arg(1 << 10)->Arg(1 << 20);
+BENCHMARK_CAPTURE(BM_Count, get_or_insert, CountMethod::GetOrInsert)->Arg(1 << 10)->Arg(1 << 20);
+BENCHMARK_CAPTURE(BM_Count, add, CountMethod::Add)->Arg(1 << 10)->Arg(1 << 20);
+
+//============================================================================//
+// Davkove vyhledavani
+//============================================================================//
+
+/**
+ * @brief Vyhledani 256 nahodnych klicu po jednom (batch == false) nebo 
+ *        pres hash_map_get_many (batch == true) v tabulce s n klici.
+ *
+ * Pri velikosti tabulky nad kapacitu cache je vyhledani omezeno latenci 
+ * pameti, kterou davka prekryva.
+ */
+static void BM_GetMany(benchmark::State& state, bool batch)
+{
+    size_t n = (size_t)state.range(0);
+    std::vector<std::string> keys = randomKeys(n, 16);
+    hash_map_t* map = hash_map_ctor();
+    hash_map_reserve(map, n);
+    fill(map, keys);
+
+    const size_t BATCH = 256;
+    std::mt19937 rng(BENCH_SEED + 1);
+    std::uniform_int_distribution<size_t> pick(0, n - 1);
+    std::vector<const char*> order(1 << 20);
+    for (auto& key : order)
+    {
+        key = keys[pick(rng)].c_str();
+    }
+    std::vector<int> values(BATCH);
+    size_t i = 0;
+    for (auto _ : state)
+    {
+        const char* const* chunk = order.data() + (i & 0xFFFFF);
+        i += BATCH;
+        if (batch)
+        {
+            benchmark::DoNotOptimize(hash_map_get_many(map, BATCH, chunk, values.data(), NULL));
+        }
+        else
+        {
+            for (size_t j = 0; j < BATCH; j++)
+            {
+                benchmark::DoNotOptimize(hash_map_get(map, chunk[j], &values[j]));
+            }
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * BATCH);
+    hash_map_dtor(map);
+}
+
+BENCHMARK_CAPTURE(BM_GetMany, single, false)->Arg(1 << 16)->Arg(1 << 20)->Arg(1 << 23);
+BENCHMARK_CAPTURE(BM_GetMany, batch, true)->Arg(1 << 16)->Arg(1 << 20)->Arg(1 << 23);
+
+//============================================================================//
+// Hodnoty libovolneho typu
+//============================================================================//
+
+/** Hodnota o velikosti jedne cache line. */
+struct Payload
+{
+    uint64_t fields[8];
+};
+
+/** Zpusob ulozeni hodnoty v BM_ValueLookup. */
+enum class ValueStorage { SideArray, Inline };
+
+/**
+ * @brief Vyhledani nahodneho klice a secteni jeho 64B hodnoty v tabulce s n 
+ *        klici.
+ *
+ * SideArray uklada do tabulky index do pole hodnot (puvodni reseni s 
+ * hodnotou int), Inline uklada hodnotu primo za zaznam 
+ * (hash_map_set_value_size), odpada tedy jedno cteni z pameti.
+ */
+static void BM_ValueLookup(benchmark::State& state, ValueStorage storage)
+{
+    size_t n = (size_t)state.range(0);
+    std::vector<std::string> keys = randomKeys(n, 16);
+    std::vector<Payload> side(storage == ValueStorage::SideArray ? n : 0);
+    hash_map_t* map = hash_map_ctor();
+    if (storage == ValueStorage::Inline)
+    {
+        hash_map_set_value_size(map, sizeof(Payload));
+    }
+    hash_map_reserve(map, n);
+    for (size_t i = 0; i < n; i++)
+    {
+        Payload payload = {{i, i, i, i, i, i, i, i}};
+        if (storage == ValueStorage::Inline)
+        {
+            hash_map_put_value(map, keys[i].c_str(), &payload);
+        }
+        else
+        {
+            side[i] = payload;
+            hash_map_put(map, keys[i].c_str(), (int)i);
+        }
+    }
+    // pole hodnot je vyplnene v poradi vlozeni, dotazy jsou v nahodnem
+    std::mt19937 rng(BENCH_SEED);
+    uint64_t sum = 0;
+    for (auto _ : state)
+    {
+        const char* key = keys[rng() % n].c_str();
+        const Payload* payload;
+        if (storage == ValueStorage::Inline)
+        {
+            void* stored;
+            hash_map_get_value_ptr(map, key, &stored);
+            payload = (const Payload*)stored;
+        }
+        else
+        {
+            int index;
+            hash_map_get(map, key, &index);
+            payload = &side[index];
+        }
+        for (uint64_t field : payload->fields)
+        {
+            sum += field;
+        }
+    }
+    benchmark::DoNotOptimize(sum);
+    hash_map_dtor(map);
+}
+
+BENCHMARK_CAPTURE(BM_ValueLookup, side_array, ValueStorage::SideArray)->Arg(1 << 12)->Arg(1 << 16)->Arg(1 << 20);
+BENCHMARK_CAPTURE(BM_ValueLookup, inline, ValueStorage::Inline)->Arg(1 << 12)->Arg(1 << 16)->Arg(1 << 20);
+
+//============================================================================//
+// Zmrazena tabulka
+//============================================================================//
+
+/**
+ * @brief Vyhledani nahodneho existujiciho klice v tabulce s n klici a pamet 
+ *        tabulky na klic (vcetne klicu a rezie alokatoru).
+ *
+ * Mutable je bezna tabulka (engine skupin), Frozen tataz tabulka po 
+ * hash_map_freeze s jedinym porovnanim klice na dotaz.
+ */
+static void BM_FrozenLookup(benchmark::State& state, bool frozen)
+{
+    size_t n = (size_t)state.range(0);
+    std::vector<std::string> keys = randomKeys(n, 16);
+    size_t before = heapInUse();
+    hash_map_t* map = hash_map_ctor();
+    hash_map_set_engine(map, HASH_MAP_ENGINE_GROUPS);
+    fill(map, keys);
+    hash_map_frozen_t* table = NULL;
+    if (frozen)
+    {
+        hash_map_freeze(map, &table);
+        hash_map_dtor(map);
+        map = NULL;
+    }
+    state.counters["bytes_per_key"] = (double)(heapInUse() - before) / (double)n;
+
+    std::mt19937 rng(BENCH_SEED);
+    int sum = 0;
+    for (auto _ : state)
+    {
+        const std::string& key = keys[rng() % n];
+        int value = 0;
+        if (frozen)
+        {
+            hash_map_frozen_get_n(table, key.data(), key.size(), &value);
+        }
+        else
+        {
+            hash_map_get_n(map, key.data(), key.size(), &value);
+        }
+        sum += value;
+    }
+    benchmark::DoNotOptimize(sum);
+    if (frozen)
+    {
+        hash_map_frozen_dtor(table);
+    }
+    else
+    {
+        hash_map_dtor(map);
+    }
+}
+
+BENCHMARK_CAPTURE(BM_FrozenLookup, mutable, false)->Arg(1 << 12)->Arg(1 << 16)->Arg(1 << 20);
+BENCHMARK_CAPTURE(BM_FrozenLookup, frozen, true)->Arg(1 << 12)->Arg(1 << 16)->Arg(1 << 20);
+
+/** Zpusob otevreni tabulky v BM_OpenMap. */
+enum class OpenMethod { Rebuild, Load };
+
+/**
+ * @brief Otevreni tabulky s n klici a prvni dotaz.
+ *
+ * Rebuild tabulku znovu sestavi volanim hash_map_put, Load namapuje soubor 
+ * ulozeny funkci hash_map_save (hash_map_frozen_load).
+ */
+static void BM_OpenMap(benchmark::State& state, OpenMethod method)
+{
+    size_t n = (size_t)state.range(0);
+    std::vector<std::string> keys = randomKeys(n, 16);
+    const char* path = "/tmp/hash_map_bench_open.bin";
+    if (method == OpenMethod::Load)
+    {
+        hash_map_t* map = hash_map_ctor();
+        fill(map, keys);
+        hash_map_save(map, path);
+        hash_map_dtor(map);
+    }
+    int value = 0;
+    for (auto _ : state)
+    {
+        if (method == OpenMethod::Rebuild)
+        {
+            hash_map_t* map = hash_map_ctor();
+            fill(map, keys);
+            hash_map_get(map, keys[n / 2].c_str(), &value);
+            hash_map_dtor(map);
+        }
+        else
+        {
+            hash_map_frozen_t* frozen;
+            hash_map_frozen_load(path, &frozen);
+            hash_map_frozen_get(frozen, keys[n / 2].c_str(), &value);
+            hash_map_frozen_dtor(frozen);
+        }
+        benchmark::DoNotOptimize(value);
+    }
+    if (method == OpenMethod::Load)
+    {
+        remove(path);
+    }
+}
+
+BENCHMARK_CAPTURE(BM_OpenMap, rebuild, OpenMethod::Rebuild)->Arg(1 << 16)->Arg(1 << 20)->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_OpenMap, load, OpenMethod::Load)->Arg(1 << 16)->Arg(1 << 20)->Unit(benchmark::kMillisecond);
+
+//============================================================================//
+// Rezim cache
+//============================================================================//
+
+/** Implementace LRU cache v BM_LruCache. */
+enum class LruImpl { StdList, HashMap };
+
+/**
+ * @brief LRU cache nad std::list a std::unordered_map (puvodni reseni).
+ */
+struct StdLru
+{
+    size_t limit;
+    std::list<std::pair<std::string, int>> order;
+    std::unordered_map<std::string, std::list<std::pair<std::string, int>>::iterator> index;
+
+    bool get(const std::string& key, int* value)
+    {
+        auto found = index.find(key);
+        if (found == index.end())
+        {
+            return false;
+        }
+        order.splice(order.end(), order, found->second);
+        *value = found->second->second;
+        return true;
+    }
+
+    void put(const std::string& key, int value)
+    {
+        order.emplace_back(key, value);
+        index.emplace(key, std::prev(order.end()));
+        if (order.size() > limit)
+        {
+            index.erase(order.front().first);
+            order.pop_front();
+        }
+    }
+};
+
+/**
+ * @brief Dotaz do LRU cache s n/4 zaznamy nad n klici (pri neuspechu se 
+ *        klic vlozi) a pamet na zaznam vcetne klicu.
+ *
+ * Klice se vybiraji s rozdelenim, kde polovinu dotazu tvori ctvrtina 
+ * klicu; cache s limitem n/4 ma uspesnost kolem 37 % (citac hit_rate).
+ */
+static void BM_LruCache(benchmark::State& state, LruImpl impl)
+{
+    size_t n = (size_t)state.range(0);
+    size_t limit = n / 4;
+    std::vector<std::string> keys = randomKeys(n, 16);
+    std::mt19937 rng(BENCH_SEED);
+    std::vector<uint32_t> queries(n);
+    for (uint32_t& query : queries)
+    {
+        // kvadrat rovnomerneho rozdeleni zvyhodnuje klice s nizkym indexem
+        double u = std::uniform_real_distribution<double>(0.0, 1.0)(rng);
+        query = (uint32_t)(u * u * (double)n);
+    }
+
+    size_t before = heapInUse();
+    StdLru lru{limit, {}, {}};
+    hash_map_t* map = NULL;
+    if (impl == LruImpl::HashMap)
+    {
+        map = hash_map_ctor();
+        hash_map_set_cache_limit(map, limit);
+    }
+    auto access = [&](const std::string& key, int i) {
+        int value;
+        if (impl == LruImpl::HashMap)
+        {
+            if (hash_map_get_n(map, key.data(), key.size(), &value) != OK)
+            {
+                hash_map_put_n(map, key.data(), key.size(), i);
+            }
+        }
+        else if (!lru.get(key, &value))
+        {
+            lru.put(key, i);
+        }
+    };
+    // zaplneni cache pred merenim
+    for (size_t i = 0; i < n; i++)
+    {
+        access(keys[i], (int)i);
+    }
+    state.counters["bytes_per_entry"] = (double)(heapInUse() - before) / (double)limit;
+    hash_map_cache_stats_t warm = {0, 0, 0};
+    if (impl == LruImpl::HashMap)
+    {
+        warm = hash_map_cache_stats(map);
+    }
+
+    size_t i = 0;
+    for (auto _ : state)
+    {
+        access(keys[queries[i & (queries.size() - 1)]], (int)i);
+        i++;
+    }
+    if (impl == LruImpl::HashMap)
+    {
+        hash_map_cache_stats_t stats = hash_map_cache_stats(map);
+        state.counters["hit_rate"] = (double)(stats.hits - warm.hits) / 
+                                     (double)(stats.hits + stats.misses - warm.hits - warm.misses);
+        hash_map_dtor(map);
+    }
+}
+
+BENCHMARK_CAPTURE(BM_LruCache, std_list, LruImpl::StdList)->Arg(1 << 16)->Arg(1 << 20);
+BENCHMARK_CAPTURE(BM_LruCache, hash_map, LruImpl::HashMap)->Arg(1 << 16)->Arg(1 << 20);
+
+//============================================================================//
+// Statistiky
+//============================================================================//
+
+/**
+ * @brief Cena volani hash_map_stats pro tabulku s n klici.
+ */
+static void BM_Stats(benchmark::State& state)
+{
+    size_t n = (size_t)state.range(0);
+    std::vector<std::string> keys = randomKeys(n, 16);
+    hash_map_t* map = hash_map_ctor();
+    fill(map, keys);
+    hash_map_stats_t stats;
+    for (auto _ : state)
+    {
+        stats = hash_map_stats(map);
+        benchmark::DoNotOptimize(stats);
+    }
+    state.counters["hit_probe"] = stats.hit_probe_avg;
+    state.counters["miss_probe"] = stats.miss_probe_avg;
+    state.counters["bytes_per_entry"] = (double)stats.bytes / (double)n;
+    hash_map_dtor(map);
+}
+
+BENCHMARK(BM_Stats)->Arg(1 << 16)->Arg(1 << 20)->Unit(benchmark::kMillisecond);
+
+//============================================================================//
+// Latence vkladani behem zvetsovani indexu
+//============================================================================//
+
+/**
+ * @brief Vlozeni n klicu do prazdne tabulky, meri se doba kazdeho vlozeni.
+ *
+ * Citace p50/p99/p999/max (ns) ukazuji, kolik stoji vlozeni, ktere index 
+ * zvetsi (HASH_MAP_RESIZE_BLOCKING), proti postupnemu presunu zaznamu 
+ * (HASH_MAP_RESIZE_INCREMENTAL).
+ */
+static void BM_GrowthLatency(benchmark::State& state, hash_map_resize_policy_t policy)
+{
+    size_t n = (size_t)state.range(0);
+    std::vector<std::string> keys = randomKeys(n, 16);
+    std::vector<uint64_t> latency(n);
+    for (auto _ : state)
+    {
+        hash_map_t* map = hash_map_ctor();
+        hash_map_set_resize_policy(map, policy);
+        for (size_t i = 0; i < n; i++)
+        {
+            auto start = std::chrono::steady_clock::now();
+            hash_map_put(map, keys[i].c_str(), (int)i);
+            auto end = std::chrono::steady_clock::now();
+            latency[i] = (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+        }
+        state.PauseTiming();
+        hash_map_dtor(map);
+        state.ResumeTiming();
+    }
+    std::sort(latency.begin(), latency.end());
+    state.counters["p50_ns"] = (double)latency[n / 2];
+    state.counters["p99_ns"] = (double)latency[n - n / 100];
+    state.counters["p999_ns"] = (double)latency[n - n / 1000];
+    state.counters["max_ns"] = (double)latency[n - 1];
+    state.SetItemsProcessed(state.iterations() * n);
+}
+
+BENCHMARK_CAPTURE(BM_GrowthLatency, blocking, HASH_MAP_RESIZE_BLOCKING)
+    ->Arg(1 << 16)->Arg(1 << 20)->Arg(1 << 22)->Iterations(3)->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_GrowthLatency, incremental, HASH_MAP_RESIZE_INCREMENTAL)
+    ->Arg(1 << 16)->Arg(1 << 20)->Arg(1 << 22)->Iterations(3)->Unit(benchmark::kMillisecond);
+
+//============================================================================//
+// Soubezny pristup
+//============================================================================//
+
+/** Zpusob synchronizace v BM_ConcurrentMixed. */
+enum class SyncMethod { GlobalMutex, Sharded, SharedReads };
+
+static std::vector<std::string> concurrentKeys;
+static hash_map_t* globalMap;
+static pthread_mutex_t globalLock = PTHREAD_MUTEX_INITIALIZER;
+static hash_map_concurrent_t* shardedMap;
+
+/**
+ * @brief Smes cteni a zapisu (state.range(0) procent cteni) nad 64 Ki 
+ *        klici z vice vlaken.
+ *
+ * GlobalMutex je puvodni tabulka obalena jednim zamkem, Sharded je 
+ * hash_map_concurrent_t s optimistickym ctenim, SharedReads je puvodni 
+ * tabulka ve sdilenem rezimu cteni (cte se bez zamku, zamyka se jen zapis).
+ */
+static void BM_ConcurrentMixed(benchmark::State& state, SyncMethod method)
+{
+    const size_t n = 1 << 16;
+    if (state.thread_index() == 0)
+    {
+        concurrentKeys = identifierKeys(n);
+        if (method != SyncMethod::Sharded)
+        {
+            globalMap = hash_map_ctor();
+            fill(globalMap, concurrentKeys);
+            if (method == SyncMethod::SharedReads)
+            {
+                hash_map_set_read_policy(globalMap, HASH_MAP_READ_SHARED);
+            }
+        }
+        else
+        {
+            shardedMap = hash_map_concurrent_ctor(0);
+            for (size_t i = 0; i < n; i++)
+            {
+                hash_map_concurrent_put(shardedMap, concurrentKeys[i].c_str(), (int)i);
+            }
+        }
+    }
+    std::mt19937 rng(BENCH_SEED + state.thread_index());
+    unsigned reads = (unsigned)state.range(0);
+    int value;
+    for (auto _ : state)
+    {
+        uint32_t r = rng();
+        const char* key = concurrentKeys[r & (n - 1)].c_str();
+        bool read = (r >> 16) % 100 < reads;
+        if (method == SyncMethod::GlobalMutex)
+        {
+            pthread_mutex_lock(&globalLock);
+            if (read)
+            {
+                benchmark::DoNotOptimize(hash_map_get(globalMap, key, &value));
+            }
+            else
+            {
+                hash_map_put(globalMap, key, (int)r);
+            }
+            pthread_mutex_unlock(&globalLock);
+        }
+        else if (method == SyncMethod::SharedReads)
+        {
+            if (read)
+            {
+                benchmark::DoNotOptimize(hash_map_get(globalMap, key, &value));
+            }
+            else
+            {
+                pthread_mutex_lock(&globalLock);
+                hash_map_put(globalMap, key, (int)r);
+                pthread_mutex_unlock(&globalLock);
+            }
+        }
+        else if (read)
+        {
+            benchmark::DoNotOptimize(hash_map_concurrent_get(shardedMap, key, &value));
+        }
+        else
+        {
+            hash_map_concurrent_put(shardedMap, key, (int)r);
+        }
+    }
+    state.SetItemsProcessed(state.iterations());
+    if (state.thread_index() == 0)
+    {
+        if (method != SyncMethod::Sharded)
+        {
+            hash_map_dtor(globalMap);
+        }
+        else
+        {
+            hash_map_concurrent_dtor(shardedMap);
+        }
+    }
+}
+
+BENCHMARK_CAPTURE(BM_ConcurrentMixed, global_mutex, SyncMethod::GlobalMutex)
+    ->Arg(100)->Arg(90)->Arg(50)->ThreadRange(1, 8)->UseRealTime();
+BENCHMARK_CAPTURE(BM_ConcurrentMixed, sharded, SyncMethod::Sharded)
+    ->Arg(100)->Arg(90)->Arg(50)->ThreadRange(1, 8)->UseRealTime();
+BENCHMARK_CAPTURE(BM_ConcurrentMixed, shared_reads, SyncMethod::SharedReads)
+    ->Arg(100)->Arg(99)->Arg(90)->ThreadRange(1, 8)->UseRealTime();
+
+BENCHMARK(BM_MissLookup)->ArgsProduct({{1 << 12, 1 << 16, 1 << 20}, {50, 100}});
+BENCHMARK_CAPTURE(BM_LookupLatency, power_of_two, HASH_MAP_CAPACITY_POWER_OF_TWO)->RangeMultiplier(16)->Range(1 << 10, 1 << 22);
+BENCHMARK_CAPTURE(BM_LookupLatency, exact, HASH_MAP_CAPACITY_EXACT)->RangeMultiplier(16)->Range(1 << 10, 1 << 22);
+
+BENCHMARK_CAPTURE(BM_HashThroughput, default, hash_map_default_hash)->RangeMultiplier(4)->Range(4, 1024);
+BENCHMARK_CAPTURE(BM_HashThroughput, additive, hash_map_additive_hash)->RangeMultiplier(4)->Range(4, 1024);
+BENCHMARK_CAPTURE(BM_HashCollisions, default, hash_map_default_hash)->Arg(1 << 16)->Iterations(1);
+BENCHMARK_CAPTURE(BM_HashCollisions, additive, hash_map_additive_hash)->Arg(1 << 16)->Iterations(1);
+BENCHMARK_CAPTURE(BM_MapPutGet, default, hash_map_default_hash)->RangeMultiplier(8)->Range(1 << 10, 1 << 16);
+BENCHMARK_CAPTURE(BM_MapPutGet, additive, hash_map_additive_hash)->RangeMultiplier(8)->Range(1 << 10, 1 << 13);
+
+/*** Konec souboru white_box_bench.cpp ***/
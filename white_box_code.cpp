@@ -17,349 +17,3839 @@
 
 #include "white_box_code.h"
 #include <stdio.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
 
 /*******************************************************************************
  * Pomocné metody.
  ******************************************************************************/
+/** Konstanty míchání výchozí hašovací funkce. */
+static const uint64_t HASH_SECRET[4] = {
+    0xa0761d6478bd642fULL, 0xe7037ed1a0b428dbULL,
+    0x8ebc6af09c88c6e3ULL, 0x589965cc75374cc3ULL
+};
+
 /**
- * @brief Výpočet haše pro zadaný řetězec.
- *
- * @param[in] str klíč
- * @return hash 
+ * @brief Vynásobí dvě 64bitová čísla a vrátí xor horní a dolní poloviny 
+ *        128bitového součinu.
  */
-size_t hash_function(const char* str)
+static inline uint64_t hash_mix(uint64_t a, uint64_t b)
 {
-    size_t hash = 0;
+#if defined(__SIZEOF_INT128__)
+    unsigned __int128 r = (unsigned __int128)a * b;
+    return (uint64_t)r ^ (uint64_t)(r >> 64);
+#else
+    uint64_t ha = a >> 32, la = (uint32_t)a, hb = b >> 32, lb = (uint32_t)b;
+    uint64_t rh = ha * hb, rm0 = ha * lb, rm1 = hb * la, rl = la * lb;
+    uint64_t t = rl + (rm0 << 32);
+    uint64_t c = t < rl;
+    uint64_t lo = t + (rm1 << 32);
+    c += lo < t;
+    uint64_t hi = rh + (rm0 >> 32) + (rm1 >> 32) + c;
+    return lo ^ hi;
+#endif
+}
+
+/** @brief Načte 8 bajtů (little-endian) z libovolně zarovnané adresy. */
+static inline uint64_t hash_read64(const unsigned char* p)
+{
+    uint64_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
 
-    for (size_t idx = 0; str[idx] != '\0'; idx++)
+/** @brief Načte 4 bajty (little-endian) z libovolně zarovnané adresy. */
+static inline uint64_t hash_read32(const unsigned char* p)
+{
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+size_t hash_map_default_hash(const char* key, size_t length)
+{
+    const unsigned char* p = (const unsigned char*)key;
+    uint64_t seed = HASH_FUNCTION_SEED ^ hash_mix(HASH_FUNCTION_SEED ^ HASH_SECRET[0], HASH_SECRET[1]);
+    uint64_t a, b;
+
+    if (length <= 16)
+    {
+        if (length >= 4)
+        {
+            // prekryvajici se ctverice bajtu pokryji cely klic bez vetveni
+            size_t shift = (length >> 3) << 2;
+            a = (hash_read32(p) << 32) | hash_read32(p + shift);
+            b = (hash_read32(p + length - 4) << 32) | hash_read32(p + length - 4 - shift);
+        }
+        else if (length > 0)
+        {
+            a = ((uint64_t)p[0] << 16) | ((uint64_t)p[length >> 1] << 8) | p[length - 1];
+            b = 0;
+        }
+        else
+        {
+            a = b = 0;
+        }
+    }
+    else
     {
-        hash += HASH_FUNCTION_PARAM_A*str[idx] + HASH_FUNCTION_PARAM_B;
+        size_t i = length;
+        if (i > 48)
+        {
+            // tri nezavisle retezce michani pro vyuziti paralelismu procesoru
+            uint64_t see1 = seed, see2 = seed;
+            do
+            {
+                seed = hash_mix(hash_read64(p) ^ HASH_SECRET[1], hash_read64(p + 8) ^ seed);
+                see1 = hash_mix(hash_read64(p + 16) ^ HASH_SECRET[2], hash_read64(p + 24) ^ see1);
+                see2 = hash_mix(hash_read64(p + 32) ^ HASH_SECRET[3], hash_read64(p + 40) ^ see2);
+                p += 48;
+                i -= 48;
+            } while (i > 48);
+            seed ^= see1 ^ see2;
+        }
+        while (i > 16)
+        {
+            seed = hash_mix(hash_read64(p) ^ HASH_SECRET[1], hash_read64(p + 8) ^ seed);
+            i -= 16;
+            p += 16;
+        }
+        a = hash_read64(p + i - 16);
+        b = hash_read64(p + i - 8);
     }
 
-    return hash;
+    return (size_t)hash_mix(HASH_SECRET[1] ^ length, hash_mix(a ^ HASH_SECRET[1], b ^ seed));
 }
 
-/**
- * @brief Výpočet indexu v hašovací tabulce v závislosti na dvojici klíč-hash.
- * 
- * V případě kolize funkce nalezne další volný index v tabulce. V případě 
- * vyhledávání považujeme @c dummy objekt jako jakýkoliv jiný záznam, tedy
- * @p ignore_dummy je nastaveno na @c false . Při vkládání je @c dummy objekt 
- * ekvivalentní prázdnému místu, tedy @p ignore_dummy je nastaveno na @c true .
- * Tento jev je způsoben kvůli kolizím klíčů. Když je záznam odstraněn, je 
- * nahrazen za @c dummy objekt, aby bylo možné vyřešit případné kolize.
- *
- * @param[in] self         Ukazatel na strukturu hašovací tabulky.
- * @param[in] str          Klíč.
- * @param[in] str          Haš zadaného klíče.
- * @param[in] ignore_dummy Pokud @c true, @c dummy objekt je vždy přeskočen,
- *                         pokud @c false, @c dummy objekt je interpretován jako
- *                         @c NULL.
- * 
- * @return Index záznamu asociovaný k zadanému klíči a haši, nebo prázdné místo
- *         v tabulce.
- */
-size_t hash_map_lookup_handle(hash_map_t* self, const char* key, size_t hash, 
-                              bool ignore_dummy)
+size_t hash_map_additive_hash(const char* key, size_t length)
 {
-    size_t idx = hash % self->allocated;
-    size_t perturb = hash;
+    size_t hash = 0;
 
-    while ( 
-        (self->index[idx] != NULL && 
-        (ignore_dummy || self->index[idx] != self->dummy)) &&
-        (
-            self->index[idx] == self->dummy ||
-            (
-                (self->index[idx]->hash != hash) || 
-                (strcmp(self->index[idx]->key, key) != 0)
-            )
-        )
-    )
+    for (size_t idx = 0; idx < length; idx++)
     {
-        idx = ((idx << 2) + idx + perturb + 1) % self->allocated;
-        perturb >>= HASH_MAP_PERTURB_SHIFT;
+        hash += HASH_FUNCTION_PARAM_A*key[idx] + HASH_FUNCTION_PARAM_B;
     }
 
-    return idx;
+    return hash;
 }
+
 /**
- * @brief Výpočet indexu v hašovací tabulce v závislosti na dvojici klíč-hash.
+ * @brief Porovná klíč záznamu s klíčem dané délky.
  *
- * @param[in] self Ukazatel na strukturu hašovací tabulky.
- * @param[in] str  Klíč.
- * @param[in] str  Haš zadaného klíče.
- * 
- * @return Index záznamu asociovaný k zadanému klíči a haši, nebo prázdné místo
- *         v tabulce.
- * 
- * @see hash_map_lookup_handle
+ * Nejdříve se porovnají délky, klíče stejné délky pak funkcí @c memcmp , 
+ * klíč tedy nemusí být ukončen nulou.
  */
-size_t hash_map_lookup(hash_map_t* self, const char* key, size_t hash)
+static inline bool hash_map_key_equal(const hash_map_item_t* item, const char* key, 
+                                      size_t length)
 {
-    return hash_map_lookup_handle(self, key, hash, true);
+    return item->length == length && memcmp(item->key, key, length) == 0;
 }
 
 /**
- * @brief Inicializace hašovací tabulky.
- * 
- * Metoda alokuje a inicializuje položky struktury hašovací tabulky.
- * 
- * @param self[in] Ukazatel na neinicializovanou hašovací tabulku
- * @param size[in] Počet prvků v tabulce.
- * 
- * @return @c MEMORY_ERROR v případě chyby v alokaci paměti, jinak @c OK.
+ * @brief Porovnání klíče pro souběžné čtení, ukazatel na klíč záznamu se 
+ *        načte atomicky (viz hash_map_arena_compact).
  */
-hash_map_state_code_t hash_map_init(hash_map_t* self, size_t size)
+static inline bool hash_map_shared_key_equal(const hash_map_item_t* item, const char* key, 
+                                             size_t length)
 {
-    self->dummy = (hash_map_item_t*)malloc(sizeof(hash_map_item_t));
-    self->first = self->last = NULL;
-    self->used = 0;
-    self->allocated = 0;
-    self->index = NULL;
-    
-    if (hash_map_reserve(self, size) == MEMORY_ERROR)
+    return item->length == length && 
+           memcmp(__atomic_load_n(&item->key, __ATOMIC_ACQUIRE), key, length) == 0;
+}
+
+/**
+ * @brief Alokuje blok alokátoru s @p size bajty dat a zařadí ho na začátek 
+ *        seznamu @p list .
+ *
+ * @return Ukazatel na data bloku, nebo @c NULL při chybě alokace.
+ */
+static void* hash_map_block_alloc(hash_map_block_t** list, size_t size)
+{
+    hash_map_block_t* block = (hash_map_block_t*)malloc(sizeof(hash_map_block_t) + size);
+    if (block == NULL)
     {
-        free(self->dummy);
-        return MEMORY_ERROR;
+        return NULL;
     }
-
-    return OK;
+    block->size = size;
+    block->next = *list;
+    *list = block;
+    return block + 1;
 }
 
-/*******************************************************************************
- * Definice veřejných metod.
- ******************************************************************************/
-
-hash_map_t* hash_map_ctor()
+/**
+ * @brief Uvolní všechny bloky seznamu @p list .
+ */
+static void hash_map_block_free_all(hash_map_block_t** list)
 {
-    hash_map_t* map = (hash_map_t*)malloc(sizeof(hash_map_t));
-    if (map != NULL && hash_map_init(map, HASH_MAP_INIT_SIZE) == MEMORY_ERROR) 
+    while (*list != NULL)
     {
-        free(map);
-        map = NULL;
+        hash_map_block_t* block = *list;
+        *list = block->next;
+        free(block);
     }
-    return map;
 }
 
-void hash_map_clear(hash_map_t* self)
+/**
+ * @brief Alokuje záznam z bloků tabulky.
+ *
+ * Přednostně se použije uvolněný záznam, jinak další záznam posledního 
+ * bloku. Nové bloky se zvětšují s počtem záznamů až do 
+ * @c HASH_MAP_SLAB_MAX_ITEMS .
+ *
+ * @return Ukazatel na záznam, nebo @c NULL při chybě alokace.
+ */
+static hash_map_item_t* hash_map_item_alloc(hash_map_t* self)
 {
-    size_t idx;
-    hash_map_item_t* item = self->first;
-    hash_map_item_t* curr_item;
-    while (item != NULL)
+    hash_map_item_t* item = self->free_items;
+    if (item != NULL)
     {
-        curr_item = item;
-        item = item->next;
-        free(curr_item->key);
-        free(curr_item);
+        self->free_items = item->next;
+        return item;
     }
-
-    for (size_t i = 0; i < self->allocated; ++i)
+    if (self->slab_next == self->slab_end)
     {
-        self->index[i] = NULL;
+        size_t count = self->slab_capacity < HASH_MAP_INIT_SIZE ? HASH_MAP_INIT_SIZE : self->slab_capacity;
+        count = count < HASH_MAP_SLAB_MAX_ITEMS ? count : HASH_MAP_SLAB_MAX_ITEMS;
+        item = (hash_map_item_t*)hash_map_block_alloc(&self->slabs, count*self->item_size);
+        if (item == NULL)
+        {
+            return NULL;
+        }
+        self->slab_next = item;
+        self->slab_end = (hash_map_item_t*)((char*)item + count*self->item_size);
+        self->slab_capacity += count;
     }
-    
+    // zaznamy jsou v bloku po item_size bajtech, za kazdym lezi jeho hodnota
+    item = self->slab_next;
+    self->slab_next = (hash_map_item_t*)((char*)item + self->item_size);
+    return item;
+}
 
-    self->first = NULL;
-    self->last = NULL;
-    self->used = 0;
+/**
+ * @brief Vrátí záznam do seznamu uvolněných záznamů.
+ */
+static inline void hash_map_item_free(hash_map_t* self, hash_map_item_t* item)
+{
+    item->next = self->free_items;
+    self->free_items = item;
 }
 
-void hash_map_dtor(hash_map_t* self)
+/**
+ * @brief Hodnota nastavené velikosti uložená bezprostředně za záznamem.
+ */
+static inline void* hash_map_item_value(hash_map_item_t* item)
 {
-    hash_map_clear(self);
-    free(self->index);
-    free(self->dummy);
-    self->index = NULL;
-    self->allocated = 0;
-    free(self);
+    return item + 1;
 }
 
-hash_map_state_code_t hash_map_reserve(hash_map_t* self, size_t size)
+/**
+ * @brief Začátek přestavění indexu měřeného při překladu s 
+ *        @c HASH_MAP_STATS_RESIZE .
+ *
+ * @return Čas začátku v ns, bez makra 0.
+ */
+static inline uint64_t hash_map_resize_begin()
 {
-    // chceme alokovat mene mista nez je vlozenych zaznamu?
-    if (size < self->used)
-    {
-        return VALUE_ERROR;
-    }
+#ifdef HASH_MAP_STATS_RESIZE
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000ULL + (uint64_t)now.tv_nsec;
+#else
+    return 0;
+#endif
+}
 
-    if (size == self->allocated)
-    {
-        // jiz je alokovano
-        return OK;
-    }
+/**
+ * @brief Započte dokončené přestavění indexu, viz hash_map_resize_begin.
+ */
+static inline void hash_map_resize_end(hash_map_t* self, uint64_t start)
+{
+#ifdef HASH_MAP_STATS_RESIZE
+    self->resizes++;
+    self->resize_ns += hash_map_resize_begin() - start;
+#else
+    (void)self;
+    (void)start;
+#endif
+}
 
-    hash_map_item_t** new_index = (hash_map_item_t**)malloc(size*sizeof(hash_map_t*));
-    if (new_index == NULL)
-    {
-        // alokace pameti selhala
-        return MEMORY_ERROR;
-    }
-    // vycisteni indexu
-    for (size_t i = 0; i < size; ++i)
+/**
+ * @brief Velikost řídicích bajtů indexu včetně vzdáleností enginu Robin 
+ *        Hood v bajtech, viz hash_map_rehash.
+ */
+static inline size_t hash_map_ctrl_bytes(const hash_map_t* self)
+{
+    if (self->ctrl == NULL)
     {
-        new_index[i] = NULL;
+        return 0;
     }
+    size_t ctrl_size = (self->allocated | (HASH_MAP_GROUP_SIZE - 1)) + 1;
+    return self->dist != NULL ? 2 * ctrl_size : ctrl_size;
+}
 
-    if (self->index != NULL)
-    {
-        // prekopirovani indexu
-        size_t idx;
-        for (hash_map_item_t* item = self->first; item != NULL; item = item->next)
-        {
-            // zmenila se velikost, potrebujeme prepocitat indexy
-            idx = hash_map_lookup(self, item->key, item->hash);
-            new_index[idx] = item;
-        }
-        // uvolneni stareho indexu
-        free(self->index);
-    }
-    // nahrazeni stareho indexu
-    self->index = new_index;
-    self->allocated = size;
+/*******************************************************************************
+ * Epochy sdíleného čtení
+ ******************************************************************************/
 
-    return OK; 
-}
+/** Stav místa čtenáře, které patří vláknu, ale vlákno právě nečte. */
+static const uint64_t HASH_MAP_READER_IDLE = 1;
 
-size_t hash_map_size(hash_map_t* self) 
+/** Místo čtenáře na vlastní cache line, aby si čtenáři nepřepisovali řádky. */
+typedef struct
 {
-    return self->used;
+    uint64_t epoch;             ///< 0 volné, 1 nečte, jinak epocha čtení
+    char padding[56];
+} hash_map_reader_slot_t;
+
+/** Globální epocha, zvyšuje ji každé vyřazení paměti. */
+static uint64_t hash_map_epoch = HASH_MAP_READER_IDLE + 1;
+/** Místa registrovaných čtenářů (vláken). */
+static hash_map_reader_slot_t hash_map_readers[HASH_MAP_MAX_READERS];
+/** Počet čtenářů, na které nezbylo místo, jejich epocha není známá. */
+static uint64_t hash_map_overflow_readers = 0;
+/** Místo čtenáře aktuálního vlákna, -1 dokud vlákno nečetlo. */
+static __thread int hash_map_reader_slot = -1;
+static pthread_key_t hash_map_reader_key;
+static pthread_once_t hash_map_reader_once = PTHREAD_ONCE_INIT;
+
+/**
+ * @brief Uvolní místo čtenáře při ukončení vlákna.
+ */
+static void hash_map_reader_release(void* slot)
+{
+    __atomic_store_n(&hash_map_readers[(intptr_t)slot - 1].epoch, 0, __ATOMIC_RELEASE);
 }
 
-size_t hash_map_capacity(hash_map_t* self)
+static void hash_map_reader_key_create()
 {
-    return self->allocated;
+    pthread_key_create(&hash_map_reader_key, hash_map_reader_release);
 }
 
-bool hash_map_contains(hash_map_t* self, const char* key)
+/**
+ * @brief Místo čtenáře aktuálního vlákna, při prvním čtení se zabere volné.
+ *
+ * @return Číslo místa, nebo -1 pokud jsou všechna místa obsazená.
+ */
+static int hash_map_reader_register()
 {
-    size_t hash = hash_function(key); 
-    size_t idx = hash_map_lookup(self, key, hash);
-    return self->index[idx] != NULL;
+    if (hash_map_reader_slot >= 0)
+    {
+        return hash_map_reader_slot;
+    }
+    pthread_once(&hash_map_reader_once, hash_map_reader_key_create);
+    for (int i = 0; i < HASH_MAP_MAX_READERS; i++)
+    {
+        uint64_t expected = 0;
+        if (__atomic_compare_exchange_n(&hash_map_readers[i].epoch, &expected, 
+                                        HASH_MAP_READER_IDLE, false, 
+                                        __ATOMIC_ACQ_REL, __ATOMIC_RELAXED))
+        {
+            pthread_setspecific(hash_map_reader_key, (void*)(intptr_t)(i + 1));
+            hash_map_reader_slot = i;
+            return i;
+        }
+    }
+    return -1;
 }
 
-hash_map_state_code_t hash_map_put(hash_map_t* self, const char* key, int value)
+/**
+ * @brief Začátek čtení: vlákno oznámí epochu, ve které čte.
+ *
+ * Paměť vyřazená v této nebo pozdější epoše se neuvolní, dokud čtení 
+ * neskončí. Čtenář nikdy nečeká, počet kroků je omezený.
+ *
+ * @return Místo čtenáře pro hash_map_read_end.
+ */
+static inline int hash_map_read_begin()
 {
-    // je potreba realokovat misto?
-    if (((float)self->used / (float)self->allocated) >= HASH_MAP_REALLOCATION_THRESHOLD)
+    int slot = hash_map_reader_register();
+    if (slot >= 0)
+    {
+        __atomic_store_n(&hash_map_readers[slot].epoch, 
+                         __atomic_load_n(&hash_map_epoch, __ATOMIC_ACQUIRE), __ATOMIC_RELAXED);
+    }
+    else
     {
-        hash_map_reserve(self, self->allocated<<1);
+        __atomic_fetch_add(&hash_map_overflow_readers, 1, __ATOMIC_RELAXED);
     }
+    // cteni tabulky nesmi predbehnout oznameni epochy
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    return slot;
+}
 
-    size_t hash = hash_function(key);
-    size_t idx = hash_map_lookup_handle(self, key, hash, false);
+/**
+ * @brief Konec čtení započatého hash_map_read_begin.
+ */
+static inline void hash_map_read_end(int slot)
+{
+    if (slot >= 0)
+    {
+        __atomic_store_n(&hash_map_readers[slot].epoch, HASH_MAP_READER_IDLE, __ATOMIC_RELEASE);
+    }
+    else
+    {
+        __atomic_fetch_sub(&hash_map_overflow_readers, 1, __ATOMIC_RELEASE);
+    }
+}
 
-    // prazdne misto v indexu nebo se jedna o dummy objekt
-    // Vizte hash_map_lookup_handle
-    if (self->index[idx] == NULL || self->index[idx] == self->dummy) 
+/**
+ * @brief Nejstarší epocha probíhajícího čtení.
+ *
+ * @return Epocha, nebo @c UINT64_MAX pokud nikdo nečte, resp. 0 pokud čte 
+ *         čtenář bez místa a uvolnit nelze nic.
+ */
+static uint64_t hash_map_oldest_reader()
+{
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&hash_map_overflow_readers, __ATOMIC_ACQUIRE) > 0)
     {
-        self->index[idx] = (hash_map_item_t*)malloc(sizeof(hash_map_item_t));
-        if (self->index[idx] == NULL)
+        return 0;
+    }
+    uint64_t oldest = UINT64_MAX;
+    for (int i = 0; i < HASH_MAP_MAX_READERS; i++)
+    {
+        uint64_t epoch = __atomic_load_n(&hash_map_readers[i].epoch, __ATOMIC_ACQUIRE);
+        if (epoch > HASH_MAP_READER_IDLE && epoch < oldest)
         {
-            // alokace pameti selhala
-            return MEMORY_ERROR;
+            oldest = epoch;
         }
+    }
+    return oldest;
+}
 
-        self->index[idx]->key = (char*)malloc((strlen(key)+1)*sizeof(char));
-        if (self->index[idx]->key == NULL)
+/**
+ * @brief Uvolní vyřazenou paměť a záznamy, které už žádný čtenář nemůže 
+ *        číst.
+ *
+ * @param[in] self Ukazatel na strukturu hašovací tabulky.
+ * @param[in] all  Uvolnit vše bez ohledu na čtenáře (nikdo nečte).
+ */
+static void hash_map_reclaim(hash_map_t* self, bool all)
+{
+    uint64_t oldest = all ? UINT64_MAX : hash_map_oldest_reader();
+    hash_map_retired_t** link = &self->retired;
+    while (*link != NULL)
+    {
+        hash_map_retired_t* retired = *link;
+        // cteni zacate po vyrazeni uz pamet nemohlo najit
+        if (retired->epoch >= oldest)
         {
-            // alokace pameti selhala
-            free(self->index[idx]);
-            self->index[idx] = NULL;
-            return MEMORY_ERROR;
+            link = &retired->next;
+            continue;
         }
-        strcpy(self->index[idx]->key, key);
-        self->index[idx]->hash = hash;
-        self->index[idx]->value = value;
-        self->index[idx]->next = NULL;
-        self->index[idx]->prev = NULL;
-        self->used++;
-        // je seznam zaznamu prazdny?
-        if (self->last == NULL)
+        *link = retired->next;
+        if (retired->item)
         {
-            self->first = self->last = self->index[idx];
+            hash_map_item_free(self, (hash_map_item_t*)retired->ptr);
         }
         else
         {
-            self->last->next = self->index[idx];
-            self->index[idx]->prev = self->last;
-            self->last = self->index[idx];
+            free(retired->ptr);
         }
-        return OK;
+        free(retired);
+        self->retired_count--;
     }
-    else 
+}
+
+/**
+ * @brief Vyřadí paměť nebo záznam, které mohou ještě číst souběžní čtenáři.
+ *
+ * Vyřazení se označí epochou a uvolní se, až skončí všechna dříve započatá 
+ * čtení (sdílené čtení i optimistické čtení shardů s @c defer_free ).
+ */
+static void hash_map_retire(hash_map_t* self, void* ptr, size_t size, bool item)
+{
+    hash_map_retired_t* retired = (hash_map_retired_t*)malloc(sizeof(hash_map_retired_t));
+    if (retired == NULL)
     {
-        self->index[idx]->value = value;
-        return KEY_ALREADY_EXISTS;
+        // pamet se radeji neuvolni, nez aby ji ctenar cetl po uvolneni
+        return;
+    }
+    retired->ptr = ptr;
+    retired->size = size;
+    retired->item = item;
+    // odpojeni z tabulky predchazi zvyseni epochy
+    retired->epoch = __atomic_fetch_add(&hash_map_epoch, 1, __ATOMIC_SEQ_CST);
+    retired->next = self->retired;
+    self->retired = retired;
+    if (++self->retired_count >= HASH_MAP_RECLAIM_THRESHOLD)
+    {
+        hash_map_reclaim(self, false);
     }
 }
 
-hash_map_state_code_t hash_map_get(hash_map_t* self, const char* key, int* dst)
+/**
+ * @brief Uvolní paměť nahrazenou novou (index, pole záznamů, bloky arény).
+ *
+ * Pokud ji mohou číst souběžní čtenáři (sdílené čtení nebo @c defer_free ), 
+ * paměť se jen vyřadí, viz hash_map_retire.
+ *
+ * @param[in] self Ukazatel na strukturu hašovací tabulky.
+ * @param[in] ptr  Uvolňovaná paměť, může být @c NULL .
+ * @param[in] size Velikost paměti v bajtech pro hash_map_stats.
+ */
+static void hash_map_release(hash_map_t* self, void* ptr, size_t size)
 {
-    size_t hash = hash_function(key);
-    size_t idx = hash_map_lookup(self, key, hash);
-
-    if (self->index[idx] == NULL)
+    if (ptr == NULL)
     {
-        // klic neni asociovan se zadnym zaznamem
-        return KEY_ERROR;
+        return;
     }
-    
-    *dst = self->index[idx]->value;
-
-    return OK;
+    if (!self->defer_free && self->read_policy == HASH_MAP_READ_EXCLUSIVE)
+    {
+        free(ptr);
+        return;
+    }
+    hash_map_retire(self, ptr, size, false);
 }
 
-hash_map_state_code_t hash_map_remove(hash_map_t* self, const char* key)
+/**
+ * @brief Uvolní záznam odstraněný z tabulky.
+ *
+ * Při sdíleném čtení se záznam znovu použije, až ho žádný čtenář nemůže 
+ * číst.
+ */
+static inline void hash_map_item_release(hash_map_t* self, hash_map_item_t* item)
 {
-    int dst;
-    return hash_map_pop(self, key, &dst);
+    if (self->read_policy == HASH_MAP_READ_SHARED)
+    {
+        hash_map_retire(self, item, 0, true);
+    }
+    else
+    {
+        hash_map_item_free(self, item);
+    }
 }
 
-hash_map_state_code_t hash_map_pop(hash_map_t* self, const char* key, int* dst)
+/**
+ * @brief Uvolní všechny bloky seznamu @p list , viz hash_map_release.
+ */
+static void hash_map_release_blocks(hash_map_t* self, hash_map_block_t** list)
 {
-    size_t hash = hash_function(key);
-    size_t idx = hash_map_lookup(self, key, hash);
-
-    if (self->index[idx] == NULL)
+    while (*list != NULL)
     {
-        // klic neni asociovan se zadnym zaznamem
-        return KEY_ERROR;
+        hash_map_block_t* block = *list;
+        *list = block->next;
+        hash_map_release(self, block, sizeof(hash_map_block_t) + block->size);
     }
-    else 
-    {
-        // jedna se o prvni zaznam v seznamu?
-        if (self->index[idx]->prev == NULL)
+}
+
+/**
+ * @brief Alokuje v aréně místo pro klíč délky @p length včetně ukončovací 
+ *        nuly.
+ *
+ * @return Ukazatel na místo pro klíč, nebo @c NULL při chybě alokace.
+ */
+static char* hash_map_key_alloc(hash_map_t* self, size_t length)
+{
+    if ((size_t)(self->arena_end - self->arena_next) <= length)
+    {
+        // bloky areny rostou s jeji velikosti, ale jen do velikosti, kterou 
+        // po uvolneni alokator snadno znovu pouzije
+        size_t size = self->arena_size > HASH_MAP_ARENA_BLOCK_SIZE ? self->arena_size : HASH_MAP_ARENA_BLOCK_SIZE;
+        size = size < HASH_MAP_ARENA_MAX_BLOCK_SIZE ? size : HASH_MAP_ARENA_MAX_BLOCK_SIZE;
+        size = size > length ? size : length + 1;
+        char* data = (char*)hash_map_block_alloc(&self->arena, size);
+        if (data == NULL)
+        {
+            return NULL;
+        }
+        // zbytek predchoziho bloku uz nebude vyuzit
+        self->arena_wasted += (size_t)(self->arena_end - self->arena_next);
+        self->arena_next = data;
+        self->arena_end = data + size;
+        self->arena_size += size;
+    }
+    char* key = self->arena_next;
+    self->arena_next += length + 1;
+    return key;
+}
+
+/**
+ * @brief Přesune všechny dlouhé klíče do nových bloků arény a uvolní staré 
+ *        bloky.
+ *
+ * Při chybě alokace zůstanou staré bloky v aréně, aby klíče, které se 
+ * nepodařilo přesunout, zůstaly platné. Ukazatel na přesunutý klíč se 
+ * zapíše atomicky, souběžní čtenáři tak čtou starý i nový klíč celý.
+ *
+ * @param[in] self Ukazatel na strukturu hašovací tabulky.
+ */
+static void hash_map_arena_compact(hash_map_t* self)
+{
+    hash_map_block_t* old_arena = self->arena;
+    self->arena = NULL;
+    self->arena_next = self->arena_end = NULL;
+    self->arena_size = 0;
+    self->arena_wasted = 0;
+    for (hash_map_item_t* item = self->first; item != NULL; item = item->next)
+    {
+        if (item->key != item->inline_key)
+        {
+            size_t length = item->length;
+            char* key = hash_map_key_alloc(self, length);
+            if (key == NULL)
+            {
+                // stare bloky se pripoji za nove
+                hash_map_block_t** tail = &self->arena;
+                while (*tail != NULL)
+                {
+                    tail = &(*tail)->next;
+                }
+                *tail = old_arena;
+                for (hash_map_block_t* block = old_arena; block != NULL; block = block->next)
+                {
+                    self->arena_size += block->size;
+                    self->arena_wasted += block->size;
+                }
+                return;
+            }
+            memcpy(key, item->key, length + 1);
+            // ctenari ve sdilenem rezimu ctou klic soubezne, stary blok se 
+            // jen vyradi
+            __atomic_store_n(&item->key, key, __ATOMIC_RELEASE);
+        }
+    }
+    hash_map_release_blocks(self, &old_arena);
+}
+
+/**
+ * @brief Uvolní klíč záznamu, pokud není uložen přímo v záznamu.
+ *
+ * Místo dlouhého klíče v aréně se jen započítá jako nevyužité, aréna se 
+ * setřese, když nevyužité místo přesáhne čtvrtinu.
+ */
+static inline void hash_map_free_key(hash_map_t* self, hash_map_item_t* item)
+{
+    if (item->key != item->inline_key)
+    {
+        self->arena_wasted += item->length + 1;
+        if (self->arena_wasted > self->arena_size / 4 && 
+            self->arena_wasted >= HASH_MAP_ARENA_BLOCK_SIZE)
+        {
+            // klic musi byt nejdrive vyrazen ze seznamu, viz hash_map_pop
+            hash_map_arena_compact(self);
+        }
+    }
+}
+
+/**
+ * @brief 7bitový otisk haše ukládaný do řídicího bajtu indexu.
+ *
+ * Otisk tvoří nejvyšší bity haše, které se pro výpočet pozice v indexu 
+ * nepoužívají.
+ *
+ * @param[in] hash Haš klíče.
+ *
+ * @return Otisk v rozsahu 0 až 127.
+ */
+static inline uint8_t hash_map_tag(size_t hash)
+{
+    return (uint8_t)(hash >> (sizeof(size_t)*8 - 7));
+}
+
+/**
+ * @brief Výchozí pozice haše v indexu.
+ *
+ * Index velikosti mocniny dvou použije nejnižší bity haše, jinak se haš 
+ * (bez bitů otisku) zobrazí na interval <0, allocated) násobením (tzv. 
+ * fastrange), tedy bez dělení.
+ *
+ * @param[in] self Ukazatel na strukturu hašovací tabulky.
+ * @param[in] hash Haš klíče.
+ *
+ * @return Výchozí pozice v indexu.
+ */
+static inline size_t hash_map_home(hash_map_t* self, size_t hash)
+{
+    if (self->mask + 1 == self->allocated)
+    {
+        return hash & self->mask;
+    }
+#if defined(__SIZEOF_INT128__)
+    return (size_t)(((unsigned __int128)(hash << 7) * self->allocated) >> 64);
+#else
+    uint32_t h = (uint32_t)(hash << 7);
+    return (size_t)(((uint64_t)h * self->allocated) >> 32);
+#endif
+}
+
+/**
+ * @brief Záznam na obsazeném místě @p idx indexu.
+ *
+ * @param[in] self Ukazatel na strukturu hašovací tabulky.
+ * @param[in] idx  Místo v indexu s otiskem haše v řídicím bajtu.
+ *
+ * @return Ukazatel na záznam.
+ */
+static inline hash_map_item_t* hash_map_slot_get(hash_map_t* self, size_t idx)
+{
+    if (self->layout == HASH_MAP_LAYOUT_LINKED)
+    {
+        return self->index[idx];
+    }
+    switch (self->slot_width)
+    {
+        case 1:  return self->entries + ((uint8_t*)self->slots)[idx];
+        case 2:  return self->entries + ((uint16_t*)self->slots)[idx];
+        case 4:  return self->entries + ((uint32_t*)self->slots)[idx];
+        default: return self->entries + ((uint64_t*)self->slots)[idx];
+    }
+}
+
+/**
+ * @brief Uloží záznam na místo @p idx indexu.
+ *
+ * @param[in] self Ukazatel na strukturu hašovací tabulky.
+ * @param[in] idx  Místo v indexu.
+ * @param[in] item Záznam, v kompaktním rozložení prvek pole @c entries .
+ */
+static inline void hash_map_slot_set(hash_map_t* self, size_t idx, hash_map_item_t* item)
+{
+    if (self->layout == HASH_MAP_LAYOUT_LINKED)
+    {
+        // par k nacteni se semantikou acquire v hash_map_shared_find
+        __atomic_store_n(&self->index[idx], item, __ATOMIC_RELEASE);
+        return;
+    }
+    size_t entry = (size_t)(item - self->entries);
+    switch (self->slot_width)
+    {
+        case 1:  ((uint8_t*)self->slots)[idx] = (uint8_t)entry; break;
+        case 2:  ((uint16_t*)self->slots)[idx] = (uint16_t)entry; break;
+        case 4:  ((uint32_t*)self->slots)[idx] = (uint32_t)entry; break;
+        default: ((uint64_t*)self->slots)[idx] = (uint64_t)entry; break;
+    }
+}
+
+/**
+ * @brief Nejmenší šířka čísla záznamu (v bajtech) pro pole záznamů dané 
+ *        kapacity.
+ */
+static inline uint8_t hash_map_slot_width(size_t entries)
+{
+    if (entries <= (size_t)UINT8_MAX + 1)
+    {
+        return 1;
+    }
+    if (entries <= (size_t)UINT16_MAX + 1)
+    {
+        return 2;
+    }
+    if (entries <= (size_t)UINT32_MAX + 1)
+    {
+        return 4;
+    }
+    return 8;
+}
+
+/**
+ * @brief Bitová maska míst skupiny, jejichž řídicí bajt je roven @p value .
+ *
+ * @param[in] group Začátek skupiny @c HASH_MAP_GROUP_SIZE řídicích bajtů.
+ * @param[in] value Hledaná hodnota.
+ *
+ * @return Bit @c i je nastaven, pokud @c group[i] == value .
+ */
+static inline uint32_t hash_map_group_match(const uint8_t* group, uint8_t value)
+{
+#if defined(__SSE2__) || defined(_M_X64)
+    __m128i ctrl = _mm_load_si128((const __m128i*)group);
+    return (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(ctrl, _mm_set1_epi8((char)value)));
+#else
+    uint32_t mask = 0;
+    for (int i = 0; i < HASH_MAP_GROUP_SIZE; i++)
+    {
+        mask |= (uint32_t)(group[i] == value) << i;
+    }
+    return mask;
+#endif
+}
+
+/**
+ * @brief Bitová maska volných míst skupiny (prázdných nebo po odstranění).
+ *
+ * Volná místa jako jediná mají nastaven nejvyšší bit řídicího bajtu.
+ */
+static inline uint32_t hash_map_group_available(const uint8_t* group)
+{
+#if defined(__SSE2__) || defined(_M_X64)
+    return (uint32_t)_mm_movemask_epi8(_mm_load_si128((const __m128i*)group));
+#else
+    uint32_t mask = 0;
+    for (int i = 0; i < HASH_MAP_GROUP_SIZE; i++)
+    {
+        mask |= (uint32_t)(group[i] >> 7) << i;
+    }
+    return mask;
+#endif
+}
+
+/** @brief Pozice nejnižšího nastaveného bitu nenulové masky. */
+static inline unsigned hash_map_lowest_bit(uint32_t mask)
+{
+#if defined(__GNUC__)
+    return (unsigned)__builtin_ctz(mask);
+#else
+    unsigned i = 0;
+    while (!(mask & 1))
+    {
+        mask >>= 1;
+        i++;
+    }
+    return i;
+#endif
+}
+
+/** @brief Požádá procesor o načtení cache line s adresou @p addr . */
+static inline void hash_map_prefetch(const void* addr)
+{
+#if defined(__GNUC__)
+    __builtin_prefetch(addr);
+#else
+    (void)addr;
+#endif
+}
+
+/**
+ * @brief První místo, které hledání daného haše v indexu navštíví.
+ */
+static inline size_t hash_map_probe_start(hash_map_t* self, size_t hash)
+{
+    if (self->engine == HASH_MAP_ENGINE_GROUPS)
+    {
+        return hash & self->mask & ~(size_t)(HASH_MAP_GROUP_SIZE - 1);
+    }
+    return hash_map_home(self, hash);
+}
+
+/**
+ * @brief Načte do cache řídicí bajt a místo indexu, kde hledání haše začne.
+ */
+static inline void hash_map_prefetch_slot(hash_map_t* self, size_t hash)
+{
+    size_t idx = hash_map_probe_start(self, hash);
+    hash_map_prefetch(self->ctrl + idx);
+    if (self->layout == HASH_MAP_LAYOUT_LINKED)
+    {
+        hash_map_prefetch(self->index + idx);
+    }
+    else
+    {
+        hash_map_prefetch((const char*)self->slots + idx*self->slot_width);
+    }
+}
+
+/**
+ * @brief Načte do cache záznam, na který ukazuje první místo hledání haše, 
+ *        pokud jeho otisk odpovídá.
+ *
+ * Předpokládá, že řídicí bajt a místo indexu už načetla 
+ * hash_map_prefetch_slot.
+ */
+static inline void hash_map_prefetch_item(hash_map_t* self, size_t hash)
+{
+    size_t idx = hash_map_probe_start(self, hash);
+    uint8_t tag = hash_map_tag(hash);
+    if (self->engine == HASH_MAP_ENGINE_GROUPS)
+    {
+        uint32_t match = hash_map_group_match(self->ctrl + idx, tag);
+        if (match == 0)
+        {
+            return;
+        }
+        idx += hash_map_lowest_bit(match);
+    }
+    else if (self->ctrl[idx] != tag)
+    {
+        return;
+    }
+    hash_map_prefetch(hash_map_slot_get(self, idx));
+}
+
+/**
+ * @brief Hledání v indexu po skupinách (@c HASH_MAP_ENGINE_GROUPS ).
+ *
+ * Skupiny se procházejí trojúhelníkovými kroky, které při počtu skupin 
+ * rovném mocnině dvou navštíví každou skupinu. V každé skupině se najednou 
+ * porovnají všechny řídicí bajty s otiskem haše a hledání končí ve skupině, 
+ * která obsahuje prázdné místo.
+ *
+ * @see hash_map_lookup_handle
+ */
+static size_t hash_map_group_lookup(hash_map_t* self, const char* key, size_t length, 
+                                    size_t hash, bool ignore_dummy)
+{
+    size_t pos = hash & self->mask & ~(size_t)(HASH_MAP_GROUP_SIZE - 1);
+    size_t step = 0;
+    uint8_t tag = hash_map_tag(hash);
+    size_t available = SIZE_MAX;
+
+    while (true)
+    {
+        const uint8_t* group = self->ctrl + pos;
+        // polozky se ctou az pri shode otisku
+        for (uint32_t match = hash_map_group_match(group, tag); match != 0; match &= match - 1)
+        {
+            size_t idx = pos + hash_map_lowest_bit(match);
+            hash_map_item_t* item = hash_map_slot_get(self, idx);
+            if (item->hash == hash && hash_map_key_equal(item, key, length))
+            {
+                return idx;
+            }
+        }
+        if (!ignore_dummy && available == SIZE_MAX)
+        {
+            uint32_t free_slots = hash_map_group_available(group);
+            if (free_slots != 0)
+            {
+                available = pos + hash_map_lowest_bit(free_slots);
+            }
+        }
+        uint32_t empty = hash_map_group_match(group, HASH_MAP_CTRL_EMPTY);
+        if (empty != 0)
+        {
+            return ignore_dummy ? pos + hash_map_lowest_bit(empty) : available;
+        }
+        step += HASH_MAP_GROUP_SIZE;
+        pos = (pos + step) & self->mask;
+    }
+}
+
+/**
+ * @brief Vzdálenost záznamu na obsazeném místě @p idx od jeho výchozí pozice 
+ *        (engine Robin Hood).
+ *
+ * Vzdálenost se čte z @c dist , jen nasycená hodnota 
+ * @c HASH_MAP_ROBIN_MAX_DISTANCE se dopočítá z haše záznamu.
+ */
+static inline size_t hash_map_robin_distance(hash_map_t* self, size_t idx)
+{
+    size_t distance = self->dist[idx];
+    if (distance < HASH_MAP_ROBIN_MAX_DISTANCE)
+    {
+        return distance;
+    }
+    size_t home = hash_map_home(self, hash_map_slot_get(self, idx)->hash);
+    return idx >= home ? idx - home : idx + self->allocated - home;
+}
+
+/**
+ * @brief Uloží vzdálenost záznamu na místě @p idx , větší než 
+ *        @c HASH_MAP_ROBIN_MAX_DISTANCE se nasytí.
+ */
+static inline void hash_map_robin_set_distance(hash_map_t* self, size_t idx, size_t distance)
+{
+    self->dist[idx] = (uint8_t)(distance < HASH_MAP_ROBIN_MAX_DISTANCE ? distance 
+                                                                       : HASH_MAP_ROBIN_MAX_DISTANCE);
+}
+
+/**
+ * @brief Hledání v indexu enginu Robin Hood (@c HASH_MAP_ENGINE_ROBIN_HOOD ).
+ *
+ * Index se prochází lineárně od výchozí pozice. Záznamy jsou seřazené podle 
+ * vzdálenosti od výchozí pozice, hledání proto skončí na prvním záznamu, 
+ * který je své výchozí pozici blíž než hledaný klíč té své. Položka se čte 
+ * jen u záznamů se stejnou výchozí pozicí a shodným otiskem.
+ *
+ * @return Místo záznamu, nebo @c allocated pokud klíč v indexu není (řídicí 
+ *         bajt za koncem indexu je vždy @c HASH_MAP_CTRL_EMPTY ).
+ *
+ * @see hash_map_lookup_handle
+ */
+static size_t hash_map_robin_lookup(hash_map_t* self, const char* key, size_t length, 
+                                    size_t hash)
+{
+    size_t idx = hash_map_home(self, hash);
+    uint8_t tag = hash_map_tag(hash);
+
+    for (size_t distance = 0; self->ctrl[idx] != HASH_MAP_CTRL_EMPTY; distance++)
+    {
+        size_t resident = hash_map_robin_distance(self, idx);
+        if (resident < distance)
+        {
+            // hledany klic by lezel pred timto zaznamem
+            break;
+        }
+        if (resident == distance && self->ctrl[idx] == tag)
+        {
+            hash_map_item_t* item = hash_map_slot_get(self, idx);
+            if (item->hash == hash && hash_map_key_equal(item, key, length))
+            {
+                return idx;
+            }
+        }
+        if (++idx == self->allocated)
+        {
+            idx = 0;
+        }
+    }
+    return self->allocated;
+}
+
+/**
+ * @brief Vložení záznamu do indexu enginu Robin Hood.
+ *
+ * Vkládaný záznam postupuje od výchozí pozice a vystřídá první záznam, 
+ * který je své výchozí pozici blíž, dál se pak vkládá vystřídaný záznam.
+ *
+ * @param[in] self Ukazatel na strukturu hašovací tabulky.
+ * @param[in] item Vkládaný záznam, klíč v indexu ještě není.
+ */
+static void hash_map_robin_insert(hash_map_t* self, hash_map_item_t* item)
+{
+    size_t idx = hash_map_home(self, item->hash);
+    uint8_t ctrl = hash_map_tag(item->hash);
+
+    for (size_t distance = 0; ; distance++)
+    {
+        if (self->ctrl[idx] == HASH_MAP_CTRL_EMPTY)
+        {
+            hash_map_slot_set(self, idx, item);
+            hash_map_robin_set_distance(self, idx, distance);
+            self->ctrl[idx] = ctrl;
+            return;
+        }
+        size_t resident = hash_map_robin_distance(self, idx);
+        if (resident < distance)
+        {
+            // bohatsi zaznam uvolni misto, dal se vklada on
+            hash_map_item_t* displaced = hash_map_slot_get(self, idx);
+            uint8_t displaced_ctrl = self->ctrl[idx];
+            hash_map_slot_set(self, idx, item);
+            hash_map_robin_set_distance(self, idx, distance);
+            self->ctrl[idx] = ctrl;
+            item = displaced;
+            ctrl = displaced_ctrl;
+            distance = resident;
+        }
+        if (++idx == self->allocated)
+        {
+            idx = 0;
+        }
+    }
+}
+
+/**
+ * @brief Odstranění záznamu z místa @p idx indexu enginu Robin Hood.
+ *
+ * Následující záznamy, které nejsou na své výchozí pozici, se posunou o 
+ * místo zpět (backward shift), takže v indexu nezůstane @c dummy objekt.
+ */
+static void hash_map_robin_erase(hash_map_t* self, size_t idx)
+{
+    size_t next = idx + 1 == self->allocated ? 0 : idx + 1;
+    while (self->ctrl[next] != HASH_MAP_CTRL_EMPTY)
+    {
+        size_t distance = hash_map_robin_distance(self, next);
+        if (distance == 0)
+        {
+            break;
+        }
+        hash_map_slot_set(self, idx, hash_map_slot_get(self, next));
+        hash_map_robin_set_distance(self, idx, distance - 1);
+        self->ctrl[idx] = self->ctrl[next];
+        idx = next;
+        next = idx + 1 == self->allocated ? 0 : idx + 1;
+    }
+    self->ctrl[idx] = HASH_MAP_CTRL_EMPTY;
+}
+
+/**
+ * @brief Výpočet indexu v hašovací tabulce v závislosti na dvojici klíč-hash.
+ * 
+ * V případě kolize funkce nalezne další volný index v tabulce. V případě 
+ * vyhledávání považujeme @c dummy objekt jako jakýkoliv jiný záznam, tedy
+ * @p ignore_dummy je nastaveno na @c false . Při vkládání je @c dummy objekt 
+ * ekvivalentní prázdnému místu, tedy @p ignore_dummy je nastaveno na @c true .
+ * Tento jev je způsoben kvůli kolizím klíčů. Když je záznam odstraněn, je 
+ * nahrazen za @c dummy objekt, aby bylo možné vyřešit případné kolize.
+ *
+ * Při vkládání se místo po odstraněném záznamu vrátí až tehdy, když klíč v 
+ * tabulce opravdu není, jinak by se mohl vložit podruhé. Hledání vždy skončí, 
+ * protože hash_map_put udržuje v indexu prázdná místa (viz @c deleted ).
+ *
+ * Index velikosti mocniny dvou se prochází perturbací s maskou, index jiné 
+ * velikosti lineárně, protože perturbace modulo obecné velikosti nemusí 
+ * projít všechny pozice. Engine @c HASH_MAP_ENGINE_GROUPS prochází index po 
+ * skupinách, viz hash_map_group_lookup. Engine @c HASH_MAP_ENGINE_ROBIN_HOOD 
+ * vrací pro chybějící klíč místo @c allocated , vkládá se pak 
+ * hash_map_robin_insert, viz hash_map_robin_lookup.
+ *
+ * @param[in] self         Ukazatel na strukturu hašovací tabulky.
+ * @param[in] key          Klíč.
+ * @param[in] length       Délka klíče v bajtech.
+ * @param[in] hash         Haš zadaného klíče.
+ * @param[in] ignore_dummy Pokud @c true, @c dummy objekt je vždy přeskočen,
+ *                         pokud @c false, @c dummy objekt je interpretován jako
+ *                         @c NULL.
+ * 
+ * @return Index záznamu asociovaný k zadanému klíči a haši, nebo prázdné místo
+ *         v tabulce.
+ */
+size_t hash_map_lookup_handle(hash_map_t* self, const char* key, size_t length, 
+                              size_t hash, bool ignore_dummy)
+{
+    if (self->engine == HASH_MAP_ENGINE_GROUPS)
+    {
+        return hash_map_group_lookup(self, key, length, hash, ignore_dummy);
+    }
+    if (self->engine == HASH_MAP_ENGINE_ROBIN_HOOD)
+    {
+        return hash_map_robin_lookup(self, key, length, hash);
+    }
+
+    size_t idx = hash_map_home(self, hash);
+    size_t perturb = hash;
+    bool masked = self->mask + 1 == self->allocated;
+    uint8_t tag = hash_map_tag(hash);
+    size_t available = SIZE_MAX;
+
+    while (true)
+    {
+        uint8_t ctrl = self->ctrl[idx];
+        if (ctrl == HASH_MAP_CTRL_EMPTY)
+        {
+            // pri vkladani se prednostne pouzije prvni misto po odstraneni
+            if (!ignore_dummy && available != SIZE_MAX)
+            {
+                idx = available;
+            }
+            break;
+        }
+        if (ctrl == HASH_MAP_CTRL_DELETED)
+        {
+            if (!ignore_dummy && available == SIZE_MAX)
+            {
+                available = idx;
+            }
+        }
+        // polozka se cte az pri shode otisku
+        else if (ctrl == tag && hash_map_slot_get(self, idx)->hash == hash && 
+                 hash_map_key_equal(hash_map_slot_get(self, idx), key, length))
+        {
+            break;
+        }
+        if (masked)
+        {
+            idx = ((idx << 2) + idx + perturb + 1) & self->mask;
+            perturb >>= HASH_MAP_PERTURB_SHIFT;
+        }
+        else if (++idx == self->allocated)
+        {
+            idx = 0;
+        }
+    }
+
+    return idx;
+}
+/**
+ * @brief Výpočet indexu v hašovací tabulce v závislosti na dvojici klíč-hash.
+ *
+ * @param[in] self   Ukazatel na strukturu hašovací tabulky.
+ * @param[in] key    Klíč.
+ * @param[in] length Délka klíče v bajtech.
+ * @param[in] hash   Haš zadaného klíče.
+ * 
+ * @return Index záznamu asociovaný k zadanému klíči a haši, nebo prázdné místo
+ *         v tabulce.
+ * 
+ * @see hash_map_lookup_handle
+ */
+size_t hash_map_lookup(hash_map_t* self, const char* key, size_t length, size_t hash)
+{
+    return hash_map_lookup_handle(self, key, length, hash, true);
+}
+
+/**
+ * @brief Uloží záznam na prázdné místo @p idx nalezené 
+ *        hash_map_lookup_handle, engine Robin Hood si místo najde sám.
+ */
+static inline void hash_map_place(hash_map_t* self, size_t idx, hash_map_item_t* item)
+{
+    if (self->engine == HASH_MAP_ENGINE_ROBIN_HOOD)
+    {
+        hash_map_robin_insert(self, item);
+        return;
+    }
+    hash_map_slot_set(self, idx, item);
+    __atomic_store_n(&self->ctrl[idx], hash_map_tag(item->hash), __ATOMIC_RELEASE);
+}
+
+/**
+ * @brief Prohodí aktuální a starý index postupného zvětšování.
+ *
+ * Hledání ve starém indexu tak může použít hash_map_lookup, engine obou 
+ * indexů je stejný.
+ */
+static inline void hash_map_swap_index(hash_map_t* self)
+{
+    hash_map_item_t** index = self->index;
+    uint8_t* ctrl = self->ctrl;
+    size_t allocated = self->allocated;
+    size_t mask = self->mask;
+    self->index = self->old_index;
+    self->ctrl = self->old_ctrl;
+    self->allocated = self->old_allocated;
+    self->mask = self->old_mask;
+    self->old_index = index;
+    self->old_ctrl = ctrl;
+    self->old_allocated = allocated;
+    self->old_mask = mask;
+}
+
+/**
+ * @brief Hledání klíče ve starém indexu postupného zvětšování.
+ *
+ * @param[in]  self   Ukazatel na strukturu hašovací tabulky.
+ * @param[in]  key    Klíč.
+ * @param[in]  length Délka klíče v bajtech.
+ * @param[in]  hash   Haš zadaného klíče.
+ * @param[out] idx    Místo záznamu ve starém indexu.
+ *
+ * @return @c true pokud je klíč ve starém indexu.
+ */
+static bool hash_map_old_lookup(hash_map_t* self, const char* key, size_t length, 
+                                size_t hash, size_t* idx)
+{
+    if (self->old_used == 0)
+    {
+        return false;
+    }
+    hash_map_swap_index(self);
+    *idx = hash_map_lookup(self, key, length, hash);
+    bool found = self->ctrl[*idx] != HASH_MAP_CTRL_EMPTY;
+    hash_map_swap_index(self);
+    return found;
+}
+
+/**
+ * @brief Uvolní starý index postupného zvětšování.
+ */
+static void hash_map_drop_old_index(hash_map_t* self)
+{
+    hash_map_release(self, self->old_index, self->old_allocated * sizeof(hash_map_item_t*));
+    hash_map_release(self, self->old_ctrl, (self->old_allocated | (HASH_MAP_GROUP_SIZE - 1)) + 1);
+    self->old_index = NULL;
+    self->old_ctrl = NULL;
+    self->old_allocated = 0;
+    self->old_mask = 0;
+    self->old_used = 0;
+    self->migrate = 0;
+}
+
+/** Vzdálenost (v místech starého indexu), ze které se při přesunu předem 
+ *  načítají záznamy. */
+static const size_t HASH_MAP_MIGRATE_PREFETCH = 16;
+
+/**
+ * @brief Přesune nejvýše @p count záznamů ze starého indexu do aktuálního.
+ *
+ * Starý index se prochází sekvenčně od místa @c migrate , záznam se z něj 
+ * přesouvá bez hledání. Místo ve starém indexu se označí jako odstraněné, 
+ * aby hledání jiných klíčů ve starém indexu dál procházelo kolize. Po 
+ * přesunu posledního záznamu se starý index uvolní.
+ *
+ * @param[in] self  Ukazatel na strukturu hašovací tabulky.
+ * @param[in] count Největší počet přesunutých záznamů.
+ */
+static void hash_map_migrate(hash_map_t* self, size_t count)
+{
+    if (self->old_ctrl == NULL)
+    {
+        return;
+    }
+    for (; count > 0 && self->old_used > 0; self->migrate++)
+    {
+        uint8_t ctrl = self->old_ctrl[self->migrate];
+        if (ctrl == HASH_MAP_CTRL_EMPTY || ctrl == HASH_MAP_CTRL_DELETED)
+        {
+            continue;
+        }
+        // zaznam o nekolik mist dal se nacte, nez na nej dojde rada
+        size_t ahead = self->migrate + HASH_MAP_MIGRATE_PREFETCH;
+        if (ahead < self->old_allocated && self->old_ctrl[ahead] != HASH_MAP_CTRL_EMPTY && 
+            self->old_ctrl[ahead] != HASH_MAP_CTRL_DELETED)
+        {
+            hash_map_prefetch(self->old_index[ahead]);
+        }
+        hash_map_item_t* item = self->old_index[self->migrate];
+        self->old_ctrl[self->migrate] = HASH_MAP_CTRL_DELETED;
+        self->old_index[self->migrate] = self->dummy;
+
+        size_t idx = hash_map_lookup_handle(self, item->key, item->length, item->hash, false);
+        if (self->ctrl[idx] == HASH_MAP_CTRL_DELETED)
+        {
+            self->deleted--;
+        }
+        hash_map_slot_set(self, idx, item);
+        self->ctrl[idx] = ctrl;
+        self->old_used--;
+        count--;
+    }
+    if (self->old_used == 0)
+    {
+        hash_map_drop_old_index(self);
+    }
+}
+
+/**
+ * @brief Vyhledá záznam klíče v aktuálním i starém indexu.
+ *
+ * @return Ukazatel na záznam, nebo @c NULL pokud klíč v tabulce není.
+ */
+static hash_map_item_t* hash_map_find(hash_map_t* self, const char* key, size_t length, 
+                                      size_t hash)
+{
+    size_t idx = hash_map_lookup(self, key, length, hash);
+    if (self->ctrl[idx] != HASH_MAP_CTRL_EMPTY)
+    {
+        return hash_map_slot_get(self, idx);
+    }
+    if (hash_map_old_lookup(self, key, length, hash, &idx))
+    {
+        return self->old_index[idx];
+    }
+    return NULL;
+}
+
+/**
+ * @brief Vyhledání klíče ve zveřejněném pohledu (sdílený režim čtení).
+ *
+ * Na rozdíl od hash_map_find čte každé místo indexu jen jednou: řídicí bajt 
+ * se načte se sémantikou acquire a ukazatel na záznam až po něm, také se 
+ * sémantikou acquire (záznam s novou hodnotou nahrazuje původní na stejném 
+ * místě, viz hash_map_value_update), záznam je tedy vždy úplně naplněný. 
+ * Zapisovatel může místo mezitím uvolnit nebo obsadit jiným záznamem, proto 
+ * se klíč vždy porovná v přečteném záznamu. Hledání má omezený počet kroků, 
+ * v indexu vždy zůstávají prázdná místa.
+ *
+ * @return Ukazatel na záznam, nebo @c NULL pokud klíč v pohledu není.
+ */
+static hash_map_item_t* hash_map_shared_find(hash_map_t* view, const char* key, 
+                                             size_t length, size_t hash)
+{
+    uint8_t tag = hash_map_tag(hash);
+    if (view->engine == HASH_MAP_ENGINE_GROUPS)
+    {
+        size_t pos = hash & view->mask & ~(size_t)(HASH_MAP_GROUP_SIZE - 1);
+        size_t step = 0;
+        while (true)
+        {
+            const uint8_t* group = view->ctrl + pos;
+            uint32_t match = hash_map_group_match(group, tag);
+            uint32_t empty = hash_map_group_match(group, HASH_MAP_CTRL_EMPTY);
+            // zaznamy se ctou az po ridicich bajtech skupiny
+            __atomic_thread_fence(__ATOMIC_ACQUIRE);
+            for (; match != 0; match &= match - 1)
+            {
+                size_t idx = pos + hash_map_lowest_bit(match);
+                hash_map_item_t* item = __atomic_load_n(&view->index[idx], __ATOMIC_ACQUIRE);
+                if (item->hash == hash && hash_map_shared_key_equal(item, key, length))
+                {
+                    return item;
+                }
+            }
+            if (empty != 0)
+            {
+                return NULL;
+            }
+            step += HASH_MAP_GROUP_SIZE;
+            pos = (pos + step) & view->mask;
+        }
+    }
+
+    size_t idx = hash_map_home(view, hash);
+    size_t perturb = hash;
+    bool masked = view->mask + 1 == view->allocated;
+    while (true)
+    {
+        uint8_t ctrl = __atomic_load_n(&view->ctrl[idx], __ATOMIC_ACQUIRE);
+        if (ctrl == HASH_MAP_CTRL_EMPTY)
+        {
+            return NULL;
+        }
+        if (ctrl == tag)
+        {
+            hash_map_item_t* item = __atomic_load_n(&view->index[idx], __ATOMIC_ACQUIRE);
+            if (item->hash == hash && hash_map_shared_key_equal(item, key, length))
+            {
+                return item;
+            }
+        }
+        if (masked)
+        {
+            idx = ((idx << 2) + idx + perturb + 1) & view->mask;
+            perturb >>= HASH_MAP_PERTURB_SHIFT;
+        }
+        else if (++idx == view->allocated)
+        {
+            idx = 0;
+        }
+    }
+}
+
+/**
+ * @brief Čtení ve sdíleném režimu bez zámků.
+ *
+ * Čtenář oznámí epochu, načte aktuální pohled a hledá v něm. Záznamy a 
+ * pole, která zapisovatel mezitím vyřadí, se neuvolní dřív, než čtení 
+ * skončí (viz hash_map_reclaim).
+ *
+ * @param[in]  self   Ukazatel na strukturu hašovací tabulky.
+ * @param[in]  key    Klíč.
+ * @param[in]  length Délka klíče v bajtech.
+ * @param[out] dst    Hodnota záznamu, může být @c NULL .
+ * @param[out] value  Místo pro kopii hodnoty nastavené velikosti, může být 
+ *                    @c NULL .
+ *
+ * @return @c true pokud klíč v tabulce je.
+ */
+static bool hash_map_shared_read(hash_map_t* self, const char* key, size_t length, int* dst, 
+                                 void* value)
+{
+    size_t hash = self->hash_function(key, length);
+    int slot = hash_map_read_begin();
+    hash_map_t* view = __atomic_load_n(&self->view, __ATOMIC_ACQUIRE);
+    hash_map_item_t* item = hash_map_shared_find(view, key, length, hash);
+    if (item != NULL && dst != NULL)
+    {
+        *dst = __atomic_load_n(&item->value, __ATOMIC_RELAXED);
+    }
+    if (item != NULL && value != NULL)
+    {
+        memcpy(value, hash_map_item_value(item), self->value_size);
+    }
+    hash_map_read_end(slot);
+    return item != NULL;
+}
+
+/**
+ * @brief Zkopíruje položky tabulky, které čte hash_map_find.
+ */
+static inline void hash_map_snapshot(hash_map_t* dst, const hash_map_t* src)
+{
+    dst->index = src->index;
+    dst->ctrl = src->ctrl;
+    dst->dist = src->dist;
+    dst->allocated = src->allocated;
+    dst->mask = src->mask;
+    dst->engine = src->engine;
+    dst->layout = src->layout;
+    dst->entries = src->entries;
+    dst->slots = src->slots;
+    dst->slot_width = src->slot_width;
+    dst->old_index = src->old_index;
+    dst->old_ctrl = src->old_ctrl;
+    dst->old_allocated = src->old_allocated;
+    dst->old_mask = src->old_mask;
+    dst->old_used = src->old_used;
+}
+
+/**
+ * @brief Zveřejní čtenářům ve sdíleném režimu aktuální index.
+ *
+ * Pohled se vymění jedním atomickým zápisem, předchozí pohled se vyřadí až 
+ * po zveřejnění nového, stejně jako nahrazená pole, na která ukazoval.
+ *
+ * @param[in] self Ukazatel na strukturu hašovací tabulky.
+ * @param[in] view Nově alokovaný pohled.
+ */
+static void hash_map_publish(hash_map_t* self, hash_map_t* view)
+{
+    hash_map_snapshot(view, self);
+    hash_map_t* old_view = self->view;
+    __atomic_store_n(&self->view, view, __ATOMIC_RELEASE);
+    hash_map_release(self, old_view, sizeof(hash_map_t));
+}
+
+/**
+ * @brief Zaplnění indexu, od kterého se při vkládání index zvětšuje.
+ */
+static inline float hash_map_max_load(hash_map_t* self)
+{
+    switch (self->engine)
+    {
+        case HASH_MAP_ENGINE_GROUPS:     return HASH_MAP_GROUP_REALLOCATION_THRESHOLD;
+        case HASH_MAP_ENGINE_ROBIN_HOOD: return HASH_MAP_ROBIN_REALLOCATION_THRESHOLD;
+        default:                         return HASH_MAP_REALLOCATION_THRESHOLD;
+    }
+}
+
+/**
+ * @brief Kapacita pole záznamů kompaktního rozložení pro index velikosti 
+ *        @p size .
+ *
+ * Pole stačí na tolik záznamů, kolik jich index pojme před zvětšením.
+ */
+static inline size_t hash_map_entries_capacity(hash_map_t* self, size_t size)
+{
+    size_t entries = (size_t)((float)size * hash_map_max_load(self));
+    return (entries > self->used ? entries : self->used) + 1;
+}
+
+/**
+ * @brief Inicializace hašovací tabulky.
+ * 
+ * Metoda alokuje a inicializuje položky struktury hašovací tabulky.
+ * 
+ * @param self[in] Ukazatel na neinicializovanou hašovací tabulku
+ * @param size[in] Počet prvků v tabulce.
+ * 
+ * @return @c MEMORY_ERROR v případě chyby v alokaci paměti, jinak @c OK.
+ */
+hash_map_state_code_t hash_map_init(hash_map_t* self, size_t size)
+{
+    self->dummy = (hash_map_item_t*)malloc(sizeof(hash_map_item_t));
+    if (self->dummy == NULL)
+    {
+        return MEMORY_ERROR;
+    }
+    // optimisticky ctenar shardu muze dummy objekt precist misto 
+    // odstraneneho zaznamu, musi mit platny (prazdny) klic
+    memset(self->dummy, 0, sizeof(hash_map_item_t));
+    self->dummy->key = self->dummy->inline_key;
+    self->first = self->last = NULL;
+    self->used = 0;
+    self->deleted = 0;
+    self->allocated = 0;
+    self->index = NULL;
+    self->ctrl = NULL;
+    self->dist = NULL;
+    self->hash_function = hash_map_default_hash;
+    self->mask = 0;
+    self->capacity_policy = HASH_MAP_CAPACITY_EXACT;
+    self->engine = HASH_MAP_ENGINE_PROBING;
+    self->layout = HASH_MAP_LAYOUT_LINKED;
+    self->entries = NULL;
+    self->entries_used = 0;
+    self->entries_allocated = 0;
+    self->slots = NULL;
+    self->slot_width = 1;
+    self->slabs = NULL;
+    self->free_items = NULL;
+    self->slab_next = self->slab_end = NULL;
+    self->slab_capacity = 0;
+    self->arena = NULL;
+    self->arena_next = self->arena_end = NULL;
+    self->arena_size = 0;
+    self->arena_wasted = 0;
+    self->resize_policy = HASH_MAP_RESIZE_BLOCKING;
+    self->old_index = NULL;
+    self->old_ctrl = NULL;
+    self->old_allocated = 0;
+    self->old_mask = 0;
+    self->old_used = 0;
+    self->migrate = 0;
+    self->defer_free = false;
+    self->retired = NULL;
+    self->retired_count = 0;
+    self->read_policy = HASH_MAP_READ_EXCLUSIVE;
+    self->view = NULL;
+    self->value_size = 0;
+    self->item_size = sizeof(hash_map_item_t);
+    self->cache_limit = 0;
+    self->evict_function = NULL;
+    self->evict_context = NULL;
+    self->cache_stats.hits = self->cache_stats.misses = self->cache_stats.evictions = 0;
+#ifdef HASH_MAP_STATS_RESIZE
+    self->resizes = 0;
+    self->resize_ns = 0;
+#endif
+    
+    if (hash_map_reserve(self, size) == MEMORY_ERROR)
+    {
+        free(self->dummy);
+        return MEMORY_ERROR;
+    }
+
+    return OK;
+}
+
+/**
+ * @brief Vloží všechny záznamy ze seznamu do vyčištěného indexu.
+ *
+ * Vloží i záznamy, které jsou ještě ve starém indexu postupného zvětšování, 
+ * starý index se proto uvolní.
+ *
+ * @param[in] self Ukazatel na strukturu hašovací tabulky.
+ */
+static void hash_map_reinsert(hash_map_t* self)
+{
+    size_t idx;
+    for (hash_map_item_t* item = self->first; item != NULL; item = item->next)
+    {
+        // engine Robin Hood si misto najde pri vkladani
+        idx = self->engine == HASH_MAP_ENGINE_ROBIN_HOOD ? 0 
+                : hash_map_lookup(self, item->key, item->length, item->hash);
+        hash_map_place(self, idx, item);
+    }
+    self->deleted = 0;
+    hash_map_drop_old_index(self);
+}
+
+/**
+ * @brief Přesune živé záznamy kompaktního rozložení v pořadí seznamu na 
+ *        začátek pole @p dst a přepojí seznam.
+ *
+ * Pole @p dst může být i stávající pole @c entries , pořadí seznamu odpovídá 
+ * pořadí v poli, takže se záznamy posouvají jen dopředu.
+ *
+ * @param[in] self Ukazatel na strukturu hašovací tabulky.
+ * @param[in] dst  Cílové pole s kapacitou alespoň @c used záznamů.
+ */
+static void hash_map_compact_entries(hash_map_t* self, hash_map_item_t* dst)
+{
+    hash_map_item_t* prev = NULL;
+    hash_map_item_t* item = self->first;
+    size_t count = 0;
+    while (item != NULL)
+    {
+        hash_map_item_t* next = item->next;
+        if (dst + count != item)
+        {
+            dst[count] = *item;
+            // kratky klic se presunul se zaznamem
+            if (item->key == item->inline_key)
+            {
+                dst[count].key = dst[count].inline_key;
+            }
+        }
+        dst[count].prev = prev;
+        if (prev != NULL)
+        {
+            prev->next = dst + count;
+        }
+        prev = dst + count++;
+        item = next;
+    }
+    if (prev != NULL)
+    {
+        prev->next = NULL;
+    }
+    self->first = count > 0 ? dst : NULL;
+    self->last = prev;
+    self->entries_used = count;
+}
+
+/**
+ * @brief Alokace nového indexu dané velikosti a přeindexování všech záznamů.
+ *
+ * Pozice záznamů se počítají až vůči novému indexu, @c dummy objekty 
+ * odstraněných záznamů se do nového indexu nepřenáší.
+ *
+ * @param[in] self Ukazatel na strukturu hašovací tabulky.
+ * @param[in] size Velikost nového indexu, nesmí být menší než počet záznamů.
+ *
+ * @return @c MEMORY_ERROR v případě chyby v alokaci paměti, jinak @c OK.
+ */
+hash_map_state_code_t hash_map_rehash(hash_map_t* self, size_t size)
+{
+    if (size > SIZE_MAX / sizeof(hash_map_item_t))
+    {
+        return MEMORY_ERROR;
+    }
+    uint64_t start = hash_map_resize_begin();
+    // ctenari ve sdilenem rezimu dostanou novy index az se vsemi zaznamy
+    hash_map_t* new_view = NULL;
+    if (self->read_policy == HASH_MAP_READ_SHARED)
+    {
+        new_view = (hash_map_t*)malloc(sizeof(hash_map_t));
+        if (new_view == NULL)
+        {
+            return MEMORY_ERROR;
+        }
+    }
+    // skupiny ridicich bajtu se ctou zarovnane po HASH_MAP_GROUP_SIZE bajtech, 
+    // vzdalenosti enginu Robin Hood lezi hned za nimi
+    size_t ctrl_size = (size | (HASH_MAP_GROUP_SIZE - 1)) + 1;
+    size_t dist_size = self->engine == HASH_MAP_ENGINE_ROBIN_HOOD ? ctrl_size : 0;
+    uint8_t* new_ctrl = (uint8_t*)aligned_alloc(HASH_MAP_GROUP_SIZE, ctrl_size + dist_size);
+    if (new_ctrl == NULL)
+    {
+        // alokace pameti selhala
+        free(new_view);
+        return MEMORY_ERROR;
+    }
+
+    hash_map_item_t** old_index = NULL;
+    if (self->layout == HASH_MAP_LAYOUT_COMPACT)
+    {
+        size_t entries = hash_map_entries_capacity(self, size);
+        uint8_t width = hash_map_slot_width(entries);
+        void* new_slots = malloc(size > 0 ? size*width : 1);
+        hash_map_item_t* new_entries = (hash_map_item_t*)malloc(entries*sizeof(hash_map_item_t));
+        if (new_slots == NULL || new_entries == NULL)
+        {
+            // alokace pameti selhala
+            free(new_view);
+            free(new_ctrl);
+            free(new_slots);
+            free(new_entries);
+            return MEMORY_ERROR;
+        }
+        // zive zaznamy se presunou do noveho pole, odstranene se vypusti
+        hash_map_compact_entries(self, new_entries);
+        hash_map_release(self, self->entries, self->entries_allocated * sizeof(hash_map_item_t));
+        hash_map_release(self, self->slots, self->allocated * self->slot_width);
+        self->entries = new_entries;
+        self->entries_allocated = entries;
+        self->slots = new_slots;
+        self->slot_width = width;
+    }
+    else
+    {
+        hash_map_item_t** new_index = (hash_map_item_t**)malloc(size*sizeof(hash_map_item_t*));
+        if (new_index == NULL)
+        {
+            // alokace pameti selhala
+            free(new_view);
+            free(new_ctrl);
+            return MEMORY_ERROR;
+        }
+        // vycisteni indexu
+        for (size_t i = 0; i < size; ++i)
+        {
+            new_index[i] = NULL;
+        }
+        old_index = self->index;
+        self->index = new_index;
+    }
+    // misto za koncem indexu zustane prazdne, viz hash_map_robin_lookup
+    memset(new_ctrl, HASH_MAP_CTRL_EMPTY, ctrl_size);
+
+    // nahrazeni stareho indexu, pozice se musi pocitat uz vuci novemu
+    uint8_t* old_ctrl = self->ctrl;
+    size_t old_index_bytes = self->allocated * sizeof(hash_map_item_t*);
+    size_t old_ctrl_bytes = hash_map_ctrl_bytes(self);
+    self->ctrl = new_ctrl;
+    self->dist = dist_size > 0 ? new_ctrl + ctrl_size : NULL;
+    self->allocated = size;
+    self->mask = (size & (size - 1)) == 0 ? size - 1 : 0;
+
+    hash_map_reinsert(self);
+
+    // stary index mohou cist ctenari, uvolni se az po zverejneni noveho
+    if (new_view != NULL)
+    {
+        hash_map_publish(self, new_view);
+    }
+    hash_map_release(self, old_index, old_index_bytes);
+    hash_map_release(self, old_ctrl, old_ctrl_bytes);
+    hash_map_resize_end(self, start);
+
+    return OK; 
+}
+
+/**
+ * @brief Odstranění všech @c dummy objektů z indexu beze změny velikosti.
+ *
+ * Index se přestaví na místě, protože všechny záznamy jsou dostupné ze 
+ * seznamu, nepotřebuje žádnou alokaci. V kompaktním rozložení se zároveň 
+ * z pole @c entries vypustí odstraněné záznamy. Ve sdíleném režimu čtení 
+ * a s @c defer_free (shardy souběžné tabulky) se index přestaví do nově 
+ * alokovaného, viz hash_map_rehash.
+ *
+ * @param[in] self Ukazatel na strukturu hašovací tabulky.
+ *
+ * @return @c MEMORY_ERROR pokud se nový index nepodařilo alokovat (původní 
+ *         zůstane i s @c dummy objekty), jinak @c OK.
+ */
+static hash_map_state_code_t hash_map_rehash_in_place(hash_map_t* self)
+{
+    if (self->read_policy == HASH_MAP_READ_SHARED || self->defer_free)
+    {
+        // ctenari mohou prave prochazet index, prestavi se do noveho
+        return hash_map_rehash(self, self->allocated);
+    }
+    uint64_t start = hash_map_resize_begin();
+    if (self->layout == HASH_MAP_LAYOUT_COMPACT)
+    {
+        // odstranene zaznamy se z pole vypusti, cisla zaznamu se zmeni
+        hash_map_compact_entries(self, self->entries);
+    }
+    else
+    {
+        for (size_t i = 0; i < self->allocated; ++i)
+        {
+            self->index[i] = NULL;
+        }
+    }
+    memset(self->ctrl, HASH_MAP_CTRL_EMPTY, self->allocated);
+    hash_map_reinsert(self);
+    hash_map_resize_end(self, start);
+    return OK;
+}
+
+/**
+ * @brief Alokace nového indexu dané velikosti bez přeindexování záznamů.
+ *
+ * Aktuální index se stane starým indexem a záznamy z něj do nového 
+ * přesouvají následující operace (viz hash_map_migrate). Rozpracovaný přesun 
+ * se nejdříve dokončí. Jen pro rozložení @c HASH_MAP_LAYOUT_LINKED .
+ *
+ * @param[in] self Ukazatel na strukturu hašovací tabulky.
+ * @param[in] size Velikost nového indexu, větší než aktuální.
+ *
+ * @return @c MEMORY_ERROR v případě chyby v alokaci paměti, jinak @c OK.
+ */
+static hash_map_state_code_t hash_map_rehash_incremental(hash_map_t* self, size_t size)
+{
+    if (size > SIZE_MAX / sizeof(hash_map_item_t))
+    {
+        return MEMORY_ERROR;
+    }
+    uint64_t start = hash_map_resize_begin();
+    uint8_t* new_ctrl = (uint8_t*)aligned_alloc(HASH_MAP_GROUP_SIZE, 
+                                                (size | (HASH_MAP_GROUP_SIZE - 1)) + 1);
+    hash_map_item_t** new_index = (hash_map_item_t**)malloc(size*sizeof(hash_map_item_t*));
+    if (new_ctrl == NULL || new_index == NULL)
+    {
+        // alokace pameti selhala
+        free(new_ctrl);
+        free(new_index);
+        return MEMORY_ERROR;
+    }
+    memset(new_ctrl, HASH_MAP_CTRL_EMPTY, (size | (HASH_MAP_GROUP_SIZE - 1)) + 1);
+
+    hash_map_migrate(self, SIZE_MAX);
+    self->old_index = self->index;
+    self->old_ctrl = self->ctrl;
+    self->old_allocated = self->allocated;
+    self->old_mask = self->mask;
+    self->old_used = self->used;
+    self->migrate = 0;
+
+    // ukazatele noveho indexu se ctou az podle ridicich bajtu
+    self->index = new_index;
+    self->ctrl = new_ctrl;
+    self->allocated = size;
+    self->mask = (size & (size - 1)) == 0 ? size - 1 : 0;
+    self->deleted = 0;
+    hash_map_resize_end(self, start);
+
+    return OK;
+}
+
+/*******************************************************************************
+ * Definice veřejných metod.
+ ******************************************************************************/
+
+hash_map_t* hash_map_ctor()
+{
+    hash_map_t* map = (hash_map_t*)malloc(sizeof(hash_map_t));
+    if (map != NULL && hash_map_init(map, HASH_MAP_INIT_SIZE) == MEMORY_ERROR) 
+    {
+        free(map);
+        map = NULL;
+    }
+    return map;
+}
+
+void hash_map_clear(hash_map_t* self)
+{
+    self->first = NULL;
+    self->last = NULL;
+    self->used = 0;
+    self->deleted = 0;
+    self->entries_used = 0;
+    hash_map_drop_old_index(self);
+
+    if (self->read_policy == HASH_MAP_READ_SHARED)
+    {
+        // ctenari mohou prave prochazet index, zaznamy se odpoji zverejnenim 
+        // noveho prazdneho indexu a stary se vyradi
+        if (hash_map_rehash(self, self->allocated) != OK)
+        {
+            // pri chybe alokace se ridici bajty vymazou po jednom atomicky
+            for (size_t i = 0; i < self->allocated; ++i)
+            {
+                __atomic_store_n(&self->ctrl[i], HASH_MAP_CTRL_EMPTY, __ATOMIC_RELAXED);
+            }
+        }
+
+        // vyrazene zaznamy lezi v blocich, ktere se vyradi cele
+        hash_map_retired_t** link = &self->retired;
+        while (*link != NULL)
+        {
+            hash_map_retired_t* retired = *link;
+            if (retired->item)
+            {
+                *link = retired->next;
+                free(retired);
+                self->retired_count--;
+            }
+            else
+            {
+                link = &retired->next;
+            }
+        }
+        // zaznamy i klice lezi v blocich, vyradi se az po odpojeni z indexu
+        hash_map_release_blocks(self, &self->slabs);
+        hash_map_release_blocks(self, &self->arena);
+    }
+    else
+    {
+        if (self->layout == HASH_MAP_LAYOUT_LINKED)
+        {
+            for (size_t i = 0; i < self->allocated; ++i)
+            {
+                self->index[i] = NULL;
+            }
+        }
+        memset(self->ctrl, HASH_MAP_CTRL_EMPTY, self->allocated);
+
+        // zaznamy i klice lezi v blocich, uvolni se najednou
+        hash_map_block_free_all(&self->slabs);
+        hash_map_block_free_all(&self->arena);
+    }
+    self->free_items = NULL;
+    self->slab_next = self->slab_end = NULL;
+    self->slab_capacity = 0;
+    self->arena_next = self->arena_end = NULL;
+    self->arena_size = 0;
+    self->arena_wasted = 0;
+}
+
+void hash_map_dtor(hash_map_t* self)
+{
+    // nikdo uz necte, vyrazene zaznamy zaniknou s bloky
+    while (self->retired != NULL)
+    {
+        hash_map_retired_t* retired = self->retired;
+        self->retired = retired->next;
+        if (!retired->item)
+        {
+            free(retired->ptr);
+        }
+        free(retired);
+    }
+    self->retired_count = 0;
+    self->read_policy = HASH_MAP_READ_EXCLUSIVE;
+    hash_map_clear(self);
+    free(self->index);
+    free(self->ctrl);
+    free(self->entries);
+    free(self->slots);
+    free(self->dummy);
+    free(self->view);
+    self->index = NULL;
+    self->entries = NULL;
+    self->slots = NULL;
+    self->ctrl = NULL;
+    self->allocated = 0;
+    free(self);
+}
+
+/**
+ * @brief Nejmenší mocnina dvou větší nebo rovna @p size .
+ *
+ * @return Mocnina dvou, nebo 0 pokud by přetekla rozsah @c size_t .
+ */
+static size_t hash_map_round_up_pow2(size_t size)
+{
+    size_t pow2 = 1;
+    while (pow2 < size)
+    {
+        if (pow2 > SIZE_MAX / 2)
+        {
+            return 0;
+        }
+        pow2 <<= 1;
+    }
+    return pow2;
+}
+
+/**
+ * @brief Velikost indexu, kterou pro požadovanou velikost vyžaduje politika 
+ *        velikosti indexu a engine tabulky.
+ *
+ * @return Upravená velikost, nebo 0 pokud by přetekla rozsah @c size_t .
+ */
+static size_t hash_map_index_size(hash_map_t* self, size_t size)
+{
+    if (self->engine == HASH_MAP_ENGINE_GROUPS)
+    {
+        return hash_map_round_up_pow2(size < HASH_MAP_GROUP_SIZE ? HASH_MAP_GROUP_SIZE : size);
+    }
+    if (self->capacity_policy == HASH_MAP_CAPACITY_POWER_OF_TWO)
+    {
+        return hash_map_round_up_pow2(size);
+    }
+    return size;
+}
+
+hash_map_state_code_t hash_map_reserve(hash_map_t* self, size_t size)
+{
+    // chceme alokovat mene mista nez je vlozenych zaznamu?
+    if (size < self->used)
+    {
+        return VALUE_ERROR;
+    }
+
+    size_t requested = size;
+    size = hash_map_index_size(self, size);
+    if (size == 0 && requested != 0)
+    {
+        return MEMORY_ERROR;
+    }
+
+    if (size == self->allocated)
+    {
+        // jiz je alokovano
+        return OK;
+    }
+
+    if (self->resize_policy == HASH_MAP_RESIZE_INCREMENTAL && size > self->allocated && 
+        self->used > 0 && self->layout == HASH_MAP_LAYOUT_LINKED && 
+        self->engine != HASH_MAP_ENGINE_ROBIN_HOOD && self->read_policy == HASH_MAP_READ_EXCLUSIVE)
+    {
+        return hash_map_rehash_incremental(self, size);
+    }
+    return hash_map_rehash(self, size);
+}
+
+hash_map_state_code_t hash_map_set_capacity_policy(hash_map_t* self, 
+                                                   hash_map_capacity_policy_t policy)
+{
+    self->capacity_policy = policy;
+    return hash_map_reserve(self, self->allocated);
+}
+
+hash_map_state_code_t hash_map_set_engine(hash_map_t* self, hash_map_engine_t engine)
+{
+    if (engine == HASH_MAP_ENGINE_ROBIN_HOOD && self->read_policy == HASH_MAP_READ_SHARED)
+    {
+        // ctenari by mohli minout zaznam, ktery se prave posouva
+        return VALUE_ERROR;
+    }
+    hash_map_engine_t previous = self->engine;
+    self->engine = engine;
+    size_t size = hash_map_index_size(self, self->allocated);
+    // i pri stejne velikosti se meni poradi prochazeni, index je nutne prestavet
+    hash_map_state_code_t state = size == 0 && self->allocated != 0 ? MEMORY_ERROR 
+                                                                     : hash_map_rehash(self, size);
+    if (state != OK)
+    {
+        // puvodni index zustal, prochazi se puvodnim zpusobem
+        self->engine = previous;
+    }
+    return state;
+}
+
+hash_map_state_code_t hash_map_set_layout(hash_map_t* self, hash_map_layout_t layout)
+{
+    if (self->used > 0 || (layout == HASH_MAP_LAYOUT_COMPACT && 
+                           (self->read_policy == HASH_MAP_READ_SHARED || self->value_size > 0 || 
+                            self->cache_limit > 0)))
+    {
+        return VALUE_ERROR;
+    }
+    // prazdna tabulka, stare ulozeni se jen uvolni
+    hash_map_release(self, self->index, self->allocated * sizeof(hash_map_item_t*));
+    hash_map_release(self, self->entries, self->entries_allocated * sizeof(hash_map_item_t));
+    hash_map_release(self, self->slots, self->allocated * self->slot_width);
+    self->index = NULL;
+    self->entries = NULL;
+    self->slots = NULL;
+    self->first = self->last = NULL;
+    self->entries_used = 0;
+    self->entries_allocated = 0;
+    self->layout = layout;
+    return hash_map_rehash(self, self->allocated);
+}
+
+hash_map_state_code_t hash_map_set_resize_policy(hash_map_t* self, 
+                                                 hash_map_resize_policy_t policy)
+{
+    self->resize_policy = policy;
+    if (policy == HASH_MAP_RESIZE_BLOCKING)
+    {
+        hash_map_migrate(self, SIZE_MAX);
+    }
+    return OK;
+}
+
+hash_map_state_code_t hash_map_set_read_policy(hash_map_t* self, 
+                                               hash_map_read_policy_t policy)
+{
+    if (policy == HASH_MAP_READ_EXCLUSIVE)
+    {
+        // zadny ctenar uz necte, vyrazenou pamet lze uvolnit hned
+        self->read_policy = policy;
+        hash_map_reclaim(self, true);
+        free(self->view);
+        self->view = NULL;
+        return OK;
+    }
+    if (self->layout == HASH_MAP_LAYOUT_COMPACT || self->engine == HASH_MAP_ENGINE_ROBIN_HOOD || 
+        self->cache_limit > 0)
+    {
+        return VALUE_ERROR;
+    }
+    if (self->read_policy == HASH_MAP_READ_SHARED)
+    {
+        return OK;
+    }
+    hash_map_t* view = (hash_map_t*)malloc(sizeof(hash_map_t));
+    if (view == NULL)
+    {
+        return MEMORY_ERROR;
+    }
+    // ctenari prochazi jen aktualni index
+    hash_map_migrate(self, SIZE_MAX);
+    self->read_policy = policy;
+    hash_map_publish(self, view);
+    return OK;
+}
+
+hash_map_state_code_t hash_map_set_hash_function(hash_map_t* self, 
+                                                 hash_map_hash_function_t hash_function)
+{
+    self->hash_function = hash_function != NULL ? hash_function : hash_map_default_hash;
+    for (hash_map_item_t* item = self->first; item != NULL; item = item->next)
+    {
+        item->hash = self->hash_function(item->key, item->length);
+    }
+    return hash_map_rehash(self, self->allocated);
+}
+
+size_t hash_map_size(hash_map_t* self) 
+{
+    return self->used;
+}
+
+size_t hash_map_capacity(hash_map_t* self)
+{
+    return self->allocated;
+}
+
+bool hash_map_contains(hash_map_t* self, const char* key)
+{
+    return hash_map_contains_n(self, key, strlen(key));
+}
+
+bool hash_map_contains_n(hash_map_t* self, const char* key, size_t length)
+{
+    if (self->read_policy == HASH_MAP_READ_SHARED)
+    {
+        return hash_map_shared_read(self, key, length, NULL, NULL);
+    }
+    hash_map_migrate(self, HASH_MAP_MIGRATE_STEP);
+    return hash_map_find(self, key, length, self->hash_function(key, length)) != NULL;
+}
+
+hash_map_state_code_t hash_map_put(hash_map_t* self, const char* key, int value)
+{
+    return hash_map_put_n(self, key, strlen(key), value);
+}
+
+/**
+ * @brief Odstranění záznamu klíče se známým hašem, viz hash_map_pop.
+ *
+ * Je-li @p value různé od @c NULL , zkopíruje se do něj hodnota nastavené 
+ * velikosti (viz hash_map_set_value_size).
+ */
+static hash_map_state_code_t hash_map_pop_hashed(hash_map_t* self, const char* key, 
+                                                 size_t length, size_t hash, int* dst, 
+                                                 void* value)
+{
+    hash_map_migrate(self, HASH_MAP_MIGRATE_STEP);
+    size_t idx = hash_map_lookup(self, key, length, hash);
+    bool in_old = false;
+
+    if (self->ctrl[idx] == HASH_MAP_CTRL_EMPTY)
+    {
+        if (!hash_map_old_lookup(self, key, length, hash, &idx))
+        {
+            // klic neni asociovan se zadnym zaznamem
+            return KEY_ERROR;
+        }
+        // zaznam jeste nebyl presunut do noveho indexu
+        in_old = true;
+    }
+
+    hash_map_item_t* item = in_old ? self->old_index[idx] : hash_map_slot_get(self, idx);
+    // jedna se o prvni zaznam v seznamu?
+    if (item->prev == NULL)
+    {
+        self->first = item->next;
+    }
+    else 
+    {
+        item->prev->next = item->next;
+    }
+    // jedna se o posledni zaznam v seznamu?
+    if (item->next == NULL)
+    {
+        self->last = item->prev;
+    }
+    else 
+    {
+        item->next->prev = item->prev;
+    }
+    // uloz hodnotu
+    *dst = item->value;
+    if (value != NULL)
+    {
+        memcpy(value, hash_map_item_value(item), self->value_size);
+    }
+    self->used--;
+    // zaznam se nejdrive odstrani z indexu, pak teprve uvolni
+    if (in_old)
+    {
+        self->old_index[idx] = self->dummy;
+        self->old_ctrl[idx] = HASH_MAP_CTRL_DELETED;
+    }
+    else if (self->engine == HASH_MAP_ENGINE_ROBIN_HOOD)
+    {
+        hash_map_robin_erase(self, idx);
+    }
+    else
+    {
+        __atomic_store_n(&self->ctrl[idx], (uint8_t)HASH_MAP_CTRL_DELETED, __ATOMIC_RELEASE);
+        self->deleted++;
+        // Nahrazeni zaznamu za dummy objekt.
+        // V pripade kolize, odstraneni prvne vlozeneho zaznamu s kolizi,
+        // a nastaveni daneho mista na NULL, algoritmus by nemel informaci, 
+        // zda ke kolizi doslo. Pri sdilenem cteni muze ctenar ukazatel 
+        // jeste precist, zustane proto platny.
+        if (self->layout == HASH_MAP_LAYOUT_LINKED && self->read_policy == HASH_MAP_READ_EXCLUSIVE)
+        {
+            self->index[idx] = self->dummy;
+        }
+    }
+    // smaz zaznam
+    hash_map_free_key(self, item);
+    if (self->layout == HASH_MAP_LAYOUT_COMPACT)
+    {
+        // v poli zustane dira az do pristiho prestaveni indexu
+        item->key = NULL;
+    }
+    else
+    {
+        hash_map_item_release(self, item);
+    }
+    if (in_old && --self->old_used == 0)
+    {
+        // stary index existuje jen v rozlozeni HASH_MAP_LAYOUT_LINKED
+        hash_map_drop_old_index(self);
+    }
+
+    // je index zbytecne velky?
+    if (self->allocated > HASH_MAP_INIT_SIZE && 
+        ((float)self->used / (float)self->allocated) < HASH_MAP_SHRINK_THRESHOLD)
+    {
+        size_t size = self->used << 2;
+        // pri selhani alokace zustane puvodni index
+        hash_map_reserve(self, size < HASH_MAP_INIT_SIZE ? HASH_MAP_INIT_SIZE : size);
+    }
+
+    return OK;
+}
+
+/**
+ * @brief Přesune záznam na konec seznamu, pokud je tabulka v režimu cache.
+ *
+ * @param[in] self Ukazatel na strukturu hašovací tabulky.
+ * @param[in] item Použitý záznam.
+ */
+static inline void hash_map_cache_touch(hash_map_t* self, hash_map_item_t* item)
+{
+    if (self->cache_limit == 0 || item == self->last)
+    {
+        return;
+    }
+    // zaznam neni posledni, ma tedy naslednika
+    if (item->prev == NULL)
+    {
+        self->first = item->next;
+    }
+    else
+    {
+        item->prev->next = item->next;
+    }
+    item->next->prev = item->prev;
+    item->prev = self->last;
+    item->next = NULL;
+    self->last->next = item;
+    self->last = item;
+}
+
+/**
+ * @brief Započte hledání v režimu cache a nalezený záznam přesune na konec 
+ *        seznamu.
+ *
+ * @param[in] self Ukazatel na strukturu hašovací tabulky.
+ * @param[in] item Nalezený záznam, nebo @c NULL .
+ */
+static inline void hash_map_cache_access(hash_map_t* self, hash_map_item_t* item)
+{
+    if (self->cache_limit == 0)
+    {
+        return;
+    }
+    if (item == NULL)
+    {
+        self->cache_stats.misses++;
+        return;
+    }
+    self->cache_stats.hits++;
+    hash_map_cache_touch(self, item);
+}
+
+/**
+ * @brief Odstraní nejdéle nepoužité záznamy (ze začátku seznamu), dokud 
+ *        jich je víc než @c cache_limit .
+ *
+ * @param[in] self Ukazatel na strukturu hašovací tabulky.
+ */
+static void hash_map_cache_evict(hash_map_t* self)
+{
+    int dst;
+    while (self->cache_limit > 0 && self->used > self->cache_limit)
+    {
+        hash_map_item_t* item = self->first;
+        if (self->evict_function != NULL)
+        {
+            self->evict_function(self->evict_context, item->key, item->length, item->value, 
+                                 self->value_size > 0 ? hash_map_item_value(item) : NULL);
+        }
+        hash_map_pop_hashed(self, item->key, item->length, item->hash, &dst, NULL);
+        self->cache_stats.evictions++;
+    }
+}
+
+/**
+ * @brief Přepíše hodnotu nastavené velikosti existujícího záznamu na místě 
+ *        @p idx indexu.
+ *
+ * Ve sdíleném režimu čtení může hodnotu právě kopírovat čtenář. Záznam se 
+ * proto nahradí naplněnou kopií, která převezme i dlouhý klíč v aréně, a 
+ * původní záznam se vyřadí.
+ *
+ * @return Záznam s novou hodnotou, nebo @c NULL při chybě alokace.
+ */
+static hash_map_item_t* hash_map_value_update(hash_map_t* self, size_t idx, 
+                                              hash_map_item_t* item, const void* data)
+{
+    if (self->read_policy == HASH_MAP_READ_EXCLUSIVE)
+    {
+        memcpy(hash_map_item_value(item), data, self->value_size);
+        return item;
+    }
+    hash_map_item_t* copy = hash_map_item_alloc(self);
+    if (copy == NULL)
+    {
+        return NULL;
+    }
+    memcpy(copy, item, sizeof(hash_map_item_t));
+    if (item->key == item->inline_key)
+    {
+        copy->key = copy->inline_key;
+    }
+    memcpy(hash_map_item_value(copy), data, self->value_size);
+    // kopie se zverejni az po naplneni, sdileny rezim ma vzdy rozlozeni 
+    // HASH_MAP_LAYOUT_LINKED
+    __atomic_store_n(&self->index[idx], copy, __ATOMIC_RELEASE);
+    if (copy->prev == NULL)
+    {
+        self->first = copy;
+    }
+    else
+    {
+        copy->prev->next = copy;
+    }
+    if (copy->next == NULL)
+    {
+        self->last = copy;
+    }
+    else
+    {
+        copy->next->prev = copy;
+    }
+    hash_map_item_release(self, item);
+    return copy;
+}
+
+/**
+ * @brief Vyhledá záznam s daným klíčem, a pokud v tabulce není, vloží nový.
+ *
+ * Haš se počítá jednou a index se prochází jednou. Zaplnění indexu se 
+ * kontroluje až když je jasné, že se bude vkládat; jen když se kvůli němu 
+ * index přestaví, hledá se volné místo znovu.
+ *
+ * @param[in]  self   Ukazatel na strukturu hašovací tabulky.
+ * @param[in]  key    Klíč.
+ * @param[in]  length Délka klíče v bajtech.
+ * @param[in]  hash   Haš klíče.
+ * @param[in]  value  Hodnota nově vloženého záznamu.
+ * @param[in]  data   Hodnota nastavené velikosti nového i existujícího 
+ *                    záznamu, nebo @c NULL (nový záznam má hodnotu 
+ *                    vynulovanou, existující se nemění).
+ * @param[out] dst    Nalezený nebo vložený záznam.
+ *
+ * @return @c OK pokud byl záznam vložen, @c KEY_ALREADY_EXISTS pokud již 
+ *         existoval, @c VALUE_ERROR pro příliš dlouhý klíč, @c MEMORY_ERROR 
+ *         při chybě alokace.
+ */
+static hash_map_state_code_t hash_map_upsert(hash_map_t* self, const char* key, size_t length, 
+                                             size_t hash, int value, const void* data, 
+                                             hash_map_item_t** dst)
+{
+    if (length > UINT32_MAX)
+    {
+        return VALUE_ERROR;
+    }
+    if (self->allocated == 0 && hash_map_reserve(self, HASH_MAP_INIT_SIZE) != OK)
+    {
+        return MEMORY_ERROR;
+    }
+    hash_map_migrate(self, HASH_MAP_MIGRATE_STEP);
+
+    size_t idx = hash_map_lookup_handle(self, key, length, hash, false);
+    if (self->ctrl[idx] != HASH_MAP_CTRL_EMPTY && self->ctrl[idx] != HASH_MAP_CTRL_DELETED)
+    {
+        *dst = hash_map_slot_get(self, idx);
+        hash_map_cache_touch(self, *dst);
+        if (data != NULL)
+        {
+            *dst = hash_map_value_update(self, idx, *dst, data);
+            if (*dst == NULL)
+            {
+                // alokace pameti selhala
+                return MEMORY_ERROR;
+            }
+        }
+        return KEY_ALREADY_EXISTS;
+    }
+    size_t old_idx;
+    if (hash_map_old_lookup(self, key, length, hash, &old_idx))
+    {
+        // zaznam jeste nebyl presunut do noveho indexu, stary index 
+        // existuje jen bez sdileneho cteni
+        *dst = self->old_index[old_idx];
+        hash_map_cache_touch(self, *dst);
+        if (data != NULL)
+        {
+            memcpy(hash_map_item_value(*dst), data, self->value_size);
+        }
+        return KEY_ALREADY_EXISTS;
+    }
+
+    // je potreba realokovat misto? Do zaplneni se pocitaji i dummy objekty, 
+    // aby v indexu vzdy zustala prazdna mista.
+    bool rebuilt = true;
+    hash_map_state_code_t state = OK;
+    if (((float)(self->used + self->deleted) / (float)self->allocated) >= hash_map_max_load(self))
+    {
+        if (self->deleted > self->used)
+        {
+            // zaplneni tvori hlavne dummy objekty, staci je odstranit
+            state = hash_map_rehash_in_place(self);
+        }
+        else
+        {
+            state = hash_map_reserve(self, self->allocated<<1);
+        }
+    }
+    else if (self->entries_used == self->entries_allocated && 
+             self->layout == HASH_MAP_LAYOUT_COMPACT)
+    {
+        // pole zaznamu je plne odstranenych zaznamu
+        state = hash_map_rehash_in_place(self);
+    }
+    else
+    {
+        rebuilt = false;
+    }
+    if (state != OK)
+    {
+        // index je zaplneny, vlozenim by mohl dojit volna mista a hledani 
+        // by neskoncilo
+        return MEMORY_ERROR;
+    }
+    if (rebuilt)
+    {
+        // pozice v prestavenem indexu
+        idx = hash_map_lookup_handle(self, key, length, hash, false);
+    }
+
+    // prazdne misto v indexu nebo se jedna o dummy objekt, vizte
+    // hash_map_lookup_handle
+    hash_map_item_t* item;
+    if (self->layout == HASH_MAP_LAYOUT_COMPACT)
+    {
+        item = self->entries + self->entries_used;
+    }
+    else
+    {
+        item = hash_map_item_alloc(self);
+        if (item == NULL)
+        {
+            // alokace pameti selhala
+            return MEMORY_ERROR;
+        }
+    }
+    if (length < HASH_MAP_INLINE_KEY_SIZE)
+    {
+        // kratky klic se vejde primo do zaznamu
+        item->key = item->inline_key;
+    }
+    else
+    {
+        item->key = hash_map_key_alloc(self, length);
+        if (item->key == NULL)
+        {
+            // alokace pameti selhala
+            if (self->layout == HASH_MAP_LAYOUT_LINKED)
+            {
+                hash_map_item_free(self, item);
+            }
+            return MEMORY_ERROR;
+        }
+    }
+    memcpy(item->key, key, length);
+    item->key[length] = '\0';
+    item->length = (uint32_t)length;
+    if (self->layout == HASH_MAP_LAYOUT_COMPACT)
+    {
+        self->entries_used++;
+    }
+    if (self->ctrl[idx] == HASH_MAP_CTRL_DELETED)
+    {
+        self->deleted--;
+    }
+    item->hash = hash;
+    item->value = value;
+    item->next = NULL;
+    item->prev = NULL;
+    if (data != NULL)
+    {
+        memcpy(hash_map_item_value(item), data, self->value_size);
+    }
+    else if (self->value_size > 0)
+    {
+        memset(hash_map_item_value(item), 0, self->value_size);
+    }
+    // zaznam se zverejni az po naplneni, ctenari ve sdilenem rezimu 
+    // ho smi najit teprve pote
+    hash_map_place(self, idx, item);
+    self->used++;
+    // je seznam zaznamu prazdny?
+    if (self->last == NULL)
+    {
+        self->first = self->last = item;
+    }
+    else
+    {
+        self->last->next = item;
+        item->prev = self->last;
+        self->last = item;
+    }
+    // novy zaznam je na konci seznamu a limit je alespon 1, odstrani se 
+    // jen starsi zaznamy
+    hash_map_cache_evict(self);
+    *dst = item;
+    return OK;
+}
+
+hash_map_state_code_t hash_map_put_n(hash_map_t* self, const char* key, size_t length, 
+                                     int value)
+{
+    hash_map_item_t* item;
+    hash_map_state_code_t state = hash_map_upsert(self, key, length, self->hash_function(key, length), value, NULL, &item);
+    if (state == KEY_ALREADY_EXISTS)
+    {
+        // hodnotu mohou soubezne cist ctenari ve sdilenem rezimu
+        __atomic_store_n(&item->value, value, __ATOMIC_RELAXED);
+    }
+    return state;
+}
+
+hash_map_state_code_t hash_map_get_or_insert(hash_map_t* self, const char* key, int** value)
+{
+    return hash_map_get_or_insert_n(self, key, strlen(key), value);
+}
+
+hash_map_state_code_t hash_map_get_or_insert_n(hash_map_t* self, const char* key, 
+                                               size_t length, int** value)
+{
+    hash_map_item_t* item;
+    hash_map_state_code_t state = hash_map_upsert(self, key, length, self->hash_function(key, length), 0, NULL, &item);
+    if (state == OK || state == KEY_ALREADY_EXISTS)
+    {
+        *value = &item->value;
+        hash_map_cache_access(self, state == OK ? NULL : item);
+    }
+    return state;
+}
+
+hash_map_state_code_t hash_map_add(hash_map_t* self, const char* key, int delta)
+{
+    return hash_map_add_n(self, key, strlen(key), delta);
+}
+
+hash_map_state_code_t hash_map_add_n(hash_map_t* self, const char* key, size_t length, 
+                                     int delta)
+{
+    hash_map_item_t* item;
+    hash_map_state_code_t state = hash_map_upsert(self, key, length, self->hash_function(key, length), delta, NULL, &item);
+    if (state == KEY_ALREADY_EXISTS)
+    {
+        // zapisovatel je jediny, ctenarum staci atomicky zapis
+        __atomic_store_n(&item->value, item->value + delta, __ATOMIC_RELAXED);
+    }
+    return state;
+}
+
+hash_map_state_code_t hash_map_get(hash_map_t* self, const char* key, int* dst)
+{
+    return hash_map_get_n(self, key, strlen(key), dst);
+}
+
+hash_map_state_code_t hash_map_get_n(hash_map_t* self, const char* key, size_t length, 
+                                     int* dst)
+{
+    if (self->read_policy == HASH_MAP_READ_SHARED)
+    {
+        return hash_map_shared_read(self, key, length, dst, NULL) ? OK : KEY_ERROR;
+    }
+    hash_map_migrate(self, HASH_MAP_MIGRATE_STEP);
+    hash_map_item_t* item = hash_map_find(self, key, length, self->hash_function(key, length));
+    hash_map_cache_access(self, item);
+
+    if (item == NULL)
+    {
+        // klic neni asociovan se zadnym zaznamem
+        return KEY_ERROR;
+    }
+    
+    *dst = item->value;
+
+    return OK;
+}
+
+hash_map_state_code_t hash_map_remove(hash_map_t* self, const char* key)
+{
+    int dst;
+    return hash_map_pop_n(self, key, strlen(key), &dst);
+}
+
+hash_map_state_code_t hash_map_remove_n(hash_map_t* self, const char* key, size_t length)
+{
+    int dst;
+    return hash_map_pop_n(self, key, length, &dst);
+}
+
+hash_map_state_code_t hash_map_pop(hash_map_t* self, const char* key, int* dst)
+{
+    return hash_map_pop_n(self, key, strlen(key), dst);
+}
+
+hash_map_state_code_t hash_map_pop_n(hash_map_t* self, const char* key, size_t length, 
+                                     int* dst)
+{
+    return hash_map_pop_hashed(self, key, length, self->hash_function(key, length), dst, NULL);
+}
+
+/** Počet klíčů, jejichž načítání z paměti se v dávkových operacích překrývá. */
+static const size_t HASH_MAP_BATCH_SIZE = 32;
+
+/**
+ * @brief Spočte haše dávky klíčů a načte do cache vše, co bude hledání 
+ *        potřebovat.
+ *
+ * Nejdříve se pro všechny klíče vyžádají řídicí bajty a místa indexu, pak 
+ * (když už většina dorazila) záznamy s odpovídajícím otiskem. Cache miss 
+ * jednotlivých klíčů se tak překrývají.
+ */
+static void hash_map_prefetch_batch(hash_map_t* self, const char* const* keys, size_t count, 
+                                    size_t* lengths, size_t* hashes)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        lengths[i] = strlen(keys[i]);
+        hashes[i] = self->hash_function(keys[i], lengths[i]);
+        hash_map_prefetch_slot(self, hashes[i]);
+    }
+    for (size_t i = 0; i < count; i++)
+    {
+        hash_map_prefetch_item(self, hashes[i]);
+    }
+}
+
+size_t hash_map_get_many(hash_map_t* self, size_t count, const char* const* keys, 
+                         int* values, hash_map_state_code_t* states)
+{
+    size_t lengths[HASH_MAP_BATCH_SIZE];
+    size_t hashes[HASH_MAP_BATCH_SIZE];
+    size_t found = 0;
+
+    if (self->read_policy == HASH_MAP_READ_SHARED)
+    {
+        // ctenar nesmi sahat na index zapisovatele, kazdy klic se hleda v pohledu
+        for (size_t i = 0; i < count; i++)
+        {
+            bool hit = hash_map_shared_read(self, keys[i], strlen(keys[i]), &values[i], NULL);
+            found += hit;
+            if (states != NULL)
+            {
+                states[i] = hit ? OK : KEY_ERROR;
+            }
+        }
+        return found;
+    }
+
+    for (size_t base = 0; base < count; base += HASH_MAP_BATCH_SIZE)
+    {
+        size_t batch = count - base < HASH_MAP_BATCH_SIZE ? count - base : HASH_MAP_BATCH_SIZE;
+        hash_map_migrate(self, HASH_MAP_MIGRATE_STEP);
+        hash_map_prefetch_batch(self, keys + base, batch, lengths, hashes);
+        for (size_t i = 0; i < batch; i++)
+        {
+            hash_map_item_t* item = hash_map_find(self, keys[base + i], lengths[i], hashes[i]);
+            hash_map_cache_access(self, item);
+            bool hit = item != NULL;
+            if (hit)
+            {
+                values[base + i] = item->value;
+                found++;
+            }
+            if (states != NULL)
+            {
+                states[base + i] = hit ? OK : KEY_ERROR;
+            }
+        }
+    }
+
+    return found;
+}
+
+hash_map_state_code_t hash_map_put_many(hash_map_t* self, size_t count, const char* const* keys, 
+                                        const int* values, hash_map_state_code_t* states)
+{
+    size_t lengths[HASH_MAP_BATCH_SIZE];
+    size_t hashes[HASH_MAP_BATCH_SIZE];
+
+    if (self->allocated == 0 && hash_map_reserve(self, HASH_MAP_INIT_SIZE) != OK)
+    {
+        return MEMORY_ERROR;
+    }
+    for (size_t base = 0; base < count; base += HASH_MAP_BATCH_SIZE)
+    {
+        size_t batch = count - base < HASH_MAP_BATCH_SIZE ? count - base : HASH_MAP_BATCH_SIZE;
+        hash_map_prefetch_batch(self, keys + base, batch, lengths, hashes);
+        for (size_t i = 0; i < batch; i++)
+        {
+            hash_map_item_t* item;
+            hash_map_state_code_t state = hash_map_upsert(self, keys[base + i], lengths[i], 
+                                                          hashes[i], values[base + i], NULL, &item);
+            if (state == KEY_ALREADY_EXISTS)
+            {
+                __atomic_store_n(&item->value, values[base + i], __ATOMIC_RELAXED);
+            }
+            if (states != NULL)
+            {
+                states[base + i] = state;
+            }
+            if (state == MEMORY_ERROR || state == VALUE_ERROR)
+            {
+                // zbyvajici klice se nevlozi
+                return state;
+            }
+        }
+    }
+
+    return OK;
+}
+
+/*******************************************************************************
+ * Hodnoty libovolného typu
+ ******************************************************************************/
+
+hash_map_state_code_t hash_map_set_value_size(hash_map_t* self, size_t size)
+{
+    size_t limit = (SIZE_MAX - sizeof(hash_map_item_t)) / HASH_MAP_SLAB_MAX_ITEMS - 
+                   HASH_MAP_VALUE_ALIGN;
+    if (self->used > 0 || self->layout == HASH_MAP_LAYOUT_COMPACT || size > limit)
+    {
+        return VALUE_ERROR;
+    }
+    // bloky a uvolnene zaznamy maji velikost podle predchozi hodnoty
+    hash_map_clear(self);
+    self->value_size = size;
+    self->item_size = sizeof(hash_map_item_t) + 
+                      ((size + HASH_MAP_VALUE_ALIGN - 1) & ~(size_t)(HASH_MAP_VALUE_ALIGN - 1));
+    return OK;
+}
+
+hash_map_state_code_t hash_map_put_value(hash_map_t* self, const char* key, 
+                                         const void* value)
+{
+    return hash_map_put_value_n(self, key, strlen(key), value);
+}
+
+hash_map_state_code_t hash_map_put_value_n(hash_map_t* self, const char* key, 
+                                           size_t length, const void* value)
+{
+    hash_map_item_t* item;
+    // hodnota se zkopiruje pred zverejnenim zaznamu
+    return hash_map_upsert(self, key, length, self->hash_function(key, length), 0, value, &item);
+}
+
+hash_map_state_code_t hash_map_get_value(hash_map_t* self, const char* key, void* value)
+{
+    return hash_map_get_value_n(self, key, strlen(key), value);
+}
+
+hash_map_state_code_t hash_map_get_value_n(hash_map_t* self, const char* key, 
+                                           size_t length, void* value)
+{
+    if (self->read_policy == HASH_MAP_READ_SHARED)
+    {
+        return hash_map_shared_read(self, key, length, NULL, value) ? OK : KEY_ERROR;
+    }
+    void* stored;
+    hash_map_state_code_t state = hash_map_get_value_ptr_n(self, key, length, &stored);
+    if (state == OK)
+    {
+        memcpy(value, stored, self->value_size);
+    }
+    return state;
+}
+
+hash_map_state_code_t hash_map_get_value_ptr(hash_map_t* self, const char* key, void** value)
+{
+    return hash_map_get_value_ptr_n(self, key, strlen(key), value);
+}
+
+hash_map_state_code_t hash_map_get_value_ptr_n(hash_map_t* self, const char* key, 
+                                               size_t length, void** value)
+{
+    if (self->read_policy == HASH_MAP_READ_SHARED)
+    {
+        return VALUE_ERROR;
+    }
+    hash_map_migrate(self, HASH_MAP_MIGRATE_STEP);
+    hash_map_item_t* item = hash_map_find(self, key, length, self->hash_function(key, length));
+    hash_map_cache_access(self, item);
+    if (item == NULL)
+    {
+        // klic neni asociovan se zadnym zaznamem
+        return KEY_ERROR;
+    }
+    *value = hash_map_item_value(item);
+    return OK;
+}
+
+hash_map_state_code_t hash_map_pop_value(hash_map_t* self, const char* key, void* value)
+{
+    return hash_map_pop_value_n(self, key, strlen(key), value);
+}
+
+hash_map_state_code_t hash_map_pop_value_n(hash_map_t* self, const char* key, 
+                                           size_t length, void* value)
+{
+    int dst;
+    return hash_map_pop_hashed(self, key, length, self->hash_function(key, length), &dst, value);
+}
+
+/*******************************************************************************
+ * Režim cache
+ ******************************************************************************/
+
+hash_map_state_code_t hash_map_set_cache_limit(hash_map_t* self, size_t limit)
+{
+    if (limit > 0 && (self->layout == HASH_MAP_LAYOUT_COMPACT || 
+                      self->read_policy == HASH_MAP_READ_SHARED))
+    {
+        return VALUE_ERROR;
+    }
+    self->cache_limit = limit;
+    hash_map_cache_evict(self);
+    return OK;
+}
+
+hash_map_state_code_t hash_map_set_evict_function(hash_map_t* self, 
+                                                  hash_map_evict_function_t function, 
+                                                  void* context)
+{
+    self->evict_function = function;
+    self->evict_context = context;
+    return OK;
+}
+
+hash_map_cache_stats_t hash_map_cache_stats(hash_map_t* self)
+{
+    return self->cache_stats;
+}
+
+/*******************************************************************************
+ * Statistiky
+ ******************************************************************************/
+/**
+ * @brief Délka hledání haše v indexu, viz hash_map_stats_t.
+ *
+ * Prochází index stejně jako hledání daného enginu, záznamy ale porovnává 
+ * podle ukazatele.
+ *
+ * @param[in] self   Ukazatel na strukturu hašovací tabulky.
+ * @param[in] hash   Haš.
+ * @param[in] target Hledaný záznam, nebo @c NULL pro neúspěšné hledání.
+ *
+ * @return Počet míst (engine skupin: skupin) navštívených za prvním.
+ */
+static size_t hash_map_probe_length(hash_map_t* self, size_t hash, 
+                                    const hash_map_item_t* target)
+{
+    uint8_t tag = hash_map_tag(hash);
+    if (self->engine == HASH_MAP_ENGINE_GROUPS)
+    {
+        size_t pos = hash & self->mask & ~(size_t)(HASH_MAP_GROUP_SIZE - 1);
+        size_t step = 0;
+        for (size_t probes = 0; ; probes++)
+        {
+            const uint8_t* group = self->ctrl + pos;
+            for (uint32_t match = target != NULL ? hash_map_group_match(group, tag) : 0; 
+                 match != 0; match &= match - 1)
+            {
+                if (hash_map_slot_get(self, pos + hash_map_lowest_bit(match)) == target)
+                {
+                    return probes;
+                }
+            }
+            if (hash_map_group_match(group, HASH_MAP_CTRL_EMPTY) != 0)
+            {
+                return probes;
+            }
+            step += HASH_MAP_GROUP_SIZE;
+            pos = (pos + step) & self->mask;
+        }
+    }
+
+    size_t idx = hash_map_home(self, hash);
+    size_t perturb = hash;
+    bool masked = self->mask + 1 == self->allocated;
+    size_t probes = 0;
+    for (; self->ctrl[idx] != HASH_MAP_CTRL_EMPTY; probes++)
+    {
+        if (self->engine == HASH_MAP_ENGINE_ROBIN_HOOD && hash_map_robin_distance(self, idx) < probes)
+        {
+            // hledany klic by lezel pred timto zaznamem
+            break;
+        }
+        if (target != NULL && self->ctrl[idx] == tag && hash_map_slot_get(self, idx) == target)
+        {
+            break;
+        }
+        if (masked && self->engine == HASH_MAP_ENGINE_PROBING)
+        {
+            idx = ((idx << 2) + idx + perturb + 1) & self->mask;
+            perturb >>= HASH_MAP_PERTURB_SHIFT;
+        }
+        else if (++idx == self->allocated)
+        {
+            idx = 0;
+        }
+    }
+    return probes;
+}
+
+/**
+ * @brief Velikost bloků seznamu včetně hlaviček v bajtech.
+ */
+static size_t hash_map_blocks_size(const hash_map_block_t* list)
+{
+    size_t bytes = 0;
+    for (; list != NULL; list = list->next)
+    {
+        bytes += sizeof(hash_map_block_t) + list->size;
+    }
+    return bytes;
+}
+
+/**
+ * @brief Započte do statistik úspěšné hledání délky @p probes .
+ *
+ * Průměr se zatím sčítá, vydělí se počtem záznamů na konci.
+ */
+static inline void hash_map_stats_hit(hash_map_stats_t* stats, size_t probes)
+{
+    stats->probe_histogram[probes < HASH_MAP_STATS_HISTOGRAM_SIZE ? probes 
+                               : HASH_MAP_STATS_HISTOGRAM_SIZE - 1]++;
+    stats->hit_probe_max = probes > stats->hit_probe_max ? probes : stats->hit_probe_max;
+    stats->hit_probe_avg += (double)probes;
+}
+
+hash_map_stats_t hash_map_stats(hash_map_t* self)
+{
+    hash_map_stats_t stats;
+    memset(&stats, 0, sizeof(stats));
+    // zaznamy se behem postupneho zvetsovani nepresouvaji, starym indexem 
+    // se prochazi kopie tabulky s prohozenymi indexy
+    bool incremental = self->old_ctrl != NULL;
+    hash_map_t old;
+    if (incremental)
+    {
+        old = *self;
+        hash_map_swap_index(&old);
+    }
+
+    stats.size = self->used;
+    stats.capacity = self->allocated;
+    stats.tombstones = self->deleted;
+    if (self->allocated > 0)
+    {
+        stats.load_factor = (double)self->used / (double)self->allocated;
+        stats.occupied_factor = (double)(self->used + self->deleted) / (double)self->allocated;
+    }
+
+    for (size_t idx = 0; idx < self->allocated; idx++)
+    {
+        if (self->ctrl[idx] != HASH_MAP_CTRL_EMPTY && self->ctrl[idx] != HASH_MAP_CTRL_DELETED)
+        {
+            hash_map_item_t* item = hash_map_slot_get(self, idx);
+            hash_map_stats_hit(&stats, hash_map_probe_length(self, item->hash, item));
+        }
+    }
+    for (size_t idx = 0; incremental && idx < old.allocated; idx++)
+    {
+        if (old.ctrl[idx] != HASH_MAP_CTRL_EMPTY && old.ctrl[idx] != HASH_MAP_CTRL_DELETED)
+        {
+            // zaznam se nejdriv neuspesne hleda v novem indexu
+            hash_map_item_t* item = old.index[idx];
+            hash_map_stats_hit(&stats, hash_map_probe_length(self, item->hash, NULL) + 1 + 
+                                       hash_map_probe_length(&old, item->hash, item));
+        }
+    }
+    if (self->used > 0)
+    {
+        stats.hit_probe_avg /= (double)self->used;
+    }
+
+    size_t samples = self->allocated < HASH_MAP_STATS_MISS_SAMPLES ? self->allocated 
+                                                                    : HASH_MAP_STATS_MISS_SAMPLES;
+    size_t total = 0;
+    for (size_t i = 0; i < samples; i++)
+    {
+        size_t hash = (size_t)hash_mix(i + 1, HASH_SECRET[3]);
+        size_t probes = hash_map_probe_length(self, hash, NULL);
+        if (incremental)
+        {
+            probes += 1 + hash_map_probe_length(&old, hash, NULL);
+        }
+        stats.miss_probe_max = probes > stats.miss_probe_max ? probes : stats.miss_probe_max;
+        total += probes;
+    }
+    if (samples > 0)
+    {
+        stats.miss_probe_avg = (double)total / (double)samples;
+    }
+
+    // struktura a dummy objekt, index s ridicimi bajty, bloky a pole zaznamu
+    stats.bytes = sizeof(hash_map_t) + sizeof(hash_map_item_t) + hash_map_ctrl_bytes(self);
+    if (self->layout == HASH_MAP_LAYOUT_COMPACT)
+    {
+        stats.bytes += self->allocated * self->slot_width + 
+                       self->entries_allocated * sizeof(hash_map_item_t);
+    }
+    else
+    {
+        stats.bytes += self->allocated * sizeof(hash_map_item_t*);
+    }
+    if (incremental)
+    {
+        stats.bytes += old.allocated * sizeof(hash_map_item_t*) + hash_map_ctrl_bytes(&old);
+    }
+    stats.bytes += hash_map_blocks_size(self->slabs) + hash_map_blocks_size(self->arena);
+    if (self->view != NULL)
+    {
+        stats.bytes += sizeof(hash_map_t);
+    }
+    // vyrazena pamet se uvolni az po skonceni cteni
+    for (const hash_map_retired_t* retired = self->retired; retired != NULL; retired = retired->next)
+    {
+        stats.bytes += sizeof(hash_map_retired_t) + retired->size;
+    }
+#ifdef HASH_MAP_STATS_RESIZE
+    stats.resizes = self->resizes;
+    stats.resize_ns = self->resize_ns;
+#endif
+    return stats;
+}
+
+/*******************************************************************************
+ * Zmrazená tabulka
+ ******************************************************************************/
+/** Počet bitů posunu v posunutí skupiny zmrazené tabulky. */
+static const unsigned HASH_MAP_FROZEN_SHIFT_BITS = 40;
+
+/**
+ * @brief Zobrazí 64bitové číslo na interval <0, @p range ) násobením.
+ */
+static inline size_t hash_map_fastrange(uint64_t value, size_t range)
+{
+#if defined(__SIZEOF_INT128__)
+    return (size_t)(((unsigned __int128)value * range) >> 64);
+#else
+    return (size_t)(((uint64_t)(uint32_t)(value >> 32) * range) >> 32);
+#endif
+}
+
+/**
+ * @brief Místo klíče s hašem @p hash ve zmrazené tabulce před posunem.
+ *
+ * @param[in] hash Výchozí haš klíče.
+ * @param[in] seed Číslo míchání skupiny klíče.
+ * @param[in] size Počet míst.
+ */
+static inline size_t hash_map_frozen_base(uint64_t hash, uint64_t seed, size_t size)
+{
+    return hash_map_fastrange(hash_mix(hash ^ (seed * HASH_SECRET[0]), HASH_SECRET[1]), size);
+}
+
+/**
+ * @brief Jediné místo, na kterém může být klíč s hašem @p hash .
+ *
+ * @param[in] self Ukazatel na neprázdnou zmrazenou tabulku.
+ * @param[in] hash Výchozí haš klíče.
+ */
+static inline size_t hash_map_frozen_slot(const hash_map_frozen_t* self, uint64_t hash)
+{
+    uint64_t displacement = self->displacement[hash_map_fastrange(hash, self->buckets)];
+    size_t idx = hash_map_frozen_base(hash, displacement >> HASH_MAP_FROZEN_SHIFT_BITS, self->size) + 
+                 (size_t)(displacement & ((1ULL << HASH_MAP_FROZEN_SHIFT_BITS) - 1));
+    return idx >= self->size ? idx - self->size : idx;
+}
+
+/**
+ * @brief Najde místo klíče ve zmrazené tabulce.
+ *
+ * Tabulka načtená ze souboru se při otevření neprochází, místo i rozsah 
+ * klíče se proto ověří až při hledání. Poškozený soubor tak vede jen k 
+ * nenalezení klíče, nikdy ke čtení mimo data.
+ *
+ * @return Místo klíče, nebo @c size pokud klíč v tabulce není.
+ */
+static size_t hash_map_frozen_find(const hash_map_frozen_t* self, const char* key, 
+                                   size_t length)
+{
+    if (self->size == 0)
+    {
+        return 0;
+    }
+    size_t idx = hash_map_frozen_slot(self, hash_map_default_hash(key, length));
+    if (idx >= self->size)
+    {
+        return self->size;
+    }
+    size_t begin = self->offsets[idx];
+    size_t end = self->offsets[idx + 1];
+    if (begin > end || end > self->offsets[self->size] || end - begin != length || 
+        memcmp(self->keys + begin, key, length) != 0)
+    {
+        return self->size;
+    }
+    return idx;
+}
+
+/**
+ * @brief Najde posunutí skupiny, které umístí všechny její klíče na volná 
+ *        místa, a místa obsadí.
+ *
+ * @param[in]     hashes Haše klíčů skupiny.
+ * @param[in]     count  Počet klíčů skupiny.
+ * @param[in]     size   Počet míst.
+ * @param[in,out] taken  Obsazená místa.
+ * @param[out]    slots  Místa klíčů skupiny.
+ * @param[out]    displacement Posunutí skupiny.
+ *
+ * @return @c false pokud žádné posunutí nevyhovuje.
+ */
+static bool hash_map_frozen_place(const uint64_t* hashes, size_t count, size_t size, 
+                                  bool* taken, size_t* slots, uint64_t* displacement)
+{
+    // nejdriv se zkousi jen cisla michani bez posunu (nahodna mista), posun 
+    // hledajici volna mista za sebou by tabulku plnil ve shlucich
+    for (int pass = 0; pass < 2; ++pass)
+    {
+        size_t shifts = pass == 0 ? 1 : size;
+        for (uint64_t seed = 0; seed < HASH_MAP_FROZEN_MAX_SEEDS; ++seed)
+        {
+            // klice skupiny se nesmi prekryvat ani mezi sebou
+            bool distinct = true;
+            for (size_t i = 0; i < count && distinct; ++i)
+            {
+                slots[i] = hash_map_frozen_base(hashes[i], seed, size);
+                for (size_t j = 0; j < i && distinct; ++j)
+                {
+                    distinct = slots[i] != slots[j];
+                }
+            }
+            for (size_t shift = 0; shift < shifts && distinct; ++shift)
+            {
+                size_t i = 0;
+                for (; i < count; ++i)
+                {
+                    size_t idx = slots[i] + shift;
+                    if (taken[idx >= size ? idx - size : idx])
+                    {
+                        break;
+                    }
+                }
+                if (i < count)
+                {
+                    continue;
+                }
+                for (i = 0; i < count; ++i)
+                {
+                    slots[i] += shift;
+                    slots[i] -= slots[i] >= size ? size : 0;
+                    taken[slots[i]] = true;
+                }
+                *displacement = (seed << HASH_MAP_FROZEN_SHIFT_BITS) | shift;
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Rozmístí záznamy na místa zmrazené tabulky.
+ *
+ * Skupiny se umisťují od největší, dokud je tabulka prázdná a pro velké 
+ * skupiny je snadné najít volná místa.
+ *
+ * @param[in,out] frozen Zmrazená tabulka s nastaveným počtem míst a skupin.
+ * @param[in]     items  Záznamy v pořadí seznamu.
+ * @param[out]    placed Záznamy v pořadí míst.
+ *
+ * @return @c MEMORY_ERROR , @c VALUE_ERROR nebo @c OK .
+ */
+static hash_map_state_code_t hash_map_frozen_build(hash_map_frozen_t* frozen, 
+                                                   hash_map_item_t** items, 
+                                                   hash_map_item_t** placed)
+{
+    size_t size = frozen->size, buckets = frozen->buckets;
+    // pracovni pameti v jednom bloku: hase, poradi podle skupin, zacatky 
+    // skupin, skupiny podle velikosti a obsazena mista
+    char* work = (char*)malloc(size * (sizeof(uint64_t) + sizeof(size_t) + sizeof(bool)) + 
+                               (2 * buckets + 1) * sizeof(size_t));
+    if (work == NULL)
+    {
+        return MEMORY_ERROR;
+    }
+    uint64_t* hashes = (uint64_t*)work;
+    size_t* order = (size_t*)(hashes + size);
+    size_t* start = order + size;
+    size_t* by_size = start + buckets + 1;
+    bool* taken = (bool*)(by_size + buckets);
+    memset(start, 0, (buckets + 1) * sizeof(size_t));
+    memset(taken, 0, size * sizeof(bool));
+
+    // razeni zaznamu podle skupin pocitanim
+    for (size_t i = 0; i < size; ++i)
+    {
+        hashes[i] = hash_map_default_hash(items[i]->key, items[i]->length);
+        start[hash_map_fastrange(hashes[i], buckets) + 1]++;
+    }
+    size_t largest = 0;
+    for (size_t b = 0; b < buckets; ++b)
+    {
+        largest = start[b + 1] > largest ? start[b + 1] : largest;
+        start[b + 1] += start[b];
+    }
+    for (size_t i = 0; i < size; ++i)
+    {
+        size_t b = hash_map_fastrange(hashes[i], buckets);
+        order[start[b]++] = i;
+    }
+    // start[b] ted ukazuje na konec skupiny b
+    memmove(start + 1, start, buckets * sizeof(size_t));
+    start[0] = 0;
+
+    // skupiny od nejvetsi, prazdne skupiny se neumistuji
+    size_t count = 0;
+    for (size_t length = largest; length > 0; --length)
+    {
+        for (size_t b = 0; b < buckets; ++b)
+        {
+            if (start[b + 1] - start[b] == length)
+            {
+                by_size[count++] = b;
+            }
+        }
+    }
+
+    uint64_t group[HASH_MAP_FROZEN_BUCKET_SIZE * 8];
+    size_t slots[HASH_MAP_FROZEN_BUCKET_SIZE * 8];
+    size_t next_free = 0;
+    bool success = largest <= sizeof(group) / sizeof(group[0]);
+    for (size_t k = 0; k < count && success; ++k)
+    {
+        size_t b = by_size[k], length = start[b + 1] - start[b];
+        for (size_t i = 0; i < length; ++i)
         {
-            self->first = self->index[idx]->next;
+            group[i] = hashes[order[start[b] + i]];
         }
-        else 
+        if (length == 1)
         {
-            self->index[idx]->prev->next = self->index[idx]->next;
+            // samostatny klic (skupiny jsou na konci) se posune na dalsi 
+            // volne misto bez hledani
+            while (taken[next_free])
+            {
+                next_free++;
+            }
+            size_t base = hash_map_frozen_base(group[0], 0, size);
+            slots[0] = next_free;
+            taken[next_free] = true;
+            frozen->displacement[b] = next_free >= base ? next_free - base 
+                                                        : next_free + size - base;
         }
-        // jedna se o posledni zaznam v seznamu?
-        if (self->index[idx]->next == NULL)
+        else
         {
-            self->last = self->index[idx]->prev;
+            success = hash_map_frozen_place(group, length, size, taken, slots, 
+                                            &frozen->displacement[b]);
         }
-        else 
+        for (size_t i = 0; i < length && success; ++i)
         {
-            self->index[idx]->next->prev = self->index[idx]->prev;
+            placed[slots[i]] = items[order[start[b] + i]];
         }
-        // uloz hodnotu
-        *dst = self->index[idx]->value;
-        // smaz zaznam
-        free(self->index[idx]->key);
-        free(self->index[idx]);
-        // Nahrazeni zaznamu za dummy objekt.
-        // V pripade kolize, odstraneni prvne vlozeneho zaznamu s kolizi,
-        // a nastaveni daneho mista na NULL, algoritmus by nemel informaci, 
-        // zda ke kolizi doslo.
-        self->index[idx] = self->dummy;
+    }
+    free(work);
+    return success ? OK : VALUE_ERROR;
+}
+
+hash_map_state_code_t hash_map_freeze(hash_map_t* self, hash_map_frozen_t** frozen)
+{
+    size_t size = self->used;
+    size_t buckets = (size + HASH_MAP_FROZEN_BUCKET_SIZE - 1) / HASH_MAP_FROZEN_BUCKET_SIZE;
+    size_t key_bytes = 0;
+    if (size >= (1ULL << HASH_MAP_FROZEN_SHIFT_BITS))
+    {
+        return VALUE_ERROR;
+    }
+    hash_map_item_t** items = (hash_map_item_t**)malloc((2 * size + 1) * sizeof(hash_map_item_t*));
+    if (items == NULL)
+    {
+        return MEMORY_ERROR;
+    }
+    size_t count = 0;
+    for (hash_map_item_t* item = self->first; item != NULL; item = item->next)
+    {
+        items[count++] = item;
+        key_bytes += item->length;
+    }
+
+    // jediny blok: struktura, posunuti, zacatky klicu, hodnoty a klice
+    size_t bytes = sizeof(hash_map_frozen_t) + buckets * sizeof(uint64_t) + 
+                   (size + 1) * sizeof(size_t) + size * sizeof(int) + 
+                   size * self->value_size + key_bytes;
+    hash_map_frozen_t* result = (hash_map_frozen_t*)malloc(bytes);
+    if (result == NULL)
+    {
+        free(items);
+        return MEMORY_ERROR;
+    }
+    result->size = size;
+    result->buckets = buckets;
+    result->displacement = (uint64_t*)(result + 1);
+    result->offsets = (size_t*)(result->displacement + buckets);
+    result->values = (int*)(result->offsets + size + 1);
+    result->value_size = self->value_size;
+    result->value_data = (char*)(result->values + size);
+    result->keys = result->value_data + size * self->value_size;
+    result->bytes = bytes;
+    result->mapping = NULL;
+    // chybejici klice mohou padnout i do prazdne skupiny
+    memset(result->displacement, 0, buckets * sizeof(uint64_t));
+
+    hash_map_item_t** placed = items + size;
+    hash_map_state_code_t state = hash_map_frozen_build(result, items, placed);
+    if (state != OK)
+    {
+        free(items);
+        free(result);
+        return state;
+    }
+    result->offsets[0] = 0;
+    for (size_t i = 0; i < size; ++i)
+    {
+        hash_map_item_t* item = placed[i];
+        memcpy(result->keys + result->offsets[i], item->key, item->length);
+        result->offsets[i + 1] = result->offsets[i] + item->length;
+        result->values[i] = item->value;
+        if (self->value_size > 0)
+        {
+            memcpy(result->value_data + i * self->value_size, hash_map_item_value(item), 
+                   self->value_size);
+        }
+    }
+    free(items);
+    *frozen = result;
+    return OK;
+}
+
+void hash_map_frozen_dtor(hash_map_frozen_t* self)
+{
+    if (self->mapping != NULL)
+    {
+        munmap(self->mapping, self->bytes);
+    }
+    free(self);
+}
+
+size_t hash_map_frozen_size(const hash_map_frozen_t* self)
+{
+    return self->size;
+}
+
+bool hash_map_frozen_contains(const hash_map_frozen_t* self, const char* key)
+{
+    return hash_map_frozen_contains_n(self, key, strlen(key));
+}
+
+bool hash_map_frozen_contains_n(const hash_map_frozen_t* self, const char* key, 
+                                size_t length)
+{
+    return hash_map_frozen_find(self, key, length) < self->size;
+}
+
+hash_map_state_code_t hash_map_frozen_get(const hash_map_frozen_t* self, const char* key, 
+                                          int* value)
+{
+    return hash_map_frozen_get_n(self, key, strlen(key), value);
+}
+
+hash_map_state_code_t hash_map_frozen_get_n(const hash_map_frozen_t* self, const char* key, 
+                                            size_t length, int* value)
+{
+    size_t idx = hash_map_frozen_find(self, key, length);
+    if (idx >= self->size)
+    {
+        return KEY_ERROR;
+    }
+    *value = self->values[idx];
+    return OK;
+}
+
+hash_map_state_code_t hash_map_frozen_get_value(const hash_map_frozen_t* self, 
+                                                const char* key, void* value)
+{
+    return hash_map_frozen_get_value_n(self, key, strlen(key), value);
+}
+
+hash_map_state_code_t hash_map_frozen_get_value_n(const hash_map_frozen_t* self, 
+                                                  const char* key, size_t length, 
+                                                  void* value)
+{
+    if (self->value_size == 0)
+    {
+        return VALUE_ERROR;
+    }
+    size_t idx = hash_map_frozen_find(self, key, length);
+    if (idx >= self->size)
+    {
+        return KEY_ERROR;
+    }
+    memcpy(value, self->value_data + idx * self->value_size, self->value_size);
+    return OK;
+}
+
+/** Značka na začátku souboru zmrazené tabulky. */
+static const char HASH_MAP_FILE_MAGIC[8] = {'H', 'M', 'F', 'R', 'O', 'Z', 'E', 'N'};
+/** Verze formátu souboru zmrazené tabulky. */
+static const uint32_t HASH_MAP_FILE_VERSION = 1;
+/** Kontrola pořadí bajtů v hlavičce souboru. */
+static const uint64_t HASH_MAP_FILE_ENDIAN = 0x0102030405060708ULL;
+
+/**
+ * @brief Hlavička souboru zmrazené tabulky (64 bajtů), za ní následují pole.
+ */
+typedef struct hash_map_file_header
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t word_size;
+    uint64_t endian;
+    uint64_t size;
+    uint64_t buckets;
+    uint64_t value_size;
+    uint64_t key_bytes;
+    uint64_t reserved;
+} hash_map_file_header_t;
+
+/**
+ * @brief Délka polí zmrazené tabulky v souboru za hlavičkou.
+ *
+ * @return Délka v bajtech, nebo 0 pokud by délka přetekla.
+ */
+static size_t hash_map_file_data_size(const hash_map_file_header_t* header)
+{
+    uint64_t size = header->size;
+    if (size >= (1ULL << HASH_MAP_FROZEN_SHIFT_BITS) || header->buckets > size || 
+        (size > 0 && header->buckets == 0) || 
+        (header->value_size > 0 && size > 0 && 
+         header->value_size > (SIZE_MAX >> 2) / size) || 
+        header->key_bytes > (SIZE_MAX >> 2))
+    {
+        return 0;
+    }
+    return header->buckets * sizeof(uint64_t) + (size + 1) * sizeof(size_t) + 
+           size * sizeof(int) + size * header->value_size + header->key_bytes;
+}
+
+hash_map_state_code_t hash_map_frozen_save(const hash_map_frozen_t* self, const char* path)
+{
+    hash_map_file_header_t header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, HASH_MAP_FILE_MAGIC, sizeof(header.magic));
+    header.version = HASH_MAP_FILE_VERSION;
+    header.word_size = sizeof(size_t);
+    header.endian = HASH_MAP_FILE_ENDIAN;
+    header.size = self->size;
+    header.buckets = self->buckets;
+    header.value_size = self->value_size;
+    header.key_bytes = self->offsets[self->size];
+
+    FILE* file = fopen(path, "wb");
+    if (file == NULL)
+    {
+        return IO_ERROR;
+    }
+    bool written = 
+        fwrite(&header, sizeof(header), 1, file) == 1 && 
+        fwrite(self->displacement, sizeof(uint64_t), self->buckets, file) == self->buckets && 
+        fwrite(self->offsets, sizeof(size_t), self->size + 1, file) == self->size + 1 && 
+        fwrite(self->values, sizeof(int), self->size, file) == self->size && 
+        fwrite(self->value_data, 1, self->size * self->value_size, file) == self->size * self->value_size && 
+        fwrite(self->keys, 1, header.key_bytes, file) == header.key_bytes;
+    // chyba zapisu vyrovnavaci pameti se projevi az pri zavreni
+    if (fclose(file) != 0 || !written)
+    {
+        return IO_ERROR;
+    }
+    return OK;
+}
+
+hash_map_state_code_t hash_map_save(hash_map_t* self, const char* path)
+{
+    hash_map_frozen_t* frozen;
+    hash_map_state_code_t state = hash_map_freeze(self, &frozen);
+    if (state != OK)
+    {
+        return state;
+    }
+    state = hash_map_frozen_save(frozen, path);
+    hash_map_frozen_dtor(frozen);
+    return state;
+}
+
+hash_map_state_code_t hash_map_frozen_load(const char* path, hash_map_frozen_t** frozen)
+{
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+    {
+        return IO_ERROR;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0)
+    {
+        close(fd);
+        return IO_ERROR;
+    }
+    if ((size_t)info.st_size < sizeof(hash_map_file_header_t))
+    {
+        close(fd);
+        return VALUE_ERROR;
+    }
+    size_t bytes = (size_t)info.st_size;
+    void* mapping = mmap(NULL, bytes, PROT_READ, MAP_SHARED, fd, 0);
+    // namapovani drzi soubor otevreny i po zavreni deskriptoru
+    close(fd);
+    if (mapping == MAP_FAILED)
+    {
+        return IO_ERROR;
     }
 
+    const hash_map_file_header_t* header = (const hash_map_file_header_t*)mapping;
+    size_t data_size = hash_map_file_data_size(header);
+    if (memcmp(header->magic, HASH_MAP_FILE_MAGIC, sizeof(header->magic)) != 0 || 
+        header->version != HASH_MAP_FILE_VERSION || header->word_size != sizeof(size_t) || 
+        header->endian != HASH_MAP_FILE_ENDIAN || data_size == 0 || 
+        bytes != sizeof(hash_map_file_header_t) + data_size)
+    {
+        munmap(mapping, bytes);
+        return VALUE_ERROR;
+    }
+    hash_map_frozen_t* result = (hash_map_frozen_t*)malloc(sizeof(hash_map_frozen_t));
+    if (result == NULL)
+    {
+        munmap(mapping, bytes);
+        return MEMORY_ERROR;
+    }
+    // pole lezi v souboru ve stejnem poradi jako v bloku hash_map_freeze
+    result->size = header->size;
+    result->buckets = header->buckets;
+    result->displacement = (uint64_t*)(header + 1);
+    result->offsets = (size_t*)(result->displacement + result->buckets);
+    result->values = (int*)(result->offsets + result->size + 1);
+    result->value_size = header->value_size;
+    result->value_data = (char*)(result->values + result->size);
+    result->keys = result->value_data + result->size * result->value_size;
+    result->bytes = bytes;
+    result->mapping = mapping;
+    if (result->offsets[result->size] != header->key_bytes)
+    {
+        hash_map_frozen_dtor(result);
+        return VALUE_ERROR;
+    }
+    *frozen = result;
     return OK;
 }
 
+/*******************************************************************************
+ * Souběžná tabulka
+ ******************************************************************************/
+
+/** Fibonacciho konstanta (2^64 / zlatý řez) pro výběr shardu. */
+static const uint64_t HASH_MAP_SHARD_MULTIPLIER = 0x9E3779B97F4A7C15ULL;
+
+/**
+ * @brief Shard, do kterého patří klíč s hašem @p hash .
+ *
+ * Shard určují nejvyšší bity součinu haše s Fibonacciho konstantou, 
+ * otisk i pozice v indexu shardu tak dál závisí na všech bitech haše.
+ */
+static inline hash_map_shard_t* hash_map_shard(hash_map_concurrent_t* self, size_t hash)
+{
+    if (self->shard_bits == 0)
+    {
+        return self->shards;
+    }
+    return self->shards + (size_t)(((uint64_t)hash * HASH_MAP_SHARD_MULTIPLIER) >> 
+                                   (64 - self->shard_bits));
+}
+
+/**
+ * @brief Zamkne shard pro zápis a označí ho lichou verzí.
+ */
+static inline void hash_map_shard_lock(hash_map_shard_t* shard)
+{
+    pthread_mutex_lock(&shard->lock);
+    __atomic_store_n(&shard->version, shard->version + 1, __ATOMIC_RELAXED);
+    // zmeny shardu nesmi predbehnout lichou verzi
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+/**
+ * @brief Zveřejní změny shardu sudou verzí a odemkne ho.
+ */
+static inline void hash_map_shard_unlock(hash_map_shard_t* shard)
+{
+    __atomic_store_n(&shard->version, shard->version + 1, __ATOMIC_RELEASE);
+    pthread_mutex_unlock(&shard->lock);
+}
+
+/**
+ * @brief Vyhledání klíče ve shardu.
+ *
+ * Čtenář si zkopíruje položky tabulky shardu potřebné k hledání a ověří, 
+ * že se verze během kopírování nezměnila. Kopie je tedy konzistentní a 
+ * pole, na která ukazuje, se neuvolní, dokud čtení neskončí (čtenář 
+ * oznamuje epochu jako při sdíleném čtení, viz hash_map_read_begin). 
+ * Hledání v kopii může narazit na rozepsaný zápis, výsledek proto platí jen 
+ * tehdy, když je verze i po hledání stejná. Po 
+ * @c HASH_MAP_OPTIMISTIC_RETRIES neúspěšných pokusech se shard zamkne.
+ *
+ * @param[in]  shard  Shard klíče.
+ * @param[in]  key    Klíč.
+ * @param[in]  length Délka klíče v bajtech.
+ * @param[in]  hash   Haš klíče.
+ * @param[out] dst    Hodnota záznamu, může být @c NULL .
+ *
+ * @return @c OK pokud klíč existuje, jinak @c KEY_ERROR .
+ */
+static hash_map_state_code_t hash_map_shard_read(hash_map_shard_t* shard, const char* key, 
+                                                 size_t length, size_t hash, int* dst)
+{
+    hash_map_t snapshot;
+    int slot = hash_map_read_begin();
+    for (int attempt = 0; attempt < HASH_MAP_OPTIMISTIC_RETRIES; attempt++)
+    {
+        uint64_t version = __atomic_load_n(&shard->version, __ATOMIC_ACQUIRE);
+        if ((version & 1) != 0)
+        {
+            // shard prave nekdo meni
+            continue;
+        }
+        hash_map_snapshot(&snapshot, shard->map);
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (__atomic_load_n(&shard->version, __ATOMIC_RELAXED) != version)
+        {
+            continue;
+        }
+        hash_map_item_t* item = hash_map_find(&snapshot, key, length, hash);
+        int value = item != NULL ? __atomic_load_n(&item->value, __ATOMIC_RELAXED) : 0;
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (__atomic_load_n(&shard->version, __ATOMIC_RELAXED) == version)
+        {
+            hash_map_read_end(slot);
+            if (item != NULL && dst != NULL)
+            {
+                *dst = value;
+            }
+            return item != NULL ? OK : KEY_ERROR;
+        }
+    }
+    hash_map_read_end(slot);
+
+    pthread_mutex_lock(&shard->lock);
+    hash_map_item_t* item = hash_map_find(shard->map, key, length, hash);
+    if (item != NULL && dst != NULL)
+    {
+        *dst = item->value;
+    }
+    pthread_mutex_unlock(&shard->lock);
+    return item != NULL ? OK : KEY_ERROR;
+}
+
+hash_map_concurrent_t* hash_map_concurrent_ctor(size_t shards)
+{
+    shards = hash_map_round_up_pow2(shards > 0 ? shards : HASH_MAP_CONCURRENT_SHARDS);
+    if (shards == 0 || shards > SIZE_MAX / sizeof(hash_map_shard_t))
+    {
+        return NULL;
+    }
+    hash_map_concurrent_t* self = (hash_map_concurrent_t*)malloc(sizeof(hash_map_concurrent_t));
+    if (self == NULL)
+    {
+        return NULL;
+    }
+    self->shards = (hash_map_shard_t*)malloc(shards*sizeof(hash_map_shard_t));
+    if (self->shards == NULL)
+    {
+        free(self);
+        return NULL;
+    }
+    self->shard_count = shards;
+    self->shard_bits = 0;
+    while (((size_t)1 << self->shard_bits) < shards)
+    {
+        self->shard_bits++;
+    }
+    self->hash_function = hash_map_default_hash;
+
+    for (size_t i = 0; i < shards; i++)
+    {
+        hash_map_shard_t* shard = self->shards + i;
+        shard->map = hash_map_ctor();
+        if (shard->map == NULL)
+        {
+            // alokace pameti selhala, uvolni se jiz vytvorene shardy
+            self->shard_count = i;
+            hash_map_concurrent_dtor(self);
+            return NULL;
+        }
+        shard->map->defer_free = true;
+        shard->map->hash_function = self->hash_function;
+        shard->version = 0;
+        pthread_mutex_init(&shard->lock, NULL);
+    }
+
+    return self;
+}
+
+void hash_map_concurrent_dtor(hash_map_concurrent_t* self)
+{
+    for (size_t i = 0; i < self->shard_count; i++)
+    {
+        hash_map_dtor(self->shards[i].map);
+        pthread_mutex_destroy(&self->shards[i].lock);
+    }
+    free(self->shards);
+    free(self);
+}
+
+size_t hash_map_concurrent_size(hash_map_concurrent_t* self)
+{
+    size_t size = 0;
+    for (size_t i = 0; i < self->shard_count; i++)
+    {
+        size += __atomic_load_n(&self->shards[i].map->used, __ATOMIC_RELAXED);
+    }
+    return size;
+}
+
+bool hash_map_concurrent_contains(hash_map_concurrent_t* self, const char* key)
+{
+    size_t length = strlen(key);
+    size_t hash = self->hash_function(key, length);
+    return hash_map_shard_read(hash_map_shard(self, hash), key, length, hash, NULL) == OK;
+}
+
+hash_map_state_code_t hash_map_concurrent_get(hash_map_concurrent_t* self, 
+                                              const char* key, int* value)
+{
+    size_t length = strlen(key);
+    size_t hash = self->hash_function(key, length);
+    return hash_map_shard_read(hash_map_shard(self, hash), key, length, hash, value);
+}
+
+hash_map_state_code_t hash_map_concurrent_put(hash_map_concurrent_t* self, 
+                                              const char* key, int value)
+{
+    size_t length = strlen(key);
+    size_t hash = self->hash_function(key, length);
+    hash_map_shard_t* shard = hash_map_shard(self, hash);
+    hash_map_item_t* item;
+
+    hash_map_shard_lock(shard);
+    hash_map_state_code_t state = hash_map_upsert(shard->map, key, length, hash, value, NULL, &item);
+    if (state == KEY_ALREADY_EXISTS)
+    {
+        __atomic_store_n(&item->value, value, __ATOMIC_RELAXED);
+    }
+    hash_map_shard_unlock(shard);
+    return state;
+}
+
+hash_map_state_code_t hash_map_concurrent_add(hash_map_concurrent_t* self, 
+                                              const char* key, int delta)
+{
+    size_t length = strlen(key);
+    size_t hash = self->hash_function(key, length);
+    hash_map_shard_t* shard = hash_map_shard(self, hash);
+    hash_map_item_t* item;
+
+    hash_map_shard_lock(shard);
+    hash_map_state_code_t state = hash_map_upsert(shard->map, key, length, hash, delta, NULL, &item);
+    if (state == KEY_ALREADY_EXISTS)
+    {
+        __atomic_store_n(&item->value, item->value + delta, __ATOMIC_RELAXED);
+    }
+    hash_map_shard_unlock(shard);
+    return state;
+}
+
+hash_map_state_code_t hash_map_concurrent_pop(hash_map_concurrent_t* self, 
+                                              const char* key, int* value)
+{
+    size_t length = strlen(key);
+    size_t hash = self->hash_function(key, length);
+    hash_map_shard_t* shard = hash_map_shard(self, hash);
+
+    hash_map_shard_lock(shard);
+    hash_map_state_code_t state = hash_map_pop_hashed(shard->map, key, length, hash, value, NULL);
+    hash_map_shard_unlock(shard);
+    return state;
+}
+
 /*** Konec souboru white_box_code.cpp ***/
@@ -26,6 +26,8 @@
 #include <string.h>     
 #include <stddef.h>
 #include <stdbool.h>
+#include <stdint.h>
+#include <pthread.h>
 
 /** Inicializační velikost tabulky. */
 #define HASH_MAP_INIT_SIZE 8                    
@@ -33,10 +35,63 @@
 #define HASH_MAP_PERTURB_SHIFT 5
 /** Mez zaplnění kdy se má realokovat velikost tabulky. */
 #define HASH_MAP_REALLOCATION_THRESHOLD 3/5.
-/** Hyperparametr v hašovácí funkci. */
+/** Velikost vnitřního bufferu klíče v záznamu včetně ukončovací nuly. */
+#define HASH_MAP_INLINE_KEY_SIZE 24
+/** Největší počet záznamů v jednom bloku (slab) alokátoru záznamů. */
+#define HASH_MAP_SLAB_MAX_ITEMS 1024
+/** Nejmenší velikost bloku arény klíčů v bajtech. */
+#define HASH_MAP_ARENA_BLOCK_SIZE 4096
+/** Největší velikost bloku arény klíčů v bajtech (kromě delších klíčů). */
+#define HASH_MAP_ARENA_MAX_BLOCK_SIZE (1 << 20)
+/** Mez zaplnění, pod kterou se index po odstranění záznamu zmenší. */
+#define HASH_MAP_SHRINK_THRESHOLD 1/8.
+/** Počet záznamů přesunutých do nového indexu při jedné operaci během 
+ *  postupného zvětšování. */
+#define HASH_MAP_MIGRATE_STEP 2
+/** Výchozí počet shardů souběžné tabulky. */
+#define HASH_MAP_CONCURRENT_SHARDS 16
+/** Počet optimistických pokusů o čtení shardu, po kterých čtenář shard 
+ *  zamkne. */
+#define HASH_MAP_OPTIMISTIC_RETRIES 4
+/** Největší počet vláken, která současně čtou tabulky ve sdíleném režimu 
+ *  bez sdíleného čítače (další čtenáři zablokují uvolňování paměti). */
+#define HASH_MAP_MAX_READERS 128
+/** Počet nahrazených bloků paměti, po kterém se zkusí uvolnit ty, které už 
+ *  žádný čtenář nemůže číst. */
+#define HASH_MAP_RECLAIM_THRESHOLD 64
+/** Hyperparametr v původní (součtové) hašovácí funkci. */
 #define HASH_FUNCTION_PARAM_A 1794967309        
-/** Hyperparametr v hašovácí funkci. */
+/** Hyperparametr v původní (součtové) hašovácí funkci. */
 #define HASH_FUNCTION_PARAM_B 7                 
+/** Řídicí bajt prázdného místa v indexu. */
+#define HASH_MAP_CTRL_EMPTY 0x80
+/** Řídicí bajt místa v indexu po odstraněném záznamu (@c dummy ). */
+#define HASH_MAP_CTRL_DELETED 0xFE
+/** Počet míst ve skupině indexu prohledávané najednou (engine skupin). */
+#define HASH_MAP_GROUP_SIZE 16
+/** Mez zaplnění kdy se má realokovat index prohledávaný po skupinách. */
+#define HASH_MAP_GROUP_REALLOCATION_THRESHOLD 7/8.
+/** Mez zaplnění kdy se má realokovat index enginu Robin Hood. */
+#define HASH_MAP_ROBIN_REALLOCATION_THRESHOLD 9/10.
+/** Největší vzdálenost od výchozí pozice uložená v @c dist , větší 
+ *  vzdálenost se počítá z haše záznamu. */
+#define HASH_MAP_ROBIN_MAX_DISTANCE 0xFF
+/** Zarovnání hodnoty uložené za záznamem, viz hash_map_set_value_size. */
+#define HASH_MAP_VALUE_ALIGN 16
+/** Průměrný počet klíčů ve skupině minimální perfektní hašovací funkce 
+ *  zmrazené tabulky. */
+#define HASH_MAP_FROZEN_BUCKET_SIZE 4
+/** Největší počet pokusů o rozmístění jedné skupiny zmrazené tabulky 
+ *  (první složka posunutí). */
+#define HASH_MAP_FROZEN_MAX_SEEDS 256
+/** Počet přihrádek histogramu délek hledání, poslední přihrádka obsahuje i 
+ *  všechny delší. */
+#define HASH_MAP_STATS_HISTOGRAM_SIZE 16
+/** Největší počet náhodných hašů, ze kterých se odhaduje délka neúspěšného 
+ *  hledání. */
+#define HASH_MAP_STATS_MISS_SAMPLES 65536
+/** Seed výchozí hašovací funkce. */
+#define HASH_FUNCTION_SEED 0x2d358dccaa6c78a5ULL
 
 // Informace pro C++ překladač, aby použil "C" linker pro následující funkce.
 extern "C" {
@@ -57,9 +112,138 @@ typedef enum {
     MEMORY_ERROR,           ///< Problém při alokaci paměti.
     VALUE_ERROR,            ///< Neplatná hodnota argumentu.
     KEY_ERROR,              ///< Přístup ke klíči který není vložen v tabulce.
-    KEY_ALREADY_EXISTS      ///< Klíč již v hašovací tabulce existuje.
+    KEY_ALREADY_EXISTS,     ///< Klíč již v hašovací tabulce existuje.
+    IO_ERROR                ///< Chyba při čtení nebo zápisu souboru.
 } hash_map_state_code_t;
 
+/**
+ * @brief Politika velikosti indexu.
+ *
+ * Index o velikosti mocniny dvou se prochází maskou (@c hash & mask ) a 
+ * perturbací, index libovolné velikosti mapuje haš na pozici násobením 
+ * (@c (hash * size) >> 64 ) a kolize řeší lineárně. V žádném případě se 
+ * při hledání nepoužívá operace modulo.
+ *
+ * @see hash_map_set_capacity_policy
+ */
+typedef enum {
+    HASH_MAP_CAPACITY_EXACT,        ///< Velikost indexu je přesně požadovaná.
+    HASH_MAP_CAPACITY_POWER_OF_TWO  ///< Velikost se zaokrouhlí na mocninu dvou.
+} hash_map_capacity_policy_t;
+
+/**
+ * @brief Způsob procházení indexu (engine tabulky).
+ *
+ * @c HASH_MAP_ENGINE_PROBING prochází index po jednom místě perturbací, resp. 
+ * lineárně. @c HASH_MAP_ENGINE_GROUPS prochází index po zarovnaných skupinách 
+ * @c HASH_MAP_GROUP_SIZE řídicích bajtů, které porovná s otiskem haše 
+ * najednou (SSE2), a dovoluje tak vyšší zaplnění indexu. 
+ * @c HASH_MAP_ENGINE_ROBIN_HOOD prochází index lineárně a udržuje záznamy 
+ * seřazené podle vzdálenosti od výchozí pozice (@c dist ): vkládaný záznam 
+ * vystřídá záznam, který je své výchozí pozici blíž, hledání končí na prvním 
+ * záznamu bližším než hledaný klíč a odstranění posune následující záznamy 
+ * zpět, takže index nemá @c dummy objekty a snese zaplnění 
+ * @c HASH_MAP_ROBIN_REALLOCATION_THRESHOLD . Rozhraní tabulky ani pořadí 
+ * záznamů (@c first , @c last ) na volbě nezávisí.
+ *
+ * @see hash_map_set_engine
+ */
+typedef enum {
+    HASH_MAP_ENGINE_PROBING,    ///< Procházení po jednotlivých místech.
+    HASH_MAP_ENGINE_GROUPS,     ///< Procházení po skupinách 16 míst.
+    HASH_MAP_ENGINE_ROBIN_HOOD  ///< Lineární procházení Robin Hood.
+} hash_map_engine_t;
+
+/**
+ * @brief Rozložení záznamů v paměti.
+ *
+ * Při @c HASH_MAP_LAYOUT_LINKED se každý záznam alokuje zvlášť a index 
+ * obsahuje ukazatele na záznamy. Při @c HASH_MAP_LAYOUT_COMPACT leží záznamy 
+ * v souvislém poli @c entries v pořadí vložení a index (@c slots ) obsahuje 
+ * jen čísla záznamů o šířce 8, 16, 32 nebo 64 bitů podle kapacity pole. 
+ * Seznam @c first -> @c last funguje v obou případech stejně, v kompaktním 
+ * rozložení jde navíc o sekvenční průchod pamětí.
+ *
+ * @see hash_map_set_layout
+ */
+typedef enum {
+    HASH_MAP_LAYOUT_LINKED,     ///< Samostatně alokované záznamy.
+    HASH_MAP_LAYOUT_COMPACT     ///< Souvislé pole záznamů a úzký index.
+} hash_map_layout_t;
+
+/**
+ * @brief Způsob zvětšování indexu.
+ *
+ * Při @c HASH_MAP_RESIZE_BLOCKING se všechny záznamy přeindexují najednou v 
+ * operaci, která index zvětšuje. Při @c HASH_MAP_RESIZE_INCREMENTAL zůstane 
+ * starý index (@c old_ctrl , @c old_index ) vedle nového a každá další 
+ * operace do nového indexu přesune nejvýše @c HASH_MAP_MIGRATE_STEP záznamů 
+ * (podobně jako progresivní rehash v Redisu). Hledání během přesunu prochází 
+ * oba indexy. Postupně se zvětšuje jen index rozložení 
+ * @c HASH_MAP_LAYOUT_LINKED , zmenšení a přestavění indexu na místě probíhá 
+ * vždy najednou.
+ *
+ * @see hash_map_set_resize_policy
+ */
+typedef enum {
+    HASH_MAP_RESIZE_BLOCKING,   ///< Přeindexování najednou.
+    HASH_MAP_RESIZE_INCREMENTAL ///< Postupný přesun záznamů do nového indexu.
+} hash_map_resize_policy_t;
+
+/**
+ * @brief Režim čtení tabulky.
+ *
+ * V režimu @c HASH_MAP_READ_SHARED smí libovolný počet vláken volat 
+ * @c hash_map_get a @c hash_map_contains souběžně s jedním zapisujícím 
+ * vláknem, aniž by čtenáři cokoliv zamykali nebo opakovali. Zápisy musí 
+ * uživatel serializovat sám. Zapisovatel zveřejňuje místa indexu atomicky 
+ * až po naplnění záznamu a nový index (viz @c view ) vyměňuje jedním 
+ * atomickým zápisem. Odstraněné záznamy, staré indexy a bloky arény se 
+ * uvolňují epochově: každý čtenář si při vstupu poznamená globální epochu a 
+ * paměť nahrazená v epoše @c e se uvolní, až žádný aktivní čtenář nečte 
+ * epochu menší nebo rovnou @c e . Ve sdíleném režimu se index zvětšuje 
+ * vždy najednou a je podporováno jen rozložení @c HASH_MAP_LAYOUT_LINKED .
+ *
+ * @see hash_map_set_read_policy
+ */
+typedef enum {
+    HASH_MAP_READ_EXCLUSIVE,    ///< Tabulku používá nejvýše jedno vlákno.
+    HASH_MAP_READ_SHARED        ///< Čtení bez zámků souběžně se zapisovatelem.
+} hash_map_read_policy_t;
+
+/**
+ * @brief Hašovací funkce tabulky.
+ *
+ * Funkce dostává klíč a jeho délku v bajtech (bez ukončovací nuly).
+ *
+ * @see hash_map_set_hash_function
+ */
+typedef size_t (*hash_map_hash_function_t)(const char* key, size_t length);
+
+/**
+ * @brief Funkce volaná pro záznam odstraněný v režimu cache.
+ *
+ * Dostává kontext zadaný při nastavení, klíč s délkou, celočíselnou hodnotu 
+ * a ukazatel na hodnotu nastavené velikosti (nebo @c NULL ). Záznam se 
+ * uvolní až po návratu z funkce; funkce nesmí tabulku měnit.
+ *
+ * @see hash_map_set_evict_function
+ */
+typedef void (*hash_map_evict_function_t)(void* context, const char* key, size_t length, 
+                                          int value, void* data);
+
+/**
+ * @brief Čítače režimu cache.
+ *
+ * @see hash_map_cache_stats
+ */
+typedef struct hash_map_cache_stats
+{
+    size_t hits;                ///< Nalezené klíče
+    size_t misses;              ///< Nenalezené klíče
+    size_t evictions;           ///< Záznamy odstraněné kvůli limitu
+} hash_map_cache_stats_t;
+
 /**
  * @brief Záznam v hašovací tabulce.
  * 
@@ -67,7 +251,13 @@ typedef enum {
  * paměti) a prací s pamětí (projeví se při velkých indexech) jsou vložené 
  * položky implementované formou obousměrně vázaného seznamu a index obsahuje 
  * pouze ukazatele do tohoto seznamu. Pořadí položek v seznamu odpovídá pořadí 
- * vložení daného klíče do tabulky. 
+ * vložení daného klíče do tabulky (v režimu cache pořadí posledního použití, 
+ * viz hash_map_set_cache_limit). 
+ * 
+ * Klíče kratší než @c HASH_MAP_INLINE_KEY_SIZE se ukládají přímo do záznamu 
+ * (@c inline_key ), delší klíče se alokují zvlášť. Ukazatel @c key je platný 
+ * v obou případech. Hodnota nastavené velikosti (viz 
+ * hash_map_set_value_size) leží v paměti bezprostředně za záznamem.
  * 
  * Uživatel by k položkám struktury neměl přistupovat přímo, ale pomocí 
  * definovaného rozhraní níže. Nicméně v rámci testování můžete přímo testovat, 
@@ -78,10 +268,41 @@ typedef struct hash_map_item
     char* key;                  ///< Klíč
     size_t hash;                ///< Hash
     int value;                  ///< Uložená hodnota
+    uint32_t length;            ///< Délka klíče v bajtech (bez ukončovací nuly)
     struct hash_map_item* next; ///< Následující položka 
     struct hash_map_item* prev; ///< Předcházející položka
+    char inline_key[HASH_MAP_INLINE_KEY_SIZE]; ///< Buffer pro krátký klíč
 } hash_map_item_t;
 
+/**
+ * @brief Blok paměti alokátoru tabulky.
+ *
+ * Záznamy (v rozložení @c HASH_MAP_LAYOUT_LINKED ) se alokují z bloků 
+ * pevné velikosti (slab) se seznamem uvolněných záznamů, dlouhé klíče z 
+ * arény bloků posunem ukazatele. Data bloku následují bezprostředně za 
+ * hlavičkou. Vyprázdnění a zrušení tabulky uvolní jen bloky, nikoliv 
+ * jednotlivé záznamy.
+ */
+typedef struct hash_map_block
+{
+    struct hash_map_block* next;    ///< Další blok
+    size_t size;                    ///< Velikost dat bloku v bajtech
+} hash_map_block_t;
+
+/**
+ * @brief Nahrazená paměť čekající na uvolnění.
+ *
+ * @see hash_map_t::defer_free
+ */
+typedef struct hash_map_retired
+{
+    struct hash_map_retired* next;  ///< Další nahrazená paměť
+    void* ptr;                      ///< Paměť k uvolnění
+    size_t size;                    ///< Velikost paměti (záznam leží v bloku: 0)
+    uint64_t epoch;                 ///< Epocha nahrazení
+    bool item;                      ///< Jde o záznam vracený do bloku
+} hash_map_retired_t;
+
 /**
  * @brief Datový typ hašovací tabulky. 
  * 
@@ -92,14 +313,108 @@ typedef struct hash_map_item
 typedef struct hash_map
 {
     hash_map_item_t** index;    ///< Index hašovací tabulky
+    /** Řídicí bajty indexu: @c HASH_MAP_CTRL_EMPTY , @c HASH_MAP_CTRL_DELETED 
+     *  nebo 7bitový otisk haše obsazeného místa. Při hledání se ukazatel v 
+     *  indexu čte jen tehdy, když otisk odpovídá hledanému haši. */
+    uint8_t* ctrl;
+    /** Vzdálenosti záznamů od výchozí pozice (jen 
+     *  @c HASH_MAP_ENGINE_ROBIN_HOOD , jinak @c NULL ), nejvýše 
+     *  @c HASH_MAP_ROBIN_MAX_DISTANCE . Leží ve stejné alokaci za @c ctrl . */
+    uint8_t* dist;
     hash_map_item_t* first;     ///< První položka v seznamu
     hash_map_item_t* last;      ///< Poslední položka v seznamu
     /** Při odstranění je položka v indexu nahrazena tímto ukazatelem. */
     hash_map_item_t* dummy;     
     size_t allocated;           ///< Alokované místo (velikost indexu)
     size_t used;                ///< Počet vložených položek (velikost seznamu)
+    size_t deleted;             ///< Počet míst indexu s @c dummy objektem
+    hash_map_hash_function_t hash_function; ///< Použitá hašovací funkce
+    /** Maska indexu (@c allocated - 1), pokud je velikost mocninou dvou, 
+     *  jinak 0. */
+    size_t mask;
+    hash_map_capacity_policy_t capacity_policy; ///< Politika velikosti indexu
+    hash_map_engine_t engine;   ///< Způsob procházení indexu
+    hash_map_layout_t layout;   ///< Rozložení záznamů v paměti
+    /** Pole záznamů v pořadí vložení (jen @c HASH_MAP_LAYOUT_COMPACT ). 
+     *  Odstraněné záznamy mají @c key rovný @c NULL až do přestavění indexu. */
+    hash_map_item_t* entries;
+    size_t entries_used;        ///< Počet použitých záznamů pole včetně odstraněných
+    size_t entries_allocated;   ///< Kapacita pole záznamů
+    /** Index čísel záznamů v poli @c entries (jen @c HASH_MAP_LAYOUT_COMPACT ), 
+     *  @c index je v tomto rozložení @c NULL . */
+    void* slots;
+    uint8_t slot_width;         ///< Šířka čísla záznamu v @c slots v bajtech
+    hash_map_block_t* slabs;    ///< Bloky záznamů
+    hash_map_item_t* free_items;///< Uvolněné záznamy v blocích spojené přes @c next
+    hash_map_item_t* slab_next; ///< První nepoužitý záznam posledního bloku
+    hash_map_item_t* slab_end;  ///< Konec posledního bloku záznamů
+    size_t slab_capacity;       ///< Počet záznamů ve všech blocích
+    hash_map_block_t* arena;    ///< Bloky arény dlouhých klíčů
+    char* arena_next;           ///< Volné místo v aktuálním bloku arény
+    char* arena_end;            ///< Konec aktuálního bloku arény
+    size_t arena_size;          ///< Celková velikost bloků arény v bajtech
+    size_t arena_wasted;        ///< Bajty arény po odstraněných klíčích
+    hash_map_resize_policy_t resize_policy; ///< Způsob zvětšování indexu
+    /** Starý index během postupného zvětšování, jinak @c NULL . */
+    hash_map_item_t** old_index;
+    uint8_t* old_ctrl;          ///< Řídicí bajty starého indexu
+    size_t old_allocated;       ///< Velikost starého indexu
+    size_t old_mask;            ///< Maska starého indexu
+    size_t old_used;            ///< Počet záznamů, které jsou ještě ve starém indexu
+    size_t migrate;             ///< Další místo starého indexu k přesunu
+    /** Nahrazené indexy, pole záznamů a bloky arény se neuvolní hned, ale 
+     *  až skončí dříve započatá čtení (shardy souběžné tabulky, které mohou 
+     *  číst optimističtí čtenáři). */
+    bool defer_free;
+    hash_map_retired_t* retired; ///< Nahrazená paměť čekající na uvolnění
+    size_t retired_count;       ///< Počet položek seznamu @c retired
+    size_t value_size;          ///< Velikost hodnoty za záznamem v bajtech
+    size_t item_size;           ///< Velikost záznamu v blocích včetně hodnoty
+    hash_map_read_policy_t read_policy; ///< Režim čtení tabulky
+    /** Kopie polí potřebných k hledání zveřejněná čtenářům ve sdíleném 
+     *  režimu, jinak @c NULL . */
+    struct hash_map* view;
+    size_t cache_limit;         ///< Největší počet záznamů v režimu cache, 0 bez limitu
+    hash_map_evict_function_t evict_function; ///< Funkce volaná při odstranění, nebo NULL
+    void* evict_context;        ///< Kontext funkce @c evict_function
+    hash_map_cache_stats_t cache_stats; ///< Čítače režimu cache
+#ifdef HASH_MAP_STATS_RESIZE
+    size_t resizes;             ///< Počet přestavění indexu
+    uint64_t resize_ns;         ///< Celková doba přestavění indexu v ns
+#endif
 } hash_map_t;
 
+/*******************************************************************************
+ * Hašovací funkce
+ ******************************************************************************/
+/**
+ * @brief Výchozí hašovací funkce.
+ *
+ * Funkce ve stylu wyhash: klíč se zpracovává po 8 (resp. 16) bajtech a bloky 
+ * se míchají 64x64 -> 128bitovým násobením. Na rozdíl od původní součtové 
+ * funkce nezávisí výsledek jen na součtu znaků, takže přesmyčky ("ab", "ba") 
+ * nekolidují.
+ *
+ * @param[in] key    Klíč.
+ * @param[in] length Délka klíče v bajtech.
+ *
+ * @return Haš klíče.
+ */
+size_t hash_map_default_hash(const char* key, size_t length);
+
+/**
+ * @brief Původní součtová hašovací funkce @c A*c+B přes všechny znaky klíče.
+ *
+ * Ponechána pro srovnání a pro testování kolizí (všechny přesmyčky klíče mají 
+ * stejný haš).
+ *
+ * @param[in] key    Klíč.
+ * @param[in] length Délka klíče v bajtech.
+ *
+ * @return Haš klíče.
+ */
+size_t hash_map_additive_hash(const char* key, size_t length);
+
 /*******************************************************************************
  * Inicializace, deinicializace & alokace paměti
  ******************************************************************************/
@@ -166,6 +481,15 @@ void hash_map_clear(hash_map_t* self);
  * @warning Velikost indexu nemůže být menší než počet vložených položek, v 
  * takovém případě funkce nic nevykoná a vrátí hodnotu @c VALUE_ERROR . 
  * 
+ * Při politice @c HASH_MAP_CAPACITY_POWER_OF_TWO se @p size zaokrouhlí 
+ * nahoru na nejbližší mocninu dvou. Engine @c HASH_MAP_ENGINE_GROUPS navíc 
+ * vyžaduje alespoň jednu celou skupinu (@c HASH_MAP_GROUP_SIZE míst).
+ * 
+ * Při @c HASH_MAP_RESIZE_INCREMENTAL se neprázdný index rozložení 
+ * @c HASH_MAP_LAYOUT_LINKED zvětšuje postupně (kromě enginu 
+ * @c HASH_MAP_ENGINE_ROBIN_HOOD a sdíleného režimu čtení), funkce jen 
+ * alokuje nový index a záznamy do něj přesouvají následující operace.
+ * 
  * @param[in] self Ukazatel na strukturu hašovací tabulky.
  * @param[in] size Velikost indexu.
  * 
@@ -176,6 +500,131 @@ void hash_map_clear(hash_map_t* self);
  */
 hash_map_state_code_t hash_map_reserve(hash_map_t* self, size_t size);
 
+/**
+ * @brief Nastaví politiku velikosti indexu.
+ *
+ * Při přechodu na @c HASH_MAP_CAPACITY_POWER_OF_TWO se aktuální index 
+ * zvětší na nejbližší mocninu dvou.
+ *
+ * @param[in] self   Ukazatel na strukturu hašovací tabulky.
+ * @param[in] policy Nová politika.
+ *
+ * @return @c MEMORY_ERROR pokud se nepodařilo alokovat nový index, jinak @c OK.
+ *
+ * @see hash_map_reserve
+ */
+hash_map_state_code_t hash_map_set_capacity_policy(hash_map_t* self, 
+                                                   hash_map_capacity_policy_t policy);
+
+/**
+ * @brief Nastaví způsob procházení indexu.
+ *
+ * Index se přestaví, u @c HASH_MAP_ENGINE_GROUPS na velikost mocniny dvou 
+ * (nejméně @c HASH_MAP_GROUP_SIZE ) bez ohledu na politiku velikosti indexu. 
+ * Pořadí záznamů se nemění. Engine @c HASH_MAP_ENGINE_ROBIN_HOOD při 
+ * vkládání i odstraňování přesouvá záznamy v indexu, index proto zvětšuje 
+ * vždy najednou a nepodporuje sdílený režim čtení.
+ *
+ * @param[in] self   Ukazatel na strukturu hašovací tabulky.
+ * @param[in] engine Nový engine.
+ *
+ * @return @c VALUE_ERROR pro @c HASH_MAP_ENGINE_ROBIN_HOOD ve sdíleném režimu 
+ *         čtení, @c MEMORY_ERROR pokud se nepodařilo alokovat nový index, 
+ *         jinak @c OK.
+ *
+ * @see hash_map_engine_t
+ */
+hash_map_state_code_t hash_map_set_engine(hash_map_t* self, hash_map_engine_t engine);
+
+/**
+ * @brief Nastaví rozložení záznamů v paměti.
+ *
+ * Rozložení lze měnit jen u prázdné tabulky, velikost indexu zůstává.
+ *
+ * @param[in] self   Ukazatel na strukturu hašovací tabulky.
+ * @param[in] layout Nové rozložení.
+ *
+ * @return @c VALUE_ERROR pokud tabulka obsahuje záznamy nebo pro 
+ *         @c HASH_MAP_LAYOUT_COMPACT ve sdíleném režimu čtení, s hodnotami 
+ *         nastavené velikosti či v režimu cache, @c MEMORY_ERROR pokud se 
+ *         nepodařilo alokovat nový index, jinak @c OK.
+ *
+ * @see hash_map_layout_t
+ */
+hash_map_state_code_t hash_map_set_layout(hash_map_t* self, hash_map_layout_t layout);
+
+/**
+ * @brief Nastaví způsob zvětšování indexu.
+ *
+ * Při přechodu na @c HASH_MAP_RESIZE_BLOCKING se případný rozpracovaný 
+ * přesun záznamů dokončí.
+ *
+ * Příklad užití:
+ * @code{.c}
+ * hash_map_t* map = hash_map_ctor();
+ * hash_map_set_resize_policy(map, HASH_MAP_RESIZE_INCREMENTAL);
+ * @endcode
+ *
+ * @param[in] self   Ukazatel na strukturu hašovací tabulky.
+ * @param[in] policy Nový způsob zvětšování.
+ *
+ * @return @c OK.
+ *
+ * @see hash_map_resize_policy_t
+ */
+hash_map_state_code_t hash_map_set_resize_policy(hash_map_t* self, 
+                                                 hash_map_resize_policy_t policy);
+
+/**
+ * @brief Nastaví režim čtení tabulky.
+ *
+ * Přechod na @c HASH_MAP_READ_SHARED dokončí rozpracovaný přesun záznamů a 
+ * zveřejní index čtenářům. Přechod na @c HASH_MAP_READ_EXCLUSIVE uvolní 
+ * veškerou nahrazenou paměť, volající proto musí zaručit, že už žádné jiné 
+ * vlákno z tabulky nečte. Režim se nesmí měnit souběžně s jinými operacemi, 
+ * stejně tak hašovací funkce ve sdíleném režimu.
+ *
+ * Příklad užití:
+ * @code{.c}
+ * hash_map_t* map = hash_map_ctor();
+ * hash_map_set_read_policy(map, HASH_MAP_READ_SHARED);
+ * // vlakna ctenaru: hash_map_get(map, "key", &value);
+ * // jedine vlakno zapisovatele: hash_map_put(map, "key", 1);
+ * @endcode
+ *
+ * @param[in] self   Ukazatel na strukturu hašovací tabulky.
+ * @param[in] policy Nový režim čtení.
+ *
+ * @return @c VALUE_ERROR pro sdílený režim v rozložení 
+ *         @c HASH_MAP_LAYOUT_COMPACT , s enginem 
+ *         @c HASH_MAP_ENGINE_ROBIN_HOOD nebo v režimu cache, 
+ *         @c MEMORY_ERROR pokud se nepodařilo zveřejnit index, jinak @c OK.
+ *
+ * @see hash_map_read_policy_t
+ */
+hash_map_state_code_t hash_map_set_read_policy(hash_map_t* self, 
+                                               hash_map_read_policy_t policy);
+
+/**
+ * @brief Nastaví hašovací funkci tabulky.
+ *
+ * Haše již vložených záznamů se přepočítají a index se přestaví.
+ *
+ * Příklad užití:
+ * @code{.c}
+ * hash_map_t* map = hash_map_ctor();
+ * hash_map_set_hash_function(map, hash_map_additive_hash);
+ * @endcode
+ *
+ * @param[in] self          Ukazatel na strukturu hašovací tabulky.
+ * @param[in] hash_function Hašovací funkce, @c NULL nastaví výchozí funkci
+ *                          @c hash_map_default_hash .
+ *
+ * @return @c MEMORY_ERROR pokud se nepodařilo alokovat nový index, jinak @c OK.
+ */
+hash_map_state_code_t hash_map_set_hash_function(hash_map_t* self, 
+                                                 hash_map_hash_function_t hash_function);
+
 /*******************************************************************************
  * Metody pro přístup k hašovací tabulce
  ******************************************************************************/
@@ -224,7 +673,9 @@ bool hash_map_contains(hash_map_t* self, const char* key);
  * @brief Vloží klíč a hodnotu do tabulky.
  * 
  * Pokud je již index tabulky zaplněn ze 2/3, realokuje pro index 2x větší místo
- * v paměti a provede reindexaci. Pokud tabulka již obsahuje k danému klíči 
+ * v paměti a provede reindexaci. Do zaplnění se počítají i místa po 
+ * odstraněných záznamech; tvoří-li jich většinu, index se jen přestaví na 
+ * místě beze změny velikosti. Pokud tabulka již obsahuje k danému klíči 
  * záznam, hodnota záznamu se přepíše a funkce vrací hodnotu 
  * @c KEY_ALREADY_EXISTS .
  * 
@@ -282,8 +733,9 @@ hash_map_state_code_t hash_map_get(hash_map_t* self, const char* key,
  * // hash_map_contains(map, "aloha") == false
  * @endcode
  *
- * @warning Odstranění záznamu z tabulky neovlivňuje alokované místo pro 
- *          tabulku.
+ * @warning Klesne-li zaplnění indexu pod @c HASH_MAP_SHRINK_THRESHOLD , index 
+ *          se zmenší na čtyřnásobek počtu záznamů (nejméně 
+ *          @c HASH_MAP_INIT_SIZE ).
  * 
  * @param[in]  self  Ukazatel na strukturu hašovací tabulky.
  * @param[in]  key   Klíč do tabulky.
@@ -309,8 +761,9 @@ hash_map_state_code_t hash_map_pop(hash_map_t* self, const char* key,
  * // hash_map_contains(map, "aloha") == false
  * @endcode
  * 
- * @warning Odstranění záznamu z tabulky neovlivňuje alokované místo pro 
- *          tabulku.
+ * @warning Klesne-li zaplnění indexu pod @c HASH_MAP_SHRINK_THRESHOLD , index 
+ *          se zmenší na čtyřnásobek počtu záznamů (nejméně 
+ *          @c HASH_MAP_INIT_SIZE ).
  * 
  * @param[in] self Ukazatel na strukturu hašovací tabulky.
  * @param[in] key  Klíč do tabulky.
@@ -322,6 +775,697 @@ hash_map_state_code_t hash_map_pop(hash_map_t* self, const char* key,
  */
 hash_map_state_code_t hash_map_remove(hash_map_t* self, const char* key);
 
+/**
+ * @brief Vrátí ukazatel na hodnotu záznamu s daným klíčem, záznam s hodnotou 
+ *        0 vloží, pokud v tabulce není.
+ *
+ * Klíč se hašuje a vyhledává jen jednou, úprava hodnoty přes vrácený 
+ * ukazatel tak stojí jedno hledání místo dvojice hash_map_get a hash_map_put.
+ *
+ * Příklad užití:
+ * @code{.c}
+ * int* count;
+ * if (hash_map_get_or_insert(map, word, &count) != MEMORY_ERROR)
+ *     *count += 1;
+ * @endcode
+ *
+ * @warning Ukazatel je platný jen do další operace, která tabulku mění 
+ *          (vložení, odstranění, změna velikosti, ...).
+ *
+ * @param[in]  self  Ukazatel na strukturu hašovací tabulky.
+ * @param[in]  key   Klíč do tabulky.
+ * @param[out] value Ukazatel na místo, kde se uloží ukazatel na hodnotu.
+ *
+ * @return @c OK pokud byl záznam vložen, @c KEY_ALREADY_EXISTS pokud již 
+ *         existoval, @c MEMORY_ERROR při chybě alokace (@p value se pak 
+ *         nemění).
+ */
+hash_map_state_code_t hash_map_get_or_insert(hash_map_t* self, const char* key, 
+                                             int** value);
+
+/**
+ * @brief Přičte @p delta k hodnotě záznamu s daným klíčem, chybějící záznam 
+ *        vloží s hodnotou @p delta .
+ *
+ * Klíč se hašuje a vyhledává jen jednou. Funkce není atomická.
+ *
+ * @param[in] self  Ukazatel na strukturu hašovací tabulky.
+ * @param[in] key   Klíč do tabulky.
+ * @param[in] delta Přičítaná hodnota.
+ *
+ * @return @c OK pokud byl záznam vložen, @c KEY_ALREADY_EXISTS pokud již 
+ *         existoval, @c MEMORY_ERROR při chybě alokace.
+ */
+hash_map_state_code_t hash_map_add(hash_map_t* self, const char* key, int delta);
+
+/*******************************************************************************
+ * Dávkové metody
+ ******************************************************************************/
+/**
+ * @brief Vyhledá najednou hodnoty @p count klíčů.
+ *
+ * Klíče se zpracovávají po dávkách: nejdříve se spočtou haše všech klíčů 
+ * dávky a vyžádá se načtení míst indexu a záznamů do cache, teprve pak se 
+ * klíče dohledají. Čekání na paměť se tak u velkých tabulek překrývá.
+ *
+ * Příklad užití:
+ * @code{.c}
+ * const char* keys[] = {"aloha", "hello"};
+ * int values[2];
+ * size_t found = hash_map_get_many(map, 2, keys, values, NULL);
+ * @endcode
+ *
+ * @param[in]  self   Ukazatel na strukturu hašovací tabulky.
+ * @param[in]  count  Počet klíčů.
+ * @param[in]  keys   Pole klíčů.
+ * @param[out] values Pole hodnot, u chybějících klíčů se hodnota nemění.
+ * @param[out] states Pole stavů (@c OK nebo @c KEY_ERROR ) jednotlivých 
+ *                    klíčů, může být @c NULL .
+ *
+ * @return Počet nalezených klíčů.
+ *
+ * @see hash_map_get
+ */
+size_t hash_map_get_many(hash_map_t* self, size_t count, const char* const* keys, 
+                         int* values, hash_map_state_code_t* states);
+
+/**
+ * @brief Vloží najednou @p count dvojic klíč-hodnota.
+ *
+ * Klíče se zpracovávají po dávkách stejně jako u hash_map_get_many, každá 
+ * dvojice se pak vloží jako hash_map_put (hodnota existujícího klíče se 
+ * přepíše). Pořadí vložení odpovídá pořadí v poli.
+ *
+ * @param[in]  self   Ukazatel na strukturu hašovací tabulky.
+ * @param[in]  count  Počet dvojic.
+ * @param[in]  keys   Pole klíčů.
+ * @param[in]  values Pole hodnot.
+ * @param[out] states Pole výsledků hash_map_put jednotlivých dvojic, může být 
+ *                    @c NULL .
+ *
+ * @return @c MEMORY_ERROR pokud se některou dvojici nepodařilo vložit 
+ *         (následující dvojice se už nevkládají), jinak @c OK.
+ *
+ * @see hash_map_put
+ */
+hash_map_state_code_t hash_map_put_many(hash_map_t* self, size_t count, 
+                                        const char* const* keys, const int* values, 
+                                        hash_map_state_code_t* states);
+
+/*******************************************************************************
+ * Metody s klíčem zadaným délkou
+ ******************************************************************************/
+/*
+ * Následující funkce se chovají stejně jako jejich varianty bez přípony _n, 
+ * klíč je ale zadán ukazatelem a délkou v bajtech. Klíč nemusí být ukončen 
+ * nulou (např. výřez síťového bufferu) a může obsahovat i nulové bajty. Do 
+ * tabulky se ukládá kopie klíče doplněná o ukončovací nulu spolu s délkou, 
+ * klíče se porovnávají nejdříve podle délky a pak funkcí memcmp.
+ */
+
+/**
+ * @brief Obsahuje tabulka záznam s klíčem @p key délky @p length ?
+ *
+ * @see hash_map_contains
+ */
+bool hash_map_contains_n(hash_map_t* self, const char* key, size_t length);
+
+/**
+ * @brief Vloží klíč @p key délky @p length a hodnotu do tabulky.
+ *
+ * @return Jako hash_map_put, navíc @c VALUE_ERROR pro klíč delší než 
+ *         @c UINT32_MAX bajtů.
+ *
+ * @see hash_map_put
+ */
+hash_map_state_code_t hash_map_put_n(hash_map_t* self, const char* key, 
+                                     size_t length, int value);
+
+/**
+ * @brief Uloží hodnotu asociovanou s klíčem @p key délky @p length .
+ *
+ * @see hash_map_get
+ */
+hash_map_state_code_t hash_map_get_n(hash_map_t* self, const char* key, 
+                                     size_t length, int* value);
+
+/**
+ * @brief Uloží hodnotu asociovanou s klíčem @p key délky @p length a odstraní 
+ *        záznam.
+ *
+ * @see hash_map_pop
+ */
+hash_map_state_code_t hash_map_pop_n(hash_map_t* self, const char* key, 
+                                     size_t length, int* value);
+
+/**
+ * @brief Odstraní záznam s klíčem @p key délky @p length .
+ *
+ * @see hash_map_remove
+ */
+hash_map_state_code_t hash_map_remove_n(hash_map_t* self, const char* key, 
+                                        size_t length);
+
+/**
+ * @brief Ukazatel na hodnotu záznamu s klíčem @p key délky @p length , 
+ *        chybějící záznam se vloží s hodnotou 0.
+ *
+ * @see hash_map_get_or_insert
+ */
+hash_map_state_code_t hash_map_get_or_insert_n(hash_map_t* self, const char* key, 
+                                               size_t length, int** value);
+
+/**
+ * @brief Přičte @p delta k hodnotě záznamu s klíčem @p key délky @p length .
+ *
+ * @see hash_map_add
+ */
+hash_map_state_code_t hash_map_add_n(hash_map_t* self, const char* key, 
+                                     size_t length, int delta);
+
+/*******************************************************************************
+ * Hodnoty libovolného typu
+ ******************************************************************************/
+/**
+ * @brief Nastaví velikost hodnoty uložené v každém záznamu.
+ *
+ * Hodnota (struktura, ukazatel, ...) leží v paměti hned za záznamem s 
+ * klíčem, zarovnaná na @c HASH_MAP_VALUE_ALIGN bajtů, takže přístup k ní 
+ * nevyžaduje další dereferenci. Vkládané záznamy mají hodnotu vynulovanou. 
+ * Celočíselná hodnota @c value a funkce pro ni zůstávají dostupné. Velikost 
+ * lze měnit jen u prázdné tabulky v rozložení @c HASH_MAP_LAYOUT_LINKED , 
+ * velikost 0 hodnotu za záznamem zruší.
+ *
+ * Příklad užití:
+ * @code{.c}
+ * typedef struct { double x, y; } point_t;
+ * hash_map_t* map = hash_map_ctor();
+ * hash_map_set_value_size(map, sizeof(point_t));
+ * point_t point = {1.0, 2.0};
+ * hash_map_put_value(map, "origin", &point);
+ * point_t* stored;
+ * hash_map_get_value_ptr(map, "origin", (void**)&stored);
+ * @endcode
+ *
+ * @param[in] self Ukazatel na strukturu hašovací tabulky.
+ * @param[in] size Velikost hodnoty v bajtech.
+ *
+ * @return @c VALUE_ERROR pokud tabulka obsahuje záznamy, má rozložení 
+ *         @c HASH_MAP_LAYOUT_COMPACT nebo je velikost příliš velká, jinak 
+ *         @c OK.
+ */
+hash_map_state_code_t hash_map_set_value_size(hash_map_t* self, size_t size);
+
+/**
+ * @brief Vloží klíč a zkopíruje k němu hodnotu nastavené velikosti.
+ *
+ * Existuje-li klíč, jeho hodnota se přepíše. Ve sdíleném režimu čtení se 
+ * záznam nahradí kopií s novou hodnotou, čtenáři tak nikdy nečtou napůl 
+ * přepsanou hodnotu.
+ *
+ * @param[in] self  Ukazatel na strukturu hašovací tabulky.
+ * @param[in] key   Klíč.
+ * @param[in] value Hodnota o @c value_size bajtech.
+ *
+ * @return Jako hash_map_put, @c MEMORY_ERROR i když se ve sdíleném režimu 
+ *         nepodaří alokovat kopii existujícího záznamu.
+ */
+hash_map_state_code_t hash_map_put_value(hash_map_t* self, const char* key, 
+                                         const void* value);
+
+/**
+ * @brief Zkopíruje hodnotu asociovanou s klíčem na místo @p value .
+ *
+ * Kopie je bezpečná i ve sdíleném režimu čtení.
+ *
+ * @return Vrací @c KEY_ERROR pokud se klíč nenachází v tabulce, 
+ *         jinak @c OK.
+ */
+hash_map_state_code_t hash_map_get_value(hash_map_t* self, const char* key, 
+                                         void* value);
+
+/**
+ * @brief Ukazatel na hodnotu asociovanou s klíčem (bez kopírování).
+ *
+ * Záznamy se v paměti nepřesouvají, ukazatel tedy zůstává platný, dokud se 
+ * záznam neodstraní nebo tabulka nevyprázdní. Hodnotu lze přes ukazatel i 
+ * měnit.
+ *
+ * @return Vrací @c KEY_ERROR pokud se klíč nenachází v tabulce, 
+ *         @c VALUE_ERROR ve sdíleném režimu čtení (záznam může zapisovatel 
+ *         kdykoliv uvolnit), jinak @c OK.
+ */
+hash_map_state_code_t hash_map_get_value_ptr(hash_map_t* self, const char* key, 
+                                             void** value);
+
+/**
+ * @brief Zkopíruje hodnotu asociovanou s klíčem na místo @p value a odstraní 
+ *        záznam.
+ *
+ * @p value může být @c NULL , hodnota se pak jen zahodí.
+ *
+ * @return Jako hash_map_pop.
+ */
+hash_map_state_code_t hash_map_pop_value(hash_map_t* self, const char* key, 
+                                         void* value);
+
+/**
+ * @brief Varianta hash_map_put_value s klíčem zadaným délkou.
+ */
+hash_map_state_code_t hash_map_put_value_n(hash_map_t* self, const char* key, 
+                                           size_t length, const void* value);
+
+/**
+ * @brief Varianta hash_map_get_value s klíčem zadaným délkou.
+ */
+hash_map_state_code_t hash_map_get_value_n(hash_map_t* self, const char* key, 
+                                           size_t length, void* value);
+
+/**
+ * @brief Varianta hash_map_get_value_ptr s klíčem zadaným délkou.
+ */
+hash_map_state_code_t hash_map_get_value_ptr_n(hash_map_t* self, const char* key, 
+                                               size_t length, void** value);
+
+/**
+ * @brief Varianta hash_map_pop_value s klíčem zadaným délkou.
+ */
+hash_map_state_code_t hash_map_pop_value_n(hash_map_t* self, const char* key, 
+                                           size_t length, void* value);
+
+/*******************************************************************************
+ * Režim cache
+ ******************************************************************************/
+/**
+ * @brief Nastaví největší počet záznamů tabulky a zapne režim cache (LRU).
+ *
+ * Seznam záznamů se v režimu cache řadí podle posledního použití: nalezený 
+ * klíč (hash_map_get, hash_map_get_n, hash_map_get_value, 
+ * hash_map_get_value_ptr, hash_map_get_many, hash_map_get_or_insert) i 
+ * přepsaný klíč (hash_map_put, hash_map_add, ...) se přesune na konec 
+ * seznamu. Když vložení zvýší počet záznamů nad limit, odstraní se záznam 
+ * ze začátku seznamu (nejdéle nepoužitý) a zavolá se pro něj funkce 
+ * nastavená hash_map_set_evict_function. Funkce hash_map_contains pořadí 
+ * nemění. Přesun i odstranění mají konstantní složitost a nevyžadují 
+ * žádnou paměť navíc.
+ *
+ * Příklad užití:
+ * @code{.c}
+ * hash_map_t* cache = hash_map_ctor();
+ * hash_map_set_cache_limit(cache, 1000);
+ * int value;
+ * if (hash_map_get(cache, key, &value) == KEY_ERROR)
+ * {
+ *     value = compute(key);
+ *     hash_map_put(cache, key, value);
+ * }
+ * @endcode
+ *
+ * @param[in] self  Ukazatel na strukturu hašovací tabulky.
+ * @param[in] limit Největší počet záznamů, 0 režim cache vypne.
+ *
+ * @return @c VALUE_ERROR pro rozložení @c HASH_MAP_LAYOUT_COMPACT (pořadí 
+ *         seznamu je pořadím pole) nebo sdílený režim čtení (čtenáři 
+ *         seznam nemění), jinak @c OK. Záznamy nad nový limit se hned 
+ *         odstraní.
+ */
+hash_map_state_code_t hash_map_set_cache_limit(hash_map_t* self, size_t limit);
+
+/**
+ * @brief Nastaví funkci volanou pro záznamy odstraněné kvůli limitu cache.
+ *
+ * Funkce se nevolá při odstranění záznamu uživatelem (hash_map_pop, ...), 
+ * vyprázdnění ani zrušení tabulky.
+ *
+ * @param[in] self     Ukazatel na strukturu hašovací tabulky.
+ * @param[in] function Volaná funkce, nebo @c NULL .
+ * @param[in] context  Kontext předaný funkci.
+ *
+ * @return @c OK.
+ */
+hash_map_state_code_t hash_map_set_evict_function(hash_map_t* self, 
+                                                  hash_map_evict_function_t function, 
+                                                  void* context);
+
+/**
+ * @brief Čítače nalezených a nenalezených klíčů a odstraněných záznamů v 
+ *        režimu cache.
+ *
+ * Počítá se jen při zapnutém režimu cache, čítače se nenulují.
+ */
+hash_map_cache_stats_t hash_map_cache_stats(hash_map_t* self);
+
+/*******************************************************************************
+ * Statistiky
+ ******************************************************************************/
+/**
+ * @brief Statistiky indexu tabulky.
+ *
+ * Délka hledání je počet míst indexu navštívených za výchozím místem (u 
+ * enginu skupin počet skupin za první skupinou), úspěšné hledání s délkou 0 
+ * tedy přečte jediné místo. Délka úspěšného hledání se měří pro každý 
+ * záznam, délka neúspěšného se odhaduje z nejvýše 
+ * @c HASH_MAP_STATS_MISS_SAMPLES náhodných hašů. Během postupného 
+ * zvětšování se záznamy, které jsou ještě ve starém indexu, hledají nejdříve 
+ * neúspěšně v novém a pak ve starém indexu, délka hledání zahrnuje obojí; 
+ * stejně tak neúspěšné hledání.
+ *
+ * Čítače přestavění indexu (@c resizes , @c resize_ns ) se počítají jen při 
+ * překladu s makrem @c HASH_MAP_STATS_RESIZE (volba CMake stejného jména), 
+ * jinak jsou nulové. Počítá se každé přestavění (zvětšení, zmenšení, 
+ * odstranění @c dummy objektů, změna enginu či hašovací funkce) a u 
+ * postupného zvětšování jen alokace nového indexu, nikoliv přesun záznamů.
+ *
+ * @see hash_map_stats
+ */
+typedef struct hash_map_stats
+{
+    size_t size;                ///< Počet záznamů
+    size_t capacity;            ///< Velikost indexu
+    size_t tombstones;          ///< Místa indexu s @c dummy objektem
+    double load_factor;         ///< Zaplnění indexu záznamy
+    /** Zaplnění indexu záznamy i @c dummy objekty, podle něj se index 
+     *  zvětšuje. */
+    double occupied_factor;
+    /** Počet záznamů podle délky úspěšného hledání. */
+    size_t probe_histogram[HASH_MAP_STATS_HISTOGRAM_SIZE];
+    double hit_probe_avg;       ///< Průměrná délka úspěšného hledání
+    size_t hit_probe_max;       ///< Největší délka úspěšného hledání
+    double miss_probe_avg;      ///< Průměrná délka neúspěšného hledání
+    size_t miss_probe_max;      ///< Největší délka neúspěšného hledání
+    /** Paměť tabulky v bajtech (struktura, index, řídicí bajty, bloky 
+     *  záznamů a arény, pole záznamů, starý index postupného zvětšování a 
+     *  vyřazená paměť čekající na uvolnění). */
+    size_t bytes;
+    size_t resizes;             ///< Počet přestavění indexu
+    uint64_t resize_ns;         ///< Celková doba přestavění indexu v ns
+} hash_map_stats_t;
+
+/**
+ * @brief Zjistí statistiky indexu tabulky.
+ *
+ * Prochází všechny záznamy (složitost je úměrná velikosti tabulky), je 
+ * určena pro diagnostiku, ne pro časté volání. Tabulku nemění, ani 
+ * rozpracované postupné zvětšování indexu nepřesune žádný záznam.
+ *
+ * Příklad užití:
+ * @code{.c}
+ * hash_map_stats_t stats = hash_map_stats(map);
+ * printf("zaplneni %.2f, dummy %zu, prumerne hledani %.2f / %.2f\n", 
+ *        stats.load_factor, stats.tombstones, stats.hit_probe_avg, 
+ *        stats.miss_probe_avg);
+ * @endcode
+ *
+ * @param[in] self Ukazatel na strukturu hašovací tabulky.
+ *
+ * @return Statistiky tabulky.
+ */
+hash_map_stats_t hash_map_stats(hash_map_t* self);
+
+/*******************************************************************************
+ * Zmrazená tabulka
+ ******************************************************************************/
+/**
+ * @brief Neměnná tabulka s minimální perfektní hašovací funkcí.
+ *
+ * Klíče se rozdělí do skupin podle haše (v průměru 
+ * @c HASH_MAP_FROZEN_BUCKET_SIZE klíčů) a každá skupina dostane posunutí 
+ * (CHD, compress-hash-displace), které její klíče umístí na volná místa 
+ * pole o velikosti přesně @c size . Posunutí tvoří dvojice: číslo míchání 
+ * (horních 24 bitů, určuje rozestupy klíčů skupiny) a posun (dolních 40 
+ * bitů). Hledání tedy přečte posunutí skupiny a porovná klíč na jediném 
+ * místě, bez procházení a bez operace modulo. Klíče leží za sebou v 
+ * souvislém bloku @c keys v pořadí míst, délka klíče je rozdíl sousedních 
+ * @c offsets .
+ *
+ * Zmrazená tabulka používá vždy výchozí hašovací funkci, takže na kvalitě 
+ * hašovací funkce zdrojové tabulky nezávisí. Tabulka se po vytvoření nemění 
+ * a mohou ji bez synchronizace číst libovolná vlákna.
+ *
+ * @see hash_map_freeze
+ */
+typedef struct hash_map_frozen
+{
+    size_t size;                ///< Počet klíčů a míst
+    size_t buckets;             ///< Počet skupin
+    uint64_t* displacement;     ///< Posunutí skupin
+    size_t* offsets;            ///< Začátky klíčů v @c keys (@c size + 1)
+    char* keys;                 ///< Klíče v pořadí míst bez ukončovacích nul
+    int* values;                ///< Celočíselné hodnoty v pořadí míst
+    size_t value_size;          ///< Velikost hodnot v @c value_data
+    char* value_data;           ///< Hodnoty nastavené velikosti v pořadí míst
+    size_t bytes;               ///< Velikost alokovaného bloku, resp. souboru v bajtech
+    void* mapping;              ///< Namapovaný soubor (hash_map_frozen_load), jinak NULL
+} hash_map_frozen_t;
+
+/**
+ * @brief Vytvoří ze záznamů tabulky neměnnou tabulku pro rychlé hledání.
+ *
+ * Zdrojová tabulka se nemění a lze ji dál používat nebo zrušit. Kopírují se 
+ * klíče, celočíselné hodnoty i hodnoty nastavené velikosti (viz 
+ * hash_map_set_value_size).
+ *
+ * Příklad užití:
+ * @code{.c}
+ * hash_map_frozen_t* frozen;
+ * if (hash_map_freeze(map, &frozen) == OK)
+ * {
+ *     hash_map_dtor(map);
+ *     int value;
+ *     hash_map_frozen_get(frozen, "key", &value);
+ *     hash_map_frozen_dtor(frozen);
+ * }
+ * @endcode
+ *
+ * @param[in]  self   Ukazatel na strukturu hašovací tabulky.
+ * @param[out] frozen Místo pro ukazatel na zmrazenou tabulku.
+ *
+ * @return @c MEMORY_ERROR při chybě alokace, @c VALUE_ERROR pokud se klíče 
+ *         nepodařilo rozmístit (shodné 64bitové haše různých klíčů), jinak 
+ *         @c OK.
+ */
+hash_map_state_code_t hash_map_freeze(hash_map_t* self, hash_map_frozen_t** frozen);
+
+/**
+ * @brief Zruší zmrazenou tabulku, resp. odmapuje její soubor.
+ */
+void hash_map_frozen_dtor(hash_map_frozen_t* self);
+
+/**
+ * @brief Počet klíčů zmrazené tabulky.
+ */
+size_t hash_map_frozen_size(const hash_map_frozen_t* self);
+
+/**
+ * @brief Obsahuje zmrazená tabulka klíč @p key ?
+ */
+bool hash_map_frozen_contains(const hash_map_frozen_t* self, const char* key);
+
+/**
+ * @brief Uloží celočíselnou hodnotu klíče ze zmrazené tabulky.
+ *
+ * @return Vrací @c KEY_ERROR pokud se klíč nenachází v tabulce, 
+ *         jinak @c OK.
+ */
+hash_map_state_code_t hash_map_frozen_get(const hash_map_frozen_t* self, const char* key, 
+                                          int* value);
+
+/**
+ * @brief Zkopíruje hodnotu nastavené velikosti klíče ze zmrazené tabulky do 
+ *        @p value .
+ *
+ * Hodnoty leží ve zmrazené tabulce těsně za sebou bez zarovnání, proto se 
+ * kopírují (viz hash_map_get_value).
+ *
+ * @return Vrací @c KEY_ERROR pokud se klíč nenachází v tabulce, 
+ *         @c VALUE_ERROR pokud tabulka hodnoty nastavené velikosti nemá, 
+ *         jinak @c OK.
+ */
+hash_map_state_code_t hash_map_frozen_get_value(const hash_map_frozen_t* self, 
+                                                const char* key, void* value);
+
+/**
+ * @brief Varianta hash_map_frozen_contains s klíčem zadaným délkou.
+ */
+bool hash_map_frozen_contains_n(const hash_map_frozen_t* self, const char* key, 
+                                size_t length);
+
+/**
+ * @brief Varianta hash_map_frozen_get s klíčem zadaným délkou.
+ */
+hash_map_state_code_t hash_map_frozen_get_n(const hash_map_frozen_t* self, const char* key, 
+                                            size_t length, int* value);
+
+/**
+ * @brief Varianta hash_map_frozen_get_value s klíčem zadaným délkou.
+ */
+hash_map_state_code_t hash_map_frozen_get_value_n(const hash_map_frozen_t* self, 
+                                                  const char* key, size_t length, 
+                                                  void* value);
+
+/**
+ * @brief Uloží zmrazenou tabulku do souboru, který lze otevřít funkcí 
+ *        hash_map_frozen_load.
+ *
+ * Soubor začíná 64bajtovou hlavičkou (značka, verze, velikost @c size_t , 
+ * kontrola pořadí bajtů, počty klíčů a skupin, velikost hodnot a délka 
+ * klíčů) a pokračuje poli tabulky v pořadí posunutí, začátky klíčů, 
+ * celočíselné hodnoty, hodnoty nastavené velikosti a klíče. Pole obsahují jen 
+ * čísla a posuny, nikoliv ukazatele, soubor tedy nezávisí na adrese, na 
+ * kterou se namapuje. Soubor lze přenést jen na stroj se stejnou velikostí 
+ * @c size_t a pořadím bajtů.
+ *
+ * @param[in] self Ukazatel na zmrazenou tabulku.
+ * @param[in] path Cesta k souboru, existující soubor se přepíše.
+ *
+ * @return @c IO_ERROR při chybě zápisu, jinak @c OK.
+ */
+hash_map_state_code_t hash_map_frozen_save(const hash_map_frozen_t* self, const char* path);
+
+/**
+ * @brief Uloží záznamy tabulky do souboru (viz hash_map_frozen_save).
+ *
+ * Tabulku zmrazí (hash_map_freeze), uloží a zmrazenou kopii zruší. Soubor 
+ * se otevře funkcí hash_map_frozen_load.
+ *
+ * @param[in] self Ukazatel na strukturu hašovací tabulky.
+ * @param[in] path Cesta k souboru, existující soubor se přepíše.
+ *
+ * @return @c MEMORY_ERROR , @c VALUE_ERROR (viz hash_map_freeze), 
+ *         @c IO_ERROR při chybě zápisu, jinak @c OK.
+ */
+hash_map_state_code_t hash_map_save(hash_map_t* self, const char* path);
+
+/**
+ * @brief Otevře soubor uložený funkcí hash_map_frozen_save jako zmrazenou 
+ *        tabulku.
+ *
+ * Soubor se jen namapuje do paměti (mmap, pouze pro čtení) a pole tabulky 
+ * ukazují přímo do něj, nic se nekopíruje ani nepřepočítává. Otevření tak 
+ * trvá stejně dlouho pro libovolný počet klíčů, stránky souboru načte 
+ * systém až při hledání. Kontroluje se hlavička a velikost souboru, nikoliv 
+ * obsah polí; soubor proto musí pocházet z důvěryhodného zdroje.
+ *
+ * Tabulku je nutné zrušit funkcí hash_map_frozen_dtor, která soubor odmapuje.
+ *
+ * @param[in]  path   Cesta k souboru.
+ * @param[out] frozen Místo pro ukazatel na zmrazenou tabulku.
+ *
+ * @return @c IO_ERROR pokud soubor nelze otevřít nebo namapovat, 
+ *         @c VALUE_ERROR pokud soubor není platná zmrazená tabulka pro tento 
+ *         stroj, @c MEMORY_ERROR při chybě alokace, jinak @c OK.
+ */
+hash_map_state_code_t hash_map_frozen_load(const char* path, hash_map_frozen_t** frozen);
+
+/*******************************************************************************
+ * Souběžná tabulka
+ ******************************************************************************/
+/**
+ * @brief Shard souběžné tabulky.
+ *
+ * Zapisovatel drží zámek a před změnou i po ní zvýší verzi, během změny je 
+ * tedy verze lichá (seqlock). Čtenář shard nezamyká: přečte sudou verzi, 
+ * vyhledá klíč a výsledek platí, pokud se verze mezitím nezměnila.
+ */
+typedef struct hash_map_shard
+{
+    pthread_mutex_t lock;       ///< Zámek zapisovatelů
+    uint64_t version;           ///< Verze shardu, lichá během změny
+    hash_map_t* map;            ///< Tabulka shardu
+} hash_map_shard_t;
+
+/**
+ * @brief Hašovací tabulka pro souběžný přístup z více vláken.
+ *
+ * Klíče jsou rozděleny do nezávisle zamykaných shardů (@c hash_map_t ) podle 
+ * vyšších bitů součinu haše s Fibonacciho konstantou, takže výběr shardu 
+ * nekoreluje s otiskem ani s pozicí klíče v indexu shardu. Čtení je 
+ * optimistické bez zámku, viz hash_map_shard_t. Paměť nahrazená při změnách 
+ * shardu uvolňují zapisovatelé pod zámkem shardu, až skončí všechna dříve 
+ * započatá čtení (viz @c defer_free ), čtenář proto nikdy nečte uvolněnou 
+ * paměť.
+ */
+typedef struct hash_map_concurrent
+{
+    hash_map_shard_t* shards;   ///< Pole shardů
+    size_t shard_count;         ///< Počet shardů (mocnina dvou)
+    unsigned shard_bits;        ///< Dvojkový logaritmus počtu shardů
+    hash_map_hash_function_t hash_function; ///< Hašovací funkce všech shardů
+} hash_map_concurrent_t;
+
+/**
+ * @brief Konstruktor souběžné hašovací tabulky.
+ *
+ * Příklad užití:
+ * @code{.c}
+ * hash_map_concurrent_t* map = hash_map_concurrent_ctor(0);
+ * // z libovolneho vlakna
+ * hash_map_concurrent_put(map, "aloha", 1);
+ * @endcode
+ *
+ * @param[in] shards Počet shardů, zaokrouhlí se nahoru na mocninu dvou, 0 
+ *                   znamená @c HASH_MAP_CONCURRENT_SHARDS .
+ *
+ * @return Ukazatel na tabulku, nebo @c NULL při chybě alokace.
+ */
+hash_map_concurrent_t* hash_map_concurrent_ctor(size_t shards);
+
+/**
+ * @brief Destruktor souběžné hašovací tabulky.
+ *
+ * @warning Tabulku nesmí v době zrušení používat žádné jiné vlákno.
+ */
+void hash_map_concurrent_dtor(hash_map_concurrent_t* self);
+
+/**
+ * @brief Počet záznamů ve všech shardech.
+ *
+ * Při souběžných změnách jde o přibližný údaj.
+ */
+size_t hash_map_concurrent_size(hash_map_concurrent_t* self);
+
+/**
+ * @brief Ověří existenci klíče bez zamykání.
+ *
+ * @see hash_map_contains
+ */
+bool hash_map_concurrent_contains(hash_map_concurrent_t* self, const char* key);
+
+/**
+ * @brief Vloží nebo přepíše hodnotu klíče.
+ *
+ * @see hash_map_put
+ */
+hash_map_state_code_t hash_map_concurrent_put(hash_map_concurrent_t* self, 
+                                              const char* key, int value);
+
+/**
+ * @brief Uloží hodnotu asociovanou s klíčem bez zamykání.
+ *
+ * Shard se zamkne jen tehdy, když se ho během @c HASH_MAP_OPTIMISTIC_RETRIES 
+ * pokusů nepodaří přečíst bez souběžné změny.
+ *
+ * @see hash_map_get
+ */
+hash_map_state_code_t hash_map_concurrent_get(hash_map_concurrent_t* self, 
+                                              const char* key, int* value);
+
+/**
+ * @brief Atomicky přičte @p delta k hodnotě klíče, chybějící klíč vloží.
+ *
+ * @see hash_map_add
+ */
+hash_map_state_code_t hash_map_concurrent_add(hash_map_concurrent_t* self, 
+                                              const char* key, int delta);
+
+/**
+ * @brief Uloží hodnotu asociovanou s klíčem a odstraní záznam.
+ *
+ * @see hash_map_pop
+ */
+hash_map_state_code_t hash_map_concurrent_pop(hash_map_concurrent_t* self, 
+                                              const char* key, int* value);
+
 }       // extern "C" ending
 
 #endif  // HASH_MAP_H_
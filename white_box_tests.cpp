@@ -13,7 +13,14 @@
  * @brief Implementace testu hasovaci tabulky.
  */
 
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <thread>
 #include <vector>
+#include <unistd.h>
 
 #include "gtest/gtest.h"
 
@@ -257,4 +264,1891 @@ TEST_F(HashMapTest, clear)
 	EXPECT_EQ(hash_map_contains(table, "key"), false);
 }
 
+// hash function
+TEST_F(HashMapTest, default_hash_anagrams)
+{
+	EXPECT_NE(hash_map_default_hash("ab", 2), hash_map_default_hash("ba", 2));
+	EXPECT_NE(hash_map_default_hash("abc", 3), hash_map_default_hash("cba", 3));
+	EXPECT_EQ(hash_map_additive_hash("abc", 3), hash_map_additive_hash("cba", 3));
+}
+
+TEST_F(HashMapTest, default_hash_lengths)
+{
+	std::string key(100, 'x');
+	// klice vsech delek se stejnym obsahem se musi lisit
+	std::vector<size_t> hashes;
+	for (size_t len = 0; len <= key.size(); len++)
+	{
+		hashes.push_back(hash_map_default_hash(key.c_str(), len));
+	}
+	std::sort(hashes.begin(), hashes.end());
+	EXPECT_EQ(std::unique(hashes.begin(), hashes.end()), hashes.end());
+}
+
+TEST_F(HashMapTest, set_hash_function)
+{
+	int value;
+	ASSERT_EQ(hash_map_put(table, "abc", 1), OK);
+	ASSERT_EQ(hash_map_put(table, "key", 2), OK);
+	ASSERT_EQ(hash_map_set_hash_function(table, hash_map_additive_hash), OK);
+	EXPECT_EQ(table->first->hash, hash_map_additive_hash("abc", 3));
+	ASSERT_EQ(hash_map_put(table, "cba", 3), OK);
+	ASSERT_EQ(hash_map_get(table, "abc", &value), OK);
+	EXPECT_EQ(value, 1);
+	ASSERT_EQ(hash_map_get(table, "cba", &value), OK);
+	EXPECT_EQ(value, 3);
+	ASSERT_EQ(hash_map_set_hash_function(table, NULL), OK);
+	EXPECT_EQ(table->hash_function, hash_map_default_hash);
+	ASSERT_EQ(hash_map_get(table, "key", &value), OK);
+	EXPECT_EQ(value, 2);
+}
+
+TEST_F(HashMapTest, get_after_growth)
+{
+	int value;
+	std::string key;
+	for (int i = 0; i < 1000; i++)
+	{
+		key = "key" + std::to_string(i);
+		ASSERT_EQ(hash_map_put(table, key.c_str(), i), OK);
+	}
+	for (int i = 0; i < 1000; i++)
+	{
+		key = "key" + std::to_string(i);
+		ASSERT_EQ(hash_map_get(table, key.c_str(), &value), OK);
+		EXPECT_EQ(value, i);
+	}
+}
+
+// capacity policy
+TEST_F(HashMapTest, capacity_policy_power_of_two)
+{
+	int value;
+	ASSERT_EQ(hash_map_reserve(table, 100), OK);
+	ASSERT_EQ(hash_map_put(table, "key", 1), OK);
+	EXPECT_EQ(table->mask, 0);
+	ASSERT_EQ(hash_map_set_capacity_policy(table, HASH_MAP_CAPACITY_POWER_OF_TWO), OK);
+	EXPECT_EQ(hash_map_capacity(table), 128);
+	EXPECT_EQ(table->mask, 127);
+	ASSERT_EQ(hash_map_get(table, "key", &value), OK);
+	EXPECT_EQ(value, 1);
+	ASSERT_EQ(hash_map_reserve(table, 129), OK);
+	EXPECT_EQ(hash_map_capacity(table), 256);
+}
+
+TEST_F(HashMapTest, arbitrary_capacity_probing)
+{
+	int value;
+	std::string key;
+	ASSERT_EQ(hash_map_reserve(table, 1001), OK);
+	// soucetovy has zpusobi dlouhe retezce kolizi, linearni prochazeni musi vsechny najit
+	ASSERT_EQ(hash_map_set_hash_function(table, hash_map_additive_hash), OK);
+	for (int i = 0; i < 600; i++)
+	{
+		key = "key" + std::to_string(i);
+		ASSERT_EQ(hash_map_put(table, key.c_str(), i), OK);
+	}
+	EXPECT_EQ(hash_map_capacity(table), 1001);
+	for (int i = 0; i < 600; i++)
+	{
+		key = "key" + std::to_string(i);
+		ASSERT_EQ(hash_map_get(table, key.c_str(), &value), OK);
+		EXPECT_EQ(value, i);
+	}
+	EXPECT_EQ(hash_map_get(table, "key600", &value), KEY_ERROR);
+}
+
+TEST_F(HashMapTest, reserve_zero)
+{
+	int value;
+	ASSERT_EQ(hash_map_reserve(table, 0), OK);
+	ASSERT_EQ(hash_map_put(table, "key", 1), OK);
+	ASSERT_EQ(hash_map_get(table, "key", &value), OK);
+	EXPECT_EQ(value, 1);
+}
+
+// ridici bajty indexu
+TEST_F(HashMapTest, ctrl_matches_index)
+{
+	std::string key;
+	for (int i = 0; i < 100; i++)
+	{
+		key = "key" + std::to_string(i);
+		ASSERT_EQ(hash_map_put(table, key.c_str(), i), OK);
+	}
+	for (int i = 0; i < 100; i += 3)
+	{
+		key = "key" + std::to_string(i);
+		ASSERT_EQ(hash_map_remove(table, key.c_str()), OK);
+	}
+	size_t full = 0;
+	for (size_t i = 0; i < table->allocated; i++)
+	{
+		if (table->index[i] == NULL)
+		{
+			EXPECT_EQ(table->ctrl[i], HASH_MAP_CTRL_EMPTY);
+		}
+		else if (table->index[i] == table->dummy)
+		{
+			EXPECT_EQ(table->ctrl[i], HASH_MAP_CTRL_DELETED);
+		}
+		else
+		{
+			EXPECT_LT(table->ctrl[i], 0x80);
+			EXPECT_EQ(table->ctrl[i], table->index[i]->hash >> (sizeof(size_t)*8 - 7));
+			full++;
+		}
+	}
+	EXPECT_EQ(full, hash_map_size(table));
+
+	hash_map_clear(table);
+	for (size_t i = 0; i < table->allocated; i++)
+	{
+		EXPECT_EQ(table->ctrl[i], HASH_MAP_CTRL_EMPTY);
+	}
+}
+
+TEST_F(HashMapTest, ctrl_same_tag_different_keys)
+{
+	int value;
+	// "ab" a "ba" maji stejny soucetovy has, tedy i stejny otisk
+	ASSERT_EQ(hash_map_set_hash_function(table, hash_map_additive_hash), OK);
+	ASSERT_EQ(hash_map_put(table, "ab", 1), OK);
+	ASSERT_EQ(hash_map_put(table, "ba", 2), OK);
+	EXPECT_EQ(hash_map_get(table, "ab", &value), OK);
+	EXPECT_EQ(value, 1);
+	EXPECT_EQ(hash_map_get(table, "ba", &value), OK);
+	EXPECT_EQ(value, 2);
+	EXPECT_EQ(hash_map_contains(table, "aa"), false);
+}
+
+// engine skupin
+TEST_F(HashMapTest, engine_groups_capacity)
+{
+	ASSERT_EQ(hash_map_set_engine(table, HASH_MAP_ENGINE_GROUPS), OK);
+	EXPECT_EQ(hash_map_capacity(table), HASH_MAP_GROUP_SIZE);
+	ASSERT_EQ(hash_map_reserve(table, 100), OK);
+	EXPECT_EQ(hash_map_capacity(table), 128);
+	EXPECT_EQ(table->mask, 127);
+}
+
+TEST_F(HashMapTest, engine_groups_keeps_order)
+{
+	int value;
+	std::string key;
+	for (int i = 0; i < 50; i++)
+	{
+		key = "key" + std::to_string(i);
+		ASSERT_EQ(hash_map_put(table, key.c_str(), i), OK);
+	}
+	ASSERT_EQ(hash_map_set_engine(table, HASH_MAP_ENGINE_GROUPS), OK);
+	for (int i = 50; i < 1000; i++)
+	{
+		key = "key" + std::to_string(i);
+		ASSERT_EQ(hash_map_put(table, key.c_str(), i), OK);
+	}
+	EXPECT_EQ(hash_map_size(table), 1000);
+	// index se zvetsuje az pri zaplneni 7/8
+	EXPECT_EQ(hash_map_capacity(table), 2048);
+
+	int expected = 0;
+	for (hash_map_item_t* item = table->first; item != NULL; item = item->next)
+	{
+		EXPECT_EQ(item->value, expected++);
+	}
+	EXPECT_EQ(expected, 1000);
+	EXPECT_EQ(table->last->value, 999);
+	for (int i = 0; i < 1000; i++)
+	{
+		key = "key" + std::to_string(i);
+		ASSERT_EQ(hash_map_get(table, key.c_str(), &value), OK);
+		EXPECT_EQ(value, i);
+	}
+	EXPECT_EQ(hash_map_contains(table, "key1000"), false);
+}
+
+TEST_F(HashMapTest, engine_groups_collisions)
+{
+	int value;
+	std::string key;
+	ASSERT_EQ(hash_map_set_engine(table, HASH_MAP_ENGINE_GROUPS), OK);
+	// vsechny permutace maji stejny soucetovy has a zaplni vice skupin
+	ASSERT_EQ(hash_map_set_hash_function(table, hash_map_additive_hash), OK);
+	std::string letters = "abcde";
+	int count = 0;
+	do
+	{
+		ASSERT_EQ(hash_map_put(table, letters.c_str(), count++), OK);
+	} while (std::next_permutation(letters.begin(), letters.end()));
+	EXPECT_EQ(hash_map_size(table), 120);
+
+	letters = "abcde";
+	count = 0;
+	do
+	{
+		ASSERT_EQ(hash_map_get(table, letters.c_str(), &value), OK);
+		EXPECT_EQ(value, count++);
+	} while (std::next_permutation(letters.begin(), letters.end()));
+	EXPECT_EQ(hash_map_contains(table, "aabcd"), false);
+}
+
+TEST_F(HashMapTest, engine_groups_put_after_pop)
+{
+	int value;
+	ASSERT_EQ(hash_map_set_engine(table, HASH_MAP_ENGINE_GROUPS), OK);
+	ASSERT_EQ(hash_map_set_hash_function(table, hash_map_additive_hash), OK);
+	ASSERT_EQ(hash_map_put(table, "ab", 1), OK);
+	ASSERT_EQ(hash_map_put(table, "ba", 2), OK);
+	ASSERT_EQ(hash_map_pop(table, "ab", &value), OK);
+	EXPECT_EQ(value, 1);
+	// misto po "ab" je pred "ba", klic se presto nesmi vlozit podruhe
+	EXPECT_EQ(hash_map_put(table, "ba", 3), KEY_ALREADY_EXISTS);
+	EXPECT_EQ(hash_map_size(table), 1);
+	ASSERT_EQ(hash_map_put(table, "ab", 4), OK);
+	EXPECT_EQ(hash_map_size(table), 2);
+	EXPECT_EQ(table->first->value, 3);
+	EXPECT_EQ(table->last->value, 4);
+}
+
+// engine Robin Hood
+/**
+ * @brief Zaznam, ktery neni na sve vychozi pozici, ma pred sebou obsazene 
+ *        misto se vzdalenosti alespon o jednu mensi.
+ */
+static void expect_robin_order(hash_map_t* table)
+{
+	for (size_t i = 0; i < table->allocated; i++)
+	{
+		if (table->ctrl[i] == HASH_MAP_CTRL_EMPTY || table->dist[i] == 0)
+		{
+			continue;
+		}
+		size_t prev = i == 0 ? table->allocated - 1 : i - 1;
+		ASSERT_NE(table->ctrl[prev], HASH_MAP_CTRL_EMPTY);
+		EXPECT_GE(table->dist[prev] + 1, table->dist[i]);
+	}
+}
+
+TEST_F(HashMapTest, engine_robin_hood_high_load)
+{
+	int value;
+	std::string key;
+	ASSERT_EQ(hash_map_set_engine(table, HASH_MAP_ENGINE_ROBIN_HOOD), OK);
+	ASSERT_NE(table->dist, nullptr);
+	for (int i = 0; i < 900; i++)
+	{
+		key = "key" + std::to_string(i);
+		ASSERT_EQ(hash_map_put(table, key.c_str(), i), OK);
+	}
+	// index se zvetsuje az pri zaplneni 9/10
+	EXPECT_EQ(hash_map_capacity(table), 1024);
+	expect_robin_order(table);
+	for (int i = 0; i < 900; i++)
+	{
+		key = "key" + std::to_string(i);
+		ASSERT_EQ(hash_map_get(table, key.c_str(), &value), OK);
+		EXPECT_EQ(value, i);
+	}
+	EXPECT_EQ(hash_map_contains(table, "key900"), false);
+	EXPECT_EQ(table->first->value, 0);
+	EXPECT_EQ(table->last->value, 899);
+
+	// zaznamy se v indexu posouvaji, sdileny rezim cteni neni podporovan
+	EXPECT_EQ(hash_map_set_read_policy(table, HASH_MAP_READ_SHARED), VALUE_ERROR);
+	ASSERT_EQ(hash_map_set_engine(table, HASH_MAP_ENGINE_PROBING), OK);
+	ASSERT_EQ(hash_map_set_read_policy(table, HASH_MAP_READ_SHARED), OK);
+	EXPECT_EQ(hash_map_set_engine(table, HASH_MAP_ENGINE_ROBIN_HOOD), VALUE_ERROR);
+	EXPECT_EQ(table->engine, HASH_MAP_ENGINE_PROBING);
+	ASSERT_EQ(hash_map_get(table, "key899", &value), OK);
+}
+
+TEST_F(HashMapTest, engine_robin_hood_backward_shift)
+{
+	int value;
+	std::string key;
+	ASSERT_EQ(hash_map_set_engine(table, HASH_MAP_ENGINE_ROBIN_HOOD), OK);
+	ASSERT_EQ(hash_map_reserve(table, 512), OK);
+	for (int i = 0; i < 450; i++)
+	{
+		key = "key" + std::to_string(i);
+		ASSERT_EQ(hash_map_put(table, key.c_str(), i), OK);
+	}
+	for (int i = 0; i < 450; i += 3)
+	{
+		key = "key" + std::to_string(i);
+		ASSERT_EQ(hash_map_pop(table, key.c_str(), &value), OK);
+		EXPECT_EQ(value, i);
+	}
+	// odstraneni nezanechava dummy objekty
+	EXPECT_EQ(table->deleted, 0);
+	expect_robin_order(table);
+	for (int i = 0; i < 450; i++)
+	{
+		key = "key" + std::to_string(i);
+		EXPECT_EQ(hash_map_contains(table, key.c_str()), i % 3 != 0);
+	}
+	EXPECT_EQ(hash_map_size(table), 300);
+}
+
+/** Hasovaci funkce, se kterou maji vsechny klice stejnou vychozi pozici. */
+static size_t constant_hash(const char* key, size_t length)
+{
+	(void)key;
+	(void)length;
+	return 42;
+}
+
+TEST_F(HashMapTest, engine_robin_hood_long_distances)
+{
+	int value;
+	std::string key;
+	ASSERT_EQ(hash_map_set_engine(table, HASH_MAP_ENGINE_ROBIN_HOOD), OK);
+	ASSERT_EQ(hash_map_set_hash_function(table, constant_hash), OK);
+	// vzdalenosti presahnou rozsah dist a dopocitavaji se z hase
+	for (int i = 0; i < 400; i++)
+	{
+		key = "key" + std::to_string(i);
+		ASSERT_EQ(hash_map_put(table, key.c_str(), i), OK);
+	}
+	EXPECT_EQ(table->dist[(42 + 300) & table->mask], HASH_MAP_ROBIN_MAX_DISTANCE);
+	for (int i = 0; i < 400; i += 2)
+	{
+		key = "key" + std::to_string(i);
+		ASSERT_EQ(hash_map_pop(table, key.c_str(), &value), OK);
+	}
+	for (int i = 0; i < 400; i++)
+	{
+		key = "key" + std::to_string(i);
+		EXPECT_EQ(hash_map_get(table, key.c_str(), &value), i % 2 == 0 ? KEY_ERROR : OK);
+	}
+	EXPECT_EQ(hash_map_put(table, "key399", 0), KEY_ALREADY_EXISTS);
+}
+
+TEST_F(HashMapTest, engine_robin_hood_compact)
+{
+	int value;
+	std::string key;
+	ASSERT_EQ(hash_map_set_layout(table, HASH_MAP_LAYOUT_COMPACT), OK);
+	ASSERT_EQ(hash_map_set_engine(table, HASH_MAP_ENGINE_ROBIN_HOOD), OK);
+	// odstranovani zaplni pole zaznamu, index se prestavi na miste
+	for (int round = 0; round < 10; round++)
+	{
+		for (int i = 0; i < 100; i++)
+		{
+			key = "key" + std::to_string(round * 100 + i);
+			ASSERT_EQ(hash_map_put(table, key.c_str(), i), OK);
+		}
+		for (int i = 0; i < 90; i++)
+		{
+			key = "key" + std::to_string(round * 100 + i);
+			ASSERT_EQ(hash_map_remove(table, key.c_str()), OK);
+		}
+	}
+	EXPECT_EQ(hash_map_size(table), 100);
+	expect_robin_order(table);
+	for (int round = 0; round < 10; round++)
+	{
+		key = "key" + std::to_string(round * 100 + 95);
+		ASSERT_EQ(hash_map_get(table, key.c_str(), &value), OK);
+		EXPECT_EQ(value, 95);
+	}
+}
+
+// odstranene zaznamy
+TEST_F(HashMapTest, put_after_pop_collision)
+{
+	int value;
+	ASSERT_EQ(hash_map_set_hash_function(table, hash_map_additive_hash), OK);
+	ASSERT_EQ(hash_map_put(table, "ab", 1), OK);
+	ASSERT_EQ(hash_map_put(table, "ba", 2), OK);
+	ASSERT_EQ(hash_map_pop(table, "ab", &value), OK);
+	EXPECT_EQ(table->deleted, 1);
+	// misto po "ab" je pred "ba", klic se presto nesmi vlozit podruhe
+	EXPECT_EQ(hash_map_put(table, "ba", 3), KEY_ALREADY_EXISTS);
+	EXPECT_EQ(hash_map_size(table), 1);
+	ASSERT_EQ(hash_map_put(table, "ab", 4), OK);
+	EXPECT_EQ(table->deleted, 0);
+	ASSERT_EQ(hash_map_get(table, "ba", &value), OK);
+	EXPECT_EQ(value, 3);
+}
+
+TEST_F(HashMapTest, churn_reclaims_tombstones)
+{
+	int value;
+	std::string key;
+	for (int i = 0; i < 4; i++)
+	{
+		key = "key" + std::to_string(i);
+		ASSERT_EQ(hash_map_put(table, key.c_str(), i), OK);
+	}
+	// stale 4 zaznamy, index se nesmi zvetsovat ani zaplnit dummy objekty
+	for (int i = 4; i < 10000; i++)
+	{
+		key = "key" + std::to_string(i - 4);
+		ASSERT_EQ(hash_map_remove(table, key.c_str()), OK);
+		key = "key" + std::to_string(i);
+		ASSERT_EQ(hash_map_put(table, key.c_str(), i), OK);
+		ASSERT_LT(table->used + table->deleted, table->allocated);
+	}
+	EXPECT_LE(hash_map_capacity(table), 2 * HASH_MAP_INIT_SIZE);
+	EXPECT_EQ(hash_map_size(table), 4);
+	EXPECT_EQ(hash_map_get(table, "key1234", &value), KEY_ERROR);
+	ASSERT_EQ(hash_map_get(table, "key9999", &value), OK);
+	EXPECT_EQ(value, 9999);
+}
+
+TEST_F(HashMapTest, pop_shrinks_index)
+{
+	int value;
+	std::string key;
+	for (int i = 0; i < 1000; i++)
+	{
+		key = "key" + std::to_string(i);
+		ASSERT_EQ(hash_map_put(table, key.c_str(), i), OK);
+	}
+	size_t allocated = hash_map_capacity(table);
+	for (int i = 0; i < 990; i++)
+	{
+		key = "key" + std::to_string(i);
+		ASSERT_EQ(hash_map_remove(table, key.c_str()), OK);
+	}
+	EXPECT_LT(hash_map_capacity(table), allocated / 8);
+	EXPECT_GE(hash_map_capacity(table), hash_map_size(table));
+	EXPECT_EQ(table->first->value, 990);
+	for (int i = 990; i < 1000; i++)
+	{
+		key = "key" + std::to_string(i);
+		ASSERT_EQ(hash_map_get(table, key.c_str(), &value), OK);
+		EXPECT_EQ(value, i);
+	}
+}
+
+// kompaktni rozlozeni
+TEST_F(HashMapTest, compact_layout_put_get_pop)
+{
+	int value;
+	std::string key;
+	ASSERT_EQ(hash_map_set_layout(table, HASH_MAP_LAYOUT_COMPACT), OK);
+	EXPECT_EQ(table->index, nullptr);
+	for (int i = 0; i < 150; i++)
+	{
+		key = "key" + std::to_string(i);
+		ASSERT_EQ(hash_map_put(table, key.c_str(), i), OK);
+	}
+	EXPECT_EQ(table->slot_width, 1);
+	EXPECT_EQ(hash_map_put(table, "key7", 70), KEY_ALREADY_EXISTS);
+	for (int i = 0; i < 150; i += 2)
+	{
+		key = "key" + std::to_string(i);
+		ASSERT_EQ(hash_map_pop(table, key.c_str(), &value), OK);
+		EXPECT_EQ(value, i == 7 ? 70 : i);
+	}
+	EXPECT_EQ(hash_map_size(table), 75);
+	for (int i = 0; i < 150; i++)
+	{
+		key = "key" + std::to_string(i);
+		EXPECT_EQ(hash_map_contains(table, key.c_str()), i % 2 == 1);
+	}
+	ASSERT_EQ(hash_map_get(table, "key7", &value), OK);
+	EXPECT_EQ(value, 70);
+}
+
+TEST_F(HashMapTest, compact_layout_order_and_width)
+{
+	std::string key;
+	ASSERT_EQ(hash_map_set_layout(table, HASH_MAP_LAYOUT_COMPACT), OK);
+	for (int i = 0; i < 1000; i++)
+	{
+		key = "key" + std::to_string(i);
+		ASSERT_EQ(hash_map_put(table, key.c_str(), i), OK);
+	}
+	// vice nez 256 zaznamu se do 8bitoveho indexu nevejde
+	EXPECT_EQ(table->slot_width, 2);
+	for (int i = 0; i < 1000; i += 3)
+	{
+		key = "key" + std::to_string(i);
+		ASSERT_EQ(hash_map_remove(table, key.c_str()), OK);
+	}
+	ASSERT_EQ(hash_map_put(table, "key0", 1000), OK);
+
+	// seznam i pole zaznamu zachovavaji poradi vlozeni
+	std::vector<int> expected;
+	for (int i = 0; i < 1000; i++)
+	{
+		if (i % 3 != 0)
+		{
+			expected.push_back(i);
+		}
+	}
+	expected.push_back(1000);
+	std::vector<int> values;
+	hash_map_item_t* prev = NULL;
+	for (hash_map_item_t* item = table->first; item != NULL; item = item->next)
+	{
+		values.push_back(item->value);
+		EXPECT_EQ(item->prev, prev);
+		EXPECT_LT(prev, item);
+		prev = item;
+	}
+	EXPECT_EQ(values, expected);
+	EXPECT_EQ(table->last, prev);
+}
+
+TEST_F(HashMapTest, compact_layout_churn)
+{
+	int value;
+	std::string key;
+	ASSERT_EQ(hash_map_set_layout(table, HASH_MAP_LAYOUT_COMPACT), OK);
+	for (int i = 0; i < 10000; i++)
+	{
+		key = "key" + std::to_string(i);
+		ASSERT_EQ(hash_map_put(table, key.c_str(), i), OK);
+		if (i >= 4)
+		{
+			key = "key" + std::to_string(i - 4);
+			ASSERT_EQ(hash_map_remove(table, key.c_str()), OK);
+		}
+		ASSERT_LE(table->entries_used, table->entries_allocated);
+	}
+	EXPECT_EQ(hash_map_size(table), 4);
+	EXPECT_EQ(table->first->value, 9996);
+	ASSERT_EQ(hash_map_get(table, "key9999", &value), OK);
+	EXPECT_EQ(value, 9999);
+	hash_map_clear(table);
+	EXPECT_EQ(table->entries_used, 0);
+	ASSERT_EQ(hash_map_put(table, "key", 1), OK);
+	EXPECT_EQ(table->first, table->entries);
+}
+
+TEST_F(HashMapTest, set_layout_not_empty)
+{
+	ASSERT_EQ(hash_map_put(table, "key", 1), OK);
+	EXPECT_EQ(hash_map_set_layout(table, HASH_MAP_LAYOUT_COMPACT), VALUE_ERROR);
+	EXPECT_EQ(table->layout, HASH_MAP_LAYOUT_LINKED);
+}
+
+// kratke klice v zaznamu
+TEST_F(HashMapTest, inline_key_boundary)
+{
+	int value;
+	std::string shortKey(HASH_MAP_INLINE_KEY_SIZE - 1, 'a');
+	std::string longKey(HASH_MAP_INLINE_KEY_SIZE, 'b');
+	ASSERT_EQ(hash_map_put(table, shortKey.c_str(), 1), OK);
+	ASSERT_EQ(hash_map_put(table, longKey.c_str(), 2), OK);
+	EXPECT_EQ(table->first->key, table->first->inline_key);
+	EXPECT_NE(table->last->key, table->last->inline_key);
+	EXPECT_STREQ(table->first->key, shortKey.c_str());
+	EXPECT_STREQ(table->last->key, longKey.c_str());
+	ASSERT_EQ(hash_map_pop(table, shortKey.c_str(), &value), OK);
+	EXPECT_EQ(value, 1);
+	ASSERT_EQ(hash_map_pop(table, longKey.c_str(), &value), OK);
+	EXPECT_EQ(value, 2);
+}
+
+TEST_F(HashMapTest, inline_key_moves_with_entry)
+{
+	int value;
+	std::string key;
+	ASSERT_EQ(hash_map_set_layout(table, HASH_MAP_LAYOUT_COMPACT), OK);
+	for (int i = 0; i < 100; i++)
+	{
+		key = (i % 2 ? "key" : std::string(30, 'x')) + std::to_string(i);
+		ASSERT_EQ(hash_map_put(table, key.c_str(), i), OK);
+	}
+	// zvetseni indexu presune zaznamy do noveho pole
+	for (hash_map_item_t* item = table->first; item != NULL; item = item->next)
+	{
+		EXPECT_EQ(item->key == item->inline_key, item->value % 2 == 1);
+	}
+	for (int i = 0; i < 100; i++)
+	{
+		key = (i % 2 ? "key" : std::string(30, 'x')) + std::to_string(i);
+		ASSERT_EQ(hash_map_get(table, key.c_str(), &value), OK);
+		EXPECT_EQ(value, i);
+	}
+}
+
+// alokator zaznamu a klicu
+TEST_F(HashMapTest, slab_reuses_items)
+{
+	ASSERT_EQ(hash_map_put(table, "first", 1), OK);
+	ASSERT_EQ(hash_map_put(table, "second", 2), OK);
+	hash_map_item_t* second = table->last;
+	ASSERT_EQ(hash_map_remove(table, "second"), OK);
+	EXPECT_EQ(table->free_items, second);
+	ASSERT_EQ(hash_map_put(table, "third", 3), OK);
+	EXPECT_EQ(table->last, second);
+	EXPECT_EQ(table->free_items, nullptr);
+	EXPECT_EQ(table->slab_capacity, HASH_MAP_INIT_SIZE);
+}
+
+TEST_F(HashMapTest, clear_releases_blocks)
+{
+	int value;
+	std::string key;
+	for (int i = 0; i < 5000; i++)
+	{
+		key = std::string(40, 'k') + std::to_string(i);
+		ASSERT_EQ(hash_map_put(table, key.c_str(), i), OK);
+	}
+	EXPECT_GE(table->slab_capacity, 5000);
+	EXPECT_NE(table->arena, nullptr);
+	hash_map_clear(table);
+	EXPECT_EQ(table->slabs, nullptr);
+	EXPECT_EQ(table->arena, nullptr);
+	EXPECT_EQ(table->first, nullptr);
+	ASSERT_EQ(hash_map_put(table, key.c_str(), 1), OK);
+	ASSERT_EQ(hash_map_get(table, key.c_str(), &value), OK);
+	EXPECT_EQ(value, 1);
+}
+
+TEST_F(HashMapTest, arena_compacts_under_churn)
+{
+	int value;
+	std::string key;
+	for (int i = 0; i < 100000; i++)
+	{
+		key = std::string(40, 'k') + std::to_string(i);
+		ASSERT_EQ(hash_map_put(table, key.c_str(), i), OK);
+		if (i >= 100)
+		{
+			key = std::string(40, 'k') + std::to_string(i - 100);
+			ASSERT_EQ(hash_map_remove(table, key.c_str()), OK);
+		}
+	}
+	// 100 zivych klicu po 46 bajtech, arena nesmi rust s poctem operaci
+	EXPECT_LE(table->arena_size, 4 * HASH_MAP_ARENA_BLOCK_SIZE);
+	EXPECT_LE(table->slab_capacity, 256);
+	for (int i = 99900; i < 100000; i++)
+	{
+		key = std::string(40, 'k') + std::to_string(i);
+		ASSERT_EQ(hash_map_get(table, key.c_str(), &value), OK);
+		EXPECT_EQ(value, i);
+	}
+}
+
+// klice zadane delkou
+TEST_F(HashMapTest, key_slices)
+{
+	int value;
+	// klice nejsou ukonceny nulou, jde o vyrezy jednoho bufferu
+	const char buffer[] = "alphabetagamma";
+	ASSERT_EQ(hash_map_put_n(table, buffer, 5, 1), OK);
+	ASSERT_EQ(hash_map_put_n(table, buffer + 5, 4, 2), OK);
+	ASSERT_EQ(hash_map_put_n(table, buffer + 9, 5, 3), OK);
+	EXPECT_EQ(hash_map_put_n(table, "alphaX", 5, 4), KEY_ALREADY_EXISTS);
+	EXPECT_EQ(hash_map_size(table), 3);
+
+	EXPECT_STREQ(table->first->key, "alpha");
+	EXPECT_EQ(table->first->length, 5);
+	ASSERT_EQ(hash_map_get(table, "beta", &value), OK);
+	EXPECT_EQ(value, 2);
+	ASSERT_EQ(hash_map_get_n(table, "gammaray", 5, &value), OK);
+	EXPECT_EQ(value, 3);
+	EXPECT_EQ(hash_map_contains_n(table, buffer, 4), false);
+	EXPECT_EQ(hash_map_contains_n(table, buffer, 5), true);
+	ASSERT_EQ(hash_map_pop_n(table, buffer, 5, &value), OK);
+	EXPECT_EQ(value, 4);
+	EXPECT_EQ(hash_map_remove_n(table, buffer, 5), KEY_ERROR);
+	EXPECT_EQ(hash_map_remove_n(table, "beta", 4), OK);
+}
+
+TEST_F(HashMapTest, key_with_nul_bytes)
+{
+	int value;
+	const char first[] = {'a', '\0', 'b'};
+	const char second[] = {'a', '\0', 'c'};
+	std::string longKey(40, 'x');
+	longKey[10] = '\0';
+	ASSERT_EQ(hash_map_put_n(table, first, 3, 1), OK);
+	ASSERT_EQ(hash_map_put_n(table, second, 3, 2), OK);
+	ASSERT_EQ(hash_map_put_n(table, "a", 1, 3), OK);
+	ASSERT_EQ(hash_map_put_n(table, longKey.data(), longKey.size(), 4), OK);
+	EXPECT_EQ(hash_map_size(table), 4);
+	ASSERT_EQ(hash_map_get_n(table, second, 3, &value), OK);
+	EXPECT_EQ(value, 2);
+	ASSERT_EQ(hash_map_get(table, "a", &value), OK);
+	EXPECT_EQ(value, 3);
+	ASSERT_EQ(hash_map_get_n(table, longKey.data(), longKey.size(), &value), OK);
+	EXPECT_EQ(value, 4);
+	EXPECT_EQ(hash_map_contains(table, "xxxxxxxxxx"), false);
+}
+
+// upravy hodnot jednim hledanim
+TEST_F(HashMapTest, get_or_insert)
+{
+	int* value;
+	int stored;
+	ASSERT_EQ(hash_map_get_or_insert(table, "key", &value), OK);
+	EXPECT_EQ(*value, 0);
+	*value = 5;
+	ASSERT_EQ(hash_map_get_or_insert(table, "key", &value), KEY_ALREADY_EXISTS);
+	EXPECT_EQ(*value, 5);
+	ASSERT_EQ(hash_map_get(table, "key", &stored), OK);
+	EXPECT_EQ(stored, 5);
+	ASSERT_EQ(hash_map_get_or_insert_n(table, "key2", 3, &value), KEY_ALREADY_EXISTS);
+	EXPECT_EQ(hash_map_size(table), 1);
+}
+
+TEST_F(HashMapTest, add_counts)
+{
+	int value;
+	std::string key;
+	// pocitani vyskytu, vlozeni probiha i pres zvetsovani indexu
+	for (int i = 0; i < 3000; i++)
+	{
+		key = "word" + std::to_string(i % 1000);
+		ASSERT_NE(hash_map_add(table, key.c_str(), 1), MEMORY_ERROR);
+	}
+	EXPECT_EQ(hash_map_size(table), 1000);
+	for (int i = 0; i < 1000; i++)
+	{
+		key = "word" + std::to_string(i);
+		ASSERT_EQ(hash_map_get(table, key.c_str(), &value), OK);
+		EXPECT_EQ(value, 3);
+	}
+	EXPECT_EQ(hash_map_add(table, "word0", -3), KEY_ALREADY_EXISTS);
+	EXPECT_EQ(hash_map_add_n(table, "word0!", 5, 7), KEY_ALREADY_EXISTS);
+	ASSERT_EQ(hash_map_get(table, "word0", &value), OK);
+	EXPECT_EQ(value, 7);
+	EXPECT_EQ(hash_map_add(table, "new", -2), OK);
+	ASSERT_EQ(hash_map_get(table, "new", &value), OK);
+	EXPECT_EQ(value, -2);
+}
+
+TEST_F(HashMapTest, put_many_get_many)
+{
+	// vice klicu nez jedna davka, vkladani pres zvetsovani indexu
+	std::vector<std::string> names;
+	for (int i = 0; i < 100; i++)
+	{
+		names.push_back("key" + std::to_string(i % 70));
+	}
+	std::vector<const char*> keys;
+	std::vector<int> values;
+	for (int i = 0; i < 100; i++)
+	{
+		keys.push_back(names[i].c_str());
+		values.push_back(i);
+	}
+	std::vector<hash_map_state_code_t> states(100);
+	ASSERT_EQ(hash_map_put_many(table, 100, keys.data(), values.data(), states.data()), OK);
+	EXPECT_EQ(hash_map_size(table), 70);
+	EXPECT_EQ(states[0], OK);
+	EXPECT_EQ(states[70], KEY_ALREADY_EXISTS);
+
+	// posledni vyskyt klice prepise hodnotu
+	int value;
+	ASSERT_EQ(hash_map_get(table, "key5", &value), OK);
+	EXPECT_EQ(value, 75);
+	ASSERT_EQ(hash_map_get(table, "key69", &value), OK);
+	EXPECT_EQ(value, 69);
+
+	const char* lookup[] = {"key0", "missing", "key69", "key70"};
+	int found[4] = {-1, -1, -1, -1};
+	hash_map_state_code_t lookup_states[4];
+	EXPECT_EQ(hash_map_get_many(table, 4, lookup, found, lookup_states), 2);
+	EXPECT_EQ(found[0], 70);
+	EXPECT_EQ(found[1], -1);
+	EXPECT_EQ(found[2], 69);
+	EXPECT_EQ(found[3], -1);
+	EXPECT_EQ(lookup_states[0], OK);
+	EXPECT_EQ(lookup_states[1], KEY_ERROR);
+	EXPECT_EQ(lookup_states[3], KEY_ERROR);
+
+	// bez pole stavu
+	EXPECT_EQ(hash_map_get_many(table, 100, keys.data(), values.data(), NULL), 100);
+	EXPECT_EQ(hash_map_get_many(table, 0, keys.data(), values.data(), NULL), 0);
+}
+
+TEST_F(HashMapTest, get_many_compact_groups)
+{
+	hash_map_set_engine(table, HASH_MAP_ENGINE_GROUPS);
+	hash_map_set_layout(table, HASH_MAP_LAYOUT_COMPACT);
+	std::vector<std::string> names;
+	std::vector<const char*> keys;
+	std::vector<int> values;
+	for (int i = 0; i < 500; i++)
+	{
+		names.push_back("item" + std::to_string(i));
+	}
+	for (int i = 0; i < 500; i++)
+	{
+		keys.push_back(names[i].c_str());
+		values.push_back(i * 2);
+	}
+	ASSERT_EQ(hash_map_put_many(table, 500, keys.data(), values.data(), NULL), OK);
+	ASSERT_EQ(hash_map_size(table), 500);
+	std::vector<int> found(500, -1);
+	EXPECT_EQ(hash_map_get_many(table, 500, keys.data(), found.data(), NULL), 500);
+	EXPECT_EQ(found, values);
+}
+
+TEST_F(HashMapTest, incremental_resize)
+{
+	hash_map_set_resize_policy(table, HASH_MAP_RESIZE_INCREMENTAL);
+	int value;
+	std::string key;
+	bool seen_migration = false;
+	for (int i = 0; i < 2000; i++)
+	{
+		key = "key" + std::to_string(i);
+		ASSERT_EQ(hash_map_put(table, key.c_str(), i), OK);
+		if (table->old_ctrl != NULL)
+		{
+			seen_migration = true;
+			// prave pridany i nejstarsi zaznam jsou dostupne
+			ASSERT_EQ(hash_map_get(table, key.c_str(), &value), OK);
+			EXPECT_EQ(value, i);
+			ASSERT_TRUE(hash_map_contains(table, "key0"));
+		}
+	}
+	EXPECT_TRUE(seen_migration);
+	EXPECT_EQ(hash_map_size(table), 2000);
+
+	// zvetseni probehne po operacich, ktere zaznamy postupne presouvaji
+	while (table->old_ctrl != NULL)
+	{
+		hash_map_contains(table, "missing");
+	}
+	for (int i = 0; i < 2000; i++)
+	{
+		key = "key" + std::to_string(i);
+		ASSERT_EQ(hash_map_get(table, key.c_str(), &value), OK);
+		EXPECT_EQ(value, i);
+	}
+	size_t count = 0;
+	for (hash_map_item_t* item = table->first; item != NULL; item = item->next)
+	{
+		EXPECT_EQ(item->value, (int)count++);
+	}
+	EXPECT_EQ(count, 2000);
+}
+
+TEST_F(HashMapTest, incremental_resize_mutations)
+{
+	hash_map_set_resize_policy(table, HASH_MAP_RESIZE_INCREMENTAL);
+	hash_map_reserve(table, 64);
+	std::string key;
+	for (int i = 0; i < 39; i++)
+	{
+		key = "key" + std::to_string(i);
+		ASSERT_EQ(hash_map_put(table, key.c_str(), i), OK);
+	}
+	// prekroceni meze zaplneni zalozi novy index, stary zustane
+	ASSERT_EQ(hash_map_put(table, "key39", 39), OK);
+	ASSERT_NE(table->old_ctrl, nullptr);
+	EXPECT_EQ(hash_map_capacity(table), 128);
+	EXPECT_EQ(table->old_used, 39);
+
+	// zaznamy ve starem indexu lze prepsat i odstranit
+	int value;
+	EXPECT_EQ(hash_map_put(table, "key30", -1), KEY_ALREADY_EXISTS);
+	ASSERT_EQ(hash_map_get(table, "key30", &value), OK);
+	EXPECT_EQ(value, -1);
+	ASSERT_EQ(hash_map_pop(table, "key37", &value), OK);
+	EXPECT_EQ(value, 37);
+	EXPECT_GT(table->old_used, 0);
+	EXPECT_FALSE(hash_map_contains(table, "key37"));
+	EXPECT_EQ(hash_map_remove(table, "key37"), KEY_ERROR);
+	EXPECT_EQ(hash_map_size(table), 39);
+
+	// odstraneni vsech zaznamu behem presunu
+	for (int i = 0; i < 40; i++)
+	{
+		key = "key" + std::to_string(i);
+		hash_map_remove(table, key.c_str());
+	}
+	EXPECT_EQ(hash_map_size(table), 0);
+	EXPECT_EQ(table->old_ctrl, nullptr);
+	EXPECT_EQ(table->first, nullptr);
+	ASSERT_EQ(hash_map_put(table, "again", 1), OK);
+	ASSERT_EQ(hash_map_get(table, "again", &value), OK);
+}
+
+TEST_F(HashMapTest, shared_reads)
+{
+	hash_map_set_layout(table, HASH_MAP_LAYOUT_COMPACT);
+	EXPECT_EQ(hash_map_set_read_policy(table, HASH_MAP_READ_SHARED), VALUE_ERROR);
+	hash_map_set_layout(table, HASH_MAP_LAYOUT_LINKED);
+	ASSERT_EQ(hash_map_set_read_policy(table, HASH_MAP_READ_SHARED), OK);
+	ASSERT_NE(table->view, nullptr);
+	EXPECT_EQ(hash_map_set_layout(table, HASH_MAP_LAYOUT_COMPACT), VALUE_ERROR);
+
+	std::string key;
+	for (int i = 0; i < 1000; i++)
+	{
+		key = "key" + std::to_string(i);
+		ASSERT_EQ(hash_map_put(table, key.c_str(), i), OK);
+	}
+	// pohled ctenaru ukazuje na aktualni index
+	EXPECT_EQ(table->view->index, table->index);
+	EXPECT_EQ(table->view->ctrl, table->ctrl);
+	int value;
+	for (int i = 0; i < 1000; i++)
+	{
+		key = "key" + std::to_string(i);
+		ASSERT_EQ(hash_map_get(table, key.c_str(), &value), OK);
+		EXPECT_EQ(value, i);
+	}
+	EXPECT_FALSE(hash_map_contains(table, "missing"));
+
+	// odstranene zaznamy se vyradi a bez ctenaru hned uvolni
+	for (int i = 0; i < 1000; i += 2)
+	{
+		key = "key" + std::to_string(i);
+		ASSERT_EQ(hash_map_pop(table, key.c_str(), &value), OK);
+		EXPECT_FALSE(hash_map_contains(table, key.c_str()));
+	}
+	EXPECT_LT(table->retired_count, (size_t)HASH_MAP_RECLAIM_THRESHOLD);
+	EXPECT_EQ(hash_map_size(table), 500);
+
+	// vymazani zverejni novy prazdny index, stary ctenari dal ctou
+	uint8_t* old_ctrl = table->ctrl;
+	hash_map_t* old_view = table->view;
+	hash_map_clear(table);
+	EXPECT_EQ(hash_map_size(table), 0);
+	EXPECT_NE(table->ctrl, old_ctrl);
+	EXPECT_NE(table->view, old_view);
+	EXPECT_EQ(table->view->ctrl, table->ctrl);
+	EXPECT_FALSE(hash_map_contains(table, "key999"));
+	for (int i = 0; i < 1000; i++)
+	{
+		key = "key" + std::to_string(i);
+		ASSERT_EQ(hash_map_put(table, key.c_str(), i), OK);
+	}
+
+	ASSERT_EQ(hash_map_set_read_policy(table, HASH_MAP_READ_EXCLUSIVE), OK);
+	EXPECT_EQ(table->retired_count, 0);
+	EXPECT_EQ(table->retired, nullptr);
+	EXPECT_EQ(table->view, nullptr);
+	ASSERT_EQ(hash_map_get(table, "key999", &value), OK);
+	EXPECT_EQ(value, 999);
+}
+
+// hodnoty libovolneho typu
+struct point_t
+{
+	double x;
+	double y;
+	const char* name;
+};
+
+TEST_F(HashMapTest, value_size_struct)
+{
+	ASSERT_EQ(hash_map_set_value_size(table, sizeof(point_t)), OK);
+	EXPECT_EQ(table->item_size % HASH_MAP_VALUE_ALIGN, 0);
+	std::string key;
+	for (int i = 0; i < 1000; i++)
+	{
+		key = "point" + std::to_string(i);
+		point_t point = {(double)i, -(double)i, "p"};
+		ASSERT_EQ(hash_map_put_value(table, key.c_str(), &point), OK);
+	}
+	// hodnota lezi hned za zaznamem, ukazatel preziva zvetseni indexu
+	void* stored;
+	ASSERT_EQ(hash_map_get_value_ptr(table, "point7", &stored), OK);
+	point_t* seven = (point_t*)stored;
+	EXPECT_EQ(stored, (void*)(table->first->next->next->next->next->next->next->next + 1));
+	EXPECT_EQ((uintptr_t)stored % HASH_MAP_VALUE_ALIGN, 0);
+	for (int i = 1000; i < 5000; i++)
+	{
+		key = "point" + std::to_string(i);
+		point_t point = {(double)i, -(double)i, "q"};
+		ASSERT_EQ(hash_map_put_value(table, key.c_str(), &point), OK);
+	}
+	EXPECT_EQ(seven->x, 7.0);
+	seven->name = "seven";
+
+	point_t point;
+	for (int i = 0; i < 5000; i++)
+	{
+		key = "point" + std::to_string(i);
+		ASSERT_EQ(hash_map_get_value(table, key.c_str(), &point), OK);
+		EXPECT_EQ(point.x, (double)i);
+		EXPECT_EQ(point.y, -(double)i);
+	}
+	ASSERT_EQ(hash_map_get_value(table, "point7", &point), OK);
+	EXPECT_STREQ(point.name, "seven");
+	EXPECT_EQ(hash_map_get_value(table, "point5000", &point), KEY_ERROR);
+	EXPECT_EQ(hash_map_get_value_ptr(table, "point5000", &stored), KEY_ERROR);
+
+	// prepsani, odstraneni a vynulovani pri vlozeni pres celociselne rozhrani
+	point_t moved = {0.5, 0.5, "moved"};
+	EXPECT_EQ(hash_map_put_value(table, "point1", &moved), KEY_ALREADY_EXISTS);
+	ASSERT_EQ(hash_map_pop_value(table, "point1", &point), OK);
+	EXPECT_STREQ(point.name, "moved");
+	EXPECT_FALSE(hash_map_contains(table, "point1"));
+	EXPECT_EQ(hash_map_pop_value(table, "point1", NULL), KEY_ERROR);
+	ASSERT_EQ(hash_map_put(table, "point1", 1), OK);
+	ASSERT_EQ(hash_map_get_value(table, "point1", &point), OK);
+	EXPECT_EQ(point.x, 0.0);
+	EXPECT_EQ(point.name, nullptr);
+
+	// velikost ani rozlozeni nelze menit u neprazdne tabulky
+	EXPECT_EQ(hash_map_set_value_size(table, 8), VALUE_ERROR);
+	hash_map_clear(table);
+	EXPECT_EQ(hash_map_set_layout(table, HASH_MAP_LAYOUT_COMPACT), VALUE_ERROR);
+	ASSERT_EQ(hash_map_set_value_size(table, 0), OK);
+	ASSERT_EQ(hash_map_set_layout(table, HASH_MAP_LAYOUT_COMPACT), OK);
+	EXPECT_EQ(hash_map_set_value_size(table, 8), VALUE_ERROR);
+}
+
+TEST_F(HashMapTest, value_size_shared_reads)
+{
+	char block[200];
+	ASSERT_EQ(hash_map_set_value_size(table, sizeof(block)), OK);
+	ASSERT_EQ(hash_map_set_read_policy(table, HASH_MAP_READ_SHARED), OK);
+	for (int i = 0; i < 100; i++)
+	{
+		memset(block, i, sizeof(block));
+		ASSERT_EQ(hash_map_put_value_n(table, (const char*)&i, sizeof(i), block), OK);
+	}
+	for (int i = 0; i < 100; i++)
+	{
+		ASSERT_EQ(hash_map_get_value_n(table, (const char*)&i, sizeof(i), block), OK);
+		EXPECT_EQ(block[0], (char)i);
+		EXPECT_EQ(block[sizeof(block) - 1], (char)i);
+	}
+	// zaznam muze zapisovatel kdykoliv uvolnit, ukazatel se nevraci
+	void* stored;
+	int key = 5;
+	EXPECT_EQ(hash_map_get_value_ptr_n(table, (const char*)&key, sizeof(key), &stored), VALUE_ERROR);
+	ASSERT_EQ(hash_map_pop_value_n(table, (const char*)&key, sizeof(key), block), OK);
+	EXPECT_EQ(block[100], 5);
+	EXPECT_EQ(hash_map_size(table), 99);
+}
+
+TEST_F(HashMapTest, value_size_shared_writer)
+{
+	const int KEYS = 64;
+	char block[4096];
+	ASSERT_EQ(hash_map_set_value_size(table, sizeof(block)), OK);
+	ASSERT_EQ(hash_map_set_read_policy(table, HASH_MAP_READ_SHARED), OK);
+	hash_map_t* map = table;
+	std::atomic<bool> done(false);
+	std::vector<int> errors(2, 0);
+	std::vector<std::thread> readers;
+	for (int t = 0; t < 2; t++)
+	{
+		// ctenar nikdy nevidi vynulovanou ani napul prepsanou hodnotu
+		readers.emplace_back([map, t, &done, &errors]() {
+			char value[4096];
+			while (!done.load())
+			{
+				for (int i = 0; i < KEYS; i++)
+				{
+					std::string key = "key" + std::to_string(i) + std::string(i % 2 * 40, 'x');
+					if (hash_map_get_value(map, key.c_str(), value) != OK)
+					{
+						continue;
+					}
+					if (value[0] == 0 || 
+					    std::count(value, value + sizeof(value), value[0]) != (int)sizeof(value))
+					{
+						errors[t]++;
+					}
+				}
+			}
+		});
+	}
+	for (int round = 1; round < 400; round++)
+	{
+		memset(block, round % 127 + 1, sizeof(block));
+		for (int i = 0; i < KEYS; i++)
+		{
+			std::string key = "key" + std::to_string(i) + std::string(i % 2 * 40, 'x');
+			if (round % 50 == 0)
+			{
+				hash_map_pop_value(map, key.c_str(), NULL);
+			}
+			hash_map_put_value(map, key.c_str(), block);
+		}
+	}
+	done = true;
+	for (auto& thread : readers)
+	{
+		thread.join();
+	}
+	EXPECT_EQ(errors[0], 0);
+	EXPECT_EQ(errors[1], 0);
+	EXPECT_EQ(hash_map_size(table), KEYS);
+	ASSERT_EQ(hash_map_get_value(table, ("key1" + std::string(40, 'x')).c_str(), block), OK);
+	EXPECT_EQ(block[0], 399 % 127 + 1);
+}
+
+TEST_F(HashMapTest, stats_probe_lengths)
+{
+	// konstantni has: i-ty zaznam se najde az na i-tem miste za vychozim
+	ASSERT_EQ(hash_map_set_hash_function(table, constant_hash), OK);
+	std::string key;
+	for (int i = 0; i < 5; i++)
+	{
+		key = "same" + std::to_string(i);
+		ASSERT_EQ(hash_map_put(table, key.c_str(), i), OK);
+	}
+	hash_map_stats_t stats = hash_map_stats(table);
+	EXPECT_EQ(stats.size, 5);
+	EXPECT_EQ(stats.capacity, table->allocated);
+	EXPECT_DOUBLE_EQ(stats.load_factor, 5.0 / (double)table->allocated);
+	for (int i = 0; i < 5; i++)
+	{
+		EXPECT_EQ(stats.probe_histogram[i], 1);
+	}
+	EXPECT_EQ(stats.hit_probe_max, 4);
+	EXPECT_DOUBLE_EQ(stats.hit_probe_avg, 2.0);
+	EXPECT_GT(stats.bytes, table->allocated * (sizeof(hash_map_item_t*) + 1));
+
+	// odstraneni zanecha dummy objekt, delka hledani ostatnich se nemeni
+	ASSERT_EQ(hash_map_remove(table, "same0"), OK);
+	stats = hash_map_stats(table);
+	EXPECT_EQ(stats.tombstones, 1);
+	EXPECT_DOUBLE_EQ(stats.occupied_factor, 5.0 / (double)table->allocated);
+	EXPECT_EQ(stats.probe_histogram[0], 0);
+	EXPECT_EQ(stats.hit_probe_max, 4);
+}
+
+TEST_F(HashMapTest, stats_engines)
+{
+	const hash_map_engine_t engines[] = {HASH_MAP_ENGINE_PROBING, HASH_MAP_ENGINE_GROUPS, 
+	                                     HASH_MAP_ENGINE_ROBIN_HOOD};
+	for (hash_map_engine_t engine : engines)
+	{
+		hash_map_dtor(table);
+		table = hash_map_ctor();
+		ASSERT_EQ(hash_map_set_engine(table, engine), OK);
+		hash_map_stats_t stats = hash_map_stats(table);
+		EXPECT_EQ(stats.size, 0);
+		EXPECT_EQ(stats.hit_probe_max, 0);
+		EXPECT_EQ(stats.miss_probe_max, 0);
+
+		std::string key;
+		for (int i = 0; i < 3000; i++)
+		{
+			key = "stats" + std::to_string(i);
+			ASSERT_EQ(hash_map_put(table, key.c_str(), i), OK);
+		}
+		stats = hash_map_stats(table);
+		size_t counted = 0;
+		for (size_t count : stats.probe_histogram)
+		{
+			counted += count;
+		}
+		EXPECT_EQ(counted, 3000);
+		EXPECT_GT(stats.probe_histogram[0], 0);
+		EXPECT_LE(stats.hit_probe_avg, (double)stats.hit_probe_max);
+		EXPECT_LE(stats.miss_probe_avg, (double)stats.miss_probe_max);
+		// neuspesne hledani konci az na prazdnem miste
+		EXPECT_GE(stats.miss_probe_avg, stats.hit_probe_avg / 2);
+		EXPECT_EQ(stats.tombstones, 0);
+		EXPECT_GT(stats.bytes, 3000 * sizeof(hash_map_item_t));
+#ifdef HASH_MAP_STATS_RESIZE
+		EXPECT_GT(stats.resizes, 0);
+		EXPECT_GT(stats.resize_ns, 0);
+#else
+		EXPECT_EQ(stats.resizes, 0);
+		EXPECT_EQ(stats.resize_ns, 0);
+#endif
+	}
+}
+
+TEST_F(HashMapTest, stats_incremental_resize)
+{
+	hash_map_set_resize_policy(table, HASH_MAP_RESIZE_INCREMENTAL);
+	std::string key;
+	int i = 0;
+	for (; table->old_ctrl == NULL || table->old_used < 100; i++)
+	{
+		key = "key" + std::to_string(i);
+		ASSERT_EQ(hash_map_put(table, key.c_str(), i), OK);
+	}
+	// statistiky rozpracovane zvetseni nedokonci
+	size_t old_used = table->old_used;
+	size_t migrate = table->migrate;
+	hash_map_stats_t stats = hash_map_stats(table);
+	ASSERT_NE(table->old_ctrl, nullptr);
+	EXPECT_EQ(table->old_used, old_used);
+	EXPECT_EQ(table->migrate, migrate);
+
+	// zaznamy ve starem indexu se hledaji nejdriv v novem
+	size_t counted = 0;
+	for (size_t count : stats.probe_histogram)
+	{
+		counted += count;
+	}
+	EXPECT_EQ(counted, (size_t)i);
+	EXPECT_GE(stats.hit_probe_max, 1);
+	EXPECT_GE(stats.miss_probe_avg, 1.0);
+	EXPECT_GT(stats.bytes, (table->allocated + table->old_allocated) * sizeof(hash_map_item_t*));
+}
+
+TEST_F(HashMapTest, stats_retired_memory)
+{
+	ASSERT_EQ(hash_map_set_read_policy(table, HASH_MAP_READ_SHARED), OK);
+	std::string key;
+	for (int i = 0; i < 1000; i++)
+	{
+		key = "key" + std::to_string(i);
+		ASSERT_EQ(hash_map_put(table, key.c_str(), i), OK);
+	}
+	// nahrazene indexy cekaji na uvolneni a zapocitaji se
+	ASSERT_GT(table->retired_count, 0);
+	size_t retired = sizeof(hash_map_t);
+	for (hash_map_retired_t* item = table->retired; item != NULL; item = item->next)
+	{
+		retired += sizeof(hash_map_retired_t) + item->size;
+	}
+	size_t shared = hash_map_stats(table).bytes;
+	ASSERT_EQ(hash_map_set_read_policy(table, HASH_MAP_READ_EXCLUSIVE), OK);
+	EXPECT_EQ(shared - hash_map_stats(table).bytes, retired);
+}
+
+/** Zaznamenava klice zaznamu odstranenych v rezimu cache. */
+static void record_eviction(void* context, const char* key, size_t length, int value, void* data)
+{
+	std::vector<std::string>* evicted = (std::vector<std::string>*)context;
+	evicted->push_back(std::string(key, length) + "=" + std::to_string(value));
+	EXPECT_EQ(data, nullptr);
+}
+
+TEST_F(HashMapTest, cache_lru_order)
+{
+	std::vector<std::string> evicted;
+	ASSERT_EQ(hash_map_set_cache_limit(table, 3), OK);
+	ASSERT_EQ(hash_map_set_evict_function(table, record_eviction, &evicted), OK);
+	ASSERT_EQ(hash_map_put(table, "a", 1), OK);
+	ASSERT_EQ(hash_map_put(table, "b", 2), OK);
+	ASSERT_EQ(hash_map_put(table, "c", 3), OK);
+	EXPECT_TRUE(evicted.empty());
+
+	// nalezeny klic se presune na konec seznamu, contains poradi nemeni
+	int value;
+	ASSERT_EQ(hash_map_get(table, "a", &value), OK);
+	EXPECT_STREQ(table->first->key, "b");
+	EXPECT_STREQ(table->last->key, "a");
+	EXPECT_TRUE(hash_map_contains(table, "b"));
+	EXPECT_EQ(hash_map_get(table, "x", &value), KEY_ERROR);
+	ASSERT_EQ(hash_map_put(table, "d", 4), OK);
+	ASSERT_EQ(evicted.size(), 1);
+	EXPECT_EQ(evicted[0], "b=2");
+	EXPECT_FALSE(hash_map_contains(table, "b"));
+	EXPECT_EQ(hash_map_size(table), 3);
+
+	// prepsani a hash_map_get_or_insert take obnovuji pouziti
+	EXPECT_EQ(hash_map_put(table, "c", 30), KEY_ALREADY_EXISTS);
+	int* stored;
+	EXPECT_EQ(hash_map_get_or_insert(table, "a", &stored), KEY_ALREADY_EXISTS);
+	ASSERT_EQ(hash_map_put(table, "e", 5), OK);
+	EXPECT_EQ(evicted.back(), "d=4");
+	EXPECT_STREQ(table->first->key, "c");
+	EXPECT_EQ(hash_map_get_or_insert(table, "f", &stored), OK);
+	EXPECT_EQ(evicted.back(), "c=30");
+
+	const char* keys[] = {"a", "b", "e"};
+	int values[3];
+	EXPECT_EQ(hash_map_get_many(table, 3, keys, values, NULL), 2);
+	EXPECT_STREQ(table->first->key, "f");
+
+	// odstraneni uzivatelem funkci nevola
+	ASSERT_EQ(hash_map_remove(table, "f"), OK);
+	EXPECT_EQ(evicted.size(), 3);
+	hash_map_cache_stats_t stats = hash_map_cache_stats(table);
+	EXPECT_EQ(stats.hits, 4);
+	EXPECT_EQ(stats.misses, 3);
+	EXPECT_EQ(stats.evictions, 3);
+}
+
+TEST_F(HashMapTest, cache_limit_changes)
+{
+	ASSERT_EQ(hash_map_set_layout(table, HASH_MAP_LAYOUT_COMPACT), OK);
+	EXPECT_EQ(hash_map_set_cache_limit(table, 10), VALUE_ERROR);
+	ASSERT_EQ(hash_map_set_layout(table, HASH_MAP_LAYOUT_LINKED), OK);
+	ASSERT_EQ(hash_map_set_read_policy(table, HASH_MAP_READ_SHARED), OK);
+	EXPECT_EQ(hash_map_set_cache_limit(table, 10), VALUE_ERROR);
+	ASSERT_EQ(hash_map_set_read_policy(table, HASH_MAP_READ_EXCLUSIVE), OK);
+	ASSERT_EQ(hash_map_set_cache_limit(table, 10), OK);
+	EXPECT_EQ(hash_map_set_layout(table, HASH_MAP_LAYOUT_COMPACT), VALUE_ERROR);
+	EXPECT_EQ(hash_map_set_read_policy(table, HASH_MAP_READ_SHARED), VALUE_ERROR);
+
+	std::string key;
+	for (int i = 0; i < 100; i++)
+	{
+		key = "key" + std::to_string(i);
+		ASSERT_EQ(hash_map_put(table, key.c_str(), i), OK);
+	}
+	EXPECT_EQ(hash_map_size(table), 10);
+	EXPECT_STREQ(table->first->key, "key90");
+	EXPECT_EQ(hash_map_cache_stats(table).evictions, 90);
+
+	// snizeni limitu odstrani zaznamy hned, limit 0 rezim vypne
+	ASSERT_EQ(hash_map_set_cache_limit(table, 4), OK);
+	EXPECT_EQ(hash_map_size(table), 4);
+	EXPECT_STREQ(table->first->key, "key96");
+	ASSERT_EQ(hash_map_set_cache_limit(table, 0), OK);
+	int value;
+	ASSERT_EQ(hash_map_get(table, "key96", &value), OK);
+	EXPECT_STREQ(table->first->key, "key96");
+	ASSERT_EQ(hash_map_put(table, "key100", 100), OK);
+	EXPECT_EQ(hash_map_size(table), 5);
+	EXPECT_EQ(hash_map_cache_stats(table).hits, 0);
+}
+
+TEST_F(HashMapTest, cache_matches_reference)
+{
+	// LRU nad std::list jako reference pro kazdy engine a postupne zvetsovani
+	const hash_map_engine_t engines[] = {HASH_MAP_ENGINE_PROBING, HASH_MAP_ENGINE_GROUPS, 
+	                                     HASH_MAP_ENGINE_ROBIN_HOOD};
+	for (hash_map_engine_t engine : engines)
+	{
+		hash_map_dtor(table);
+		table = hash_map_ctor();
+		ASSERT_EQ(hash_map_set_engine(table, engine), OK);
+		hash_map_set_resize_policy(table, HASH_MAP_RESIZE_INCREMENTAL);
+		ASSERT_EQ(hash_map_set_value_size(table, sizeof(int)), OK);
+		ASSERT_EQ(hash_map_set_cache_limit(table, 500), OK);
+		std::vector<std::string> order;
+		uint32_t state = 12345;
+		for (int i = 0; i < 8000; i++)
+		{
+			state = state * 1103515245 + 12345;
+			std::string key = "k" + std::to_string((state >> 8) % 1000);
+			auto found = std::find(order.begin(), order.end(), key);
+			int value;
+			if (state & 1)
+			{
+				ASSERT_EQ(hash_map_get_value(table, key.c_str(), &value) == OK, found != order.end());
+			}
+			else
+			{
+				ASSERT_EQ(hash_map_put_value(table, key.c_str(), &i) == OK, found == order.end());
+			}
+			if (found != order.end())
+			{
+				order.erase(found);
+				order.push_back(key);
+			}
+			else if (!(state & 1))
+			{
+				order.push_back(key);
+				if (order.size() > 500)
+				{
+					order.erase(order.begin());
+				}
+			}
+		}
+		ASSERT_EQ(hash_map_size(table), order.size());
+		hash_map_item_t* item = table->first;
+		for (const std::string& key : order)
+		{
+			ASSERT_NE(item, nullptr);
+			EXPECT_EQ(key, item->key);
+			EXPECT_TRUE(hash_map_contains(table, key.c_str()));
+			item = item->next;
+		}
+	}
+}
+
+TEST_F(HashMapTest, freeze)
+{
+	std::string key;
+	for (int i = 0; i < 5000; i++)
+	{
+		key = "frozen" + std::to_string(i);
+		ASSERT_EQ(hash_map_put(table, key.c_str(), i), OK);
+	}
+	size_t key_bytes = 0;
+	for (int i = 0; i < 5000; i++)
+	{
+		key = "frozen" + std::to_string(i);
+		if (i % 3 == 0)
+		{
+			ASSERT_EQ(hash_map_remove(table, key.c_str()), OK);
+		}
+		else
+		{
+			key_bytes += key.size();
+		}
+	}
+	hash_map_frozen_t* frozen;
+	ASSERT_EQ(hash_map_freeze(table, &frozen), OK);
+	ASSERT_EQ(hash_map_frozen_size(frozen), hash_map_size(table));
+	// skupiny s nejvyse HASH_MAP_FROZEN_BUCKET_SIZE klici v prumeru
+	EXPECT_EQ(frozen->buckets, (frozen->size + HASH_MAP_FROZEN_BUCKET_SIZE - 1) / HASH_MAP_FROZEN_BUCKET_SIZE);
+	// klice lezi za sebou bez ukoncovacich nul
+	EXPECT_EQ(frozen->offsets[frozen->size], key_bytes);
+	EXPECT_LT(frozen->bytes, hash_map_size(table) * sizeof(hash_map_item_t));
+
+	// zdrojova tabulka zustava pouzitelna
+	EXPECT_EQ(hash_map_put(table, "frozen0", 0), OK);
+	EXPECT_FALSE(hash_map_frozen_contains(frozen, "frozen0"));
+	int value;
+	for (int i = 0; i < 5000; i++)
+	{
+		key = "frozen" + std::to_string(i);
+		if (i % 3 == 0)
+		{
+			EXPECT_EQ(hash_map_frozen_get(frozen, key.c_str(), &value), KEY_ERROR);
+			continue;
+		}
+		ASSERT_EQ(hash_map_frozen_get(frozen, key.c_str(), &value), OK);
+		EXPECT_EQ(value, i);
+		EXPECT_TRUE(hash_map_frozen_contains_n(frozen, key.c_str(), key.size()));
+		// klic jine delky se stejnou predponou
+		key += '#';
+		EXPECT_FALSE(hash_map_frozen_contains_n(frozen, key.c_str(), key.size()));
+	}
+	EXPECT_FALSE(hash_map_frozen_contains(frozen, ""));
+	point_t point;
+	EXPECT_EQ(hash_map_frozen_get_value(frozen, "frozen1", &point), VALUE_ERROR);
+	hash_map_frozen_dtor(frozen);
+}
+
+TEST_F(HashMapTest, freeze_empty_and_small)
+{
+	hash_map_frozen_t* frozen;
+	int value;
+	ASSERT_EQ(hash_map_freeze(table, &frozen), OK);
+	EXPECT_EQ(hash_map_frozen_size(frozen), 0);
+	EXPECT_FALSE(hash_map_frozen_contains(frozen, "a"));
+	EXPECT_EQ(hash_map_frozen_get(frozen, "a", &value), KEY_ERROR);
+	hash_map_frozen_dtor(frozen);
+
+	// zmrazena tabulka nezavisi na hasovaci funkci zdrojove tabulky
+	ASSERT_EQ(hash_map_set_hash_function(table, hash_map_additive_hash), OK);
+	const char* keys[] = {"abc", "bca", "cab", "x", "yy"};
+	for (int i = 0; i < 5; i++)
+	{
+		ASSERT_EQ(hash_map_put(table, keys[i], i), OK);
+	}
+	ASSERT_EQ(hash_map_freeze(table, &frozen), OK);
+	for (int i = 0; i < 5; i++)
+	{
+		ASSERT_EQ(hash_map_frozen_get(frozen, keys[i], &value), OK);
+		EXPECT_EQ(value, i);
+	}
+	EXPECT_FALSE(hash_map_frozen_contains(frozen, "acb"));
+	hash_map_frozen_dtor(frozen);
+}
+
+TEST_F(HashMapTest, freeze_values)
+{
+	ASSERT_EQ(hash_map_set_value_size(table, sizeof(point_t)), OK);
+	std::string key;
+	for (int i = 0; i < 1000; i++)
+	{
+		key = "point" + std::to_string(i);
+		point_t point = {(double)i, -(double)i, "p"};
+		ASSERT_EQ(hash_map_put_value(table, key.c_str(), &point), OK);
+	}
+	hash_map_frozen_t* frozen;
+	ASSERT_EQ(hash_map_freeze(table, &frozen), OK);
+	hash_map_dtor(table);
+	table = hash_map_ctor();
+
+	point_t point;
+	for (int i = 0; i < 1000; i++)
+	{
+		key = "point" + std::to_string(i);
+		ASSERT_EQ(hash_map_frozen_get_value(frozen, key.c_str(), &point), OK);
+		EXPECT_EQ(point.x, (double)i);
+		EXPECT_EQ(point.y, -(double)i);
+	}
+	EXPECT_EQ(hash_map_frozen_get_value(frozen, "point1000", &point), KEY_ERROR);
+	hash_map_frozen_dtor(frozen);
+}
+
+TEST_F(HashMapTest, save_and_load)
+{
+	std::string path = ::testing::TempDir() + "hash_map_save_and_load.bin";
+	double pair[2];
+	ASSERT_EQ(hash_map_set_value_size(table, sizeof(pair)), OK);
+	std::string key;
+	for (int i = 0; i < 3000; i++)
+	{
+		key = "saved" + std::to_string(i);
+		pair[0] = i;
+		pair[1] = i / 2.0;
+		ASSERT_EQ(hash_map_put_value(table, key.c_str(), pair), OK);
+		ASSERT_EQ(hash_map_put(table, key.c_str(), -i), KEY_ALREADY_EXISTS);
+	}
+	ASSERT_EQ(hash_map_save(table, path.c_str()), OK);
+	hash_map_dtor(table);
+	table = hash_map_ctor();
+
+	hash_map_frozen_t* frozen;
+	ASSERT_EQ(hash_map_frozen_load(path.c_str(), &frozen), OK);
+	EXPECT_NE(frozen->mapping, nullptr);
+	// pole ukazuji primo do namapovaneho souboru
+	EXPECT_EQ((const char*)frozen->displacement, (const char*)frozen->mapping + 64);
+	EXPECT_EQ((const char*)frozen->keys + frozen->offsets[frozen->size], 
+	          (const char*)frozen->mapping + frozen->bytes);
+	ASSERT_EQ(hash_map_frozen_size(frozen), 3000);
+	int value;
+	for (int i = 0; i < 3000; i++)
+	{
+		key = "saved" + std::to_string(i);
+		ASSERT_EQ(hash_map_frozen_get(frozen, key.c_str(), &value), OK);
+		EXPECT_EQ(value, -i);
+		ASSERT_EQ(hash_map_frozen_get_value(frozen, key.c_str(), pair), OK);
+		EXPECT_EQ(pair[0], (double)i);
+		EXPECT_EQ(pair[1], i / 2.0);
+	}
+	EXPECT_FALSE(hash_map_frozen_contains(frozen, "saved3000"));
+
+	// ulozeni nactene tabulky vytvori stejny soubor
+	std::string copy = path + ".copy";
+	ASSERT_EQ(hash_map_frozen_save(frozen, copy.c_str()), OK);
+	hash_map_frozen_t* reloaded;
+	ASSERT_EQ(hash_map_frozen_load(copy.c_str(), &reloaded), OK);
+	ASSERT_EQ(reloaded->bytes, frozen->bytes);
+	EXPECT_EQ(memcmp(reloaded->mapping, frozen->mapping, frozen->bytes), 0);
+	hash_map_frozen_dtor(reloaded);
+	hash_map_frozen_dtor(frozen);
+	remove(copy.c_str());
+	remove(path.c_str());
+}
+
+TEST_F(HashMapTest, load_invalid_files)
+{
+	std::string path = ::testing::TempDir() + "hash_map_load_invalid.bin";
+	hash_map_frozen_t* frozen;
+	remove(path.c_str());
+	EXPECT_EQ(hash_map_frozen_load(path.c_str(), &frozen), IO_ERROR);
+	EXPECT_EQ(hash_map_save(table, "/nonexistent-directory/hash_map.bin"), IO_ERROR);
+
+	// prazdna tabulka ma jen hlavicku a zacatek klicu
+	ASSERT_EQ(hash_map_save(table, path.c_str()), OK);
+	ASSERT_EQ(hash_map_frozen_load(path.c_str(), &frozen), OK);
+	EXPECT_EQ(frozen->bytes, 64 + sizeof(size_t));
+	EXPECT_FALSE(hash_map_frozen_contains(frozen, "a"));
+	hash_map_frozen_dtor(frozen);
+
+	// zkraceny soubor
+	ASSERT_EQ(hash_map_put(table, "a", 1), OK);
+	ASSERT_EQ(hash_map_save(table, path.c_str()), OK);
+	ASSERT_EQ(truncate(path.c_str(), 70), 0);
+	EXPECT_EQ(hash_map_frozen_load(path.c_str(), &frozen), VALUE_ERROR);
+
+	// cizi soubor
+	FILE* file = fopen(path.c_str(), "wb");
+	ASSERT_NE(file, nullptr);
+	std::string text(100, 'x');
+	fwrite(text.data(), 1, text.size(), file);
+	fclose(file);
+	EXPECT_EQ(hash_map_frozen_load(path.c_str(), &frozen), VALUE_ERROR);
+
+	// poskozena posunuti a zacatky klicu se odhali az pri hledani
+	std::string key;
+	for (int i = 0; i < 100; i++)
+	{
+		key = "key" + std::to_string(i);
+		hash_map_put(table, key.c_str(), i);
+	}
+	ASSERT_EQ(hash_map_save(table, path.c_str()), OK);
+	ASSERT_EQ(hash_map_frozen_load(path.c_str(), &frozen), OK);
+	size_t buckets = frozen->buckets;
+	size_t size = frozen->size;
+	hash_map_frozen_dtor(frozen);
+	file = fopen(path.c_str(), "r+b");
+	ASSERT_NE(file, nullptr);
+	fseek(file, 64, SEEK_SET);
+	std::vector<uint64_t> displacement(buckets / 2, 0xFFFFFFFFFFULL);
+	fwrite(displacement.data(), sizeof(uint64_t), displacement.size(), file);
+	fseek(file, 64 + (long)(buckets*sizeof(uint64_t) + sizeof(size_t)), SEEK_SET);
+	std::vector<size_t> offsets(size / 2, SIZE_MAX / 2);
+	fwrite(offsets.data(), sizeof(size_t), offsets.size(), file);
+	fclose(file);
+	ASSERT_EQ(hash_map_frozen_load(path.c_str(), &frozen), OK);
+	int value;
+	for (int i = 0; i < 100; i++)
+	{
+		key = "key" + std::to_string(i);
+		if (hash_map_frozen_get(frozen, key.c_str(), &value) == OK)
+		{
+			EXPECT_EQ(value, i);
+		}
+	}
+	EXPECT_FALSE(hash_map_frozen_contains(frozen, "missing"));
+	hash_map_frozen_dtor(frozen);
+	remove(path.c_str());
+}
+
+TEST(HashMapConcurrentTest, shards)
+{
+	hash_map_concurrent_t* map = hash_map_concurrent_ctor(5);
+	ASSERT_NE(map, nullptr);
+	EXPECT_EQ(map->shard_count, 8);
+	std::string key;
+	for (int i = 0; i < 1000; i++)
+	{
+		key = "key" + std::to_string(i);
+		ASSERT_EQ(hash_map_concurrent_put(map, key.c_str(), i), OK);
+	}
+	EXPECT_EQ(hash_map_concurrent_put(map, "key7", 70), KEY_ALREADY_EXISTS);
+	EXPECT_EQ(hash_map_concurrent_add(map, "key8", 2), KEY_ALREADY_EXISTS);
+	EXPECT_EQ(hash_map_concurrent_size(map), 1000);
+
+	// klice jsou rozlozeny do vsech shardu
+	for (size_t i = 0; i < map->shard_count; i++)
+	{
+		EXPECT_GT(hash_map_size(map->shards[i].map), 60);
+		EXPECT_EQ(map->shards[i].version % 2, 0);
+	}
+
+	int value;
+	ASSERT_EQ(hash_map_concurrent_get(map, "key7", &value), OK);
+	EXPECT_EQ(value, 70);
+	ASSERT_EQ(hash_map_concurrent_get(map, "key8", &value), OK);
+	EXPECT_EQ(value, 10);
+	EXPECT_EQ(hash_map_concurrent_get(map, "missing", &value), KEY_ERROR);
+	ASSERT_EQ(hash_map_concurrent_pop(map, "key7", &value), OK);
+	EXPECT_EQ(value, 70);
+	EXPECT_FALSE(hash_map_concurrent_contains(map, "key7"));
+	EXPECT_TRUE(hash_map_concurrent_contains(map, "key999"));
+	EXPECT_EQ(hash_map_concurrent_pop(map, "key7", &value), KEY_ERROR);
+	EXPECT_EQ(hash_map_concurrent_size(map), 999);
+	hash_map_concurrent_dtor(map);
+}
+
+TEST(HashMapConcurrentTest, readers_and_writers)
+{
+	hash_map_concurrent_t* map = hash_map_concurrent_ctor(4);
+	ASSERT_NE(map, nullptr);
+	const int KEYS = 2000;
+	// stale klice, ktere ctenari musi vzdy najit se spravnou hodnotou
+	for (int i = 0; i < KEYS; i++)
+	{
+		hash_map_concurrent_put(map, ("stable" + std::to_string(i)).c_str(), i);
+	}
+
+	std::vector<std::thread> threads;
+	std::vector<int> errors(4, 0);
+	for (int t = 0; t < 2; t++)
+	{
+		// zapisovatele vkladaji a odstranuji vlastni klice, indexy shardu 
+		// se pritom zvetsuji i zmensuji
+		threads.emplace_back([map, t]() {
+			for (int round = 0; round < 5; round++)
+			{
+				for (int i = 0; i < KEYS; i++)
+				{
+					hash_map_concurrent_add(map, ("w" + std::to_string(t) + "_" + std::to_string(i)).c_str(), 1);
+				}
+				for (int i = 0; i < KEYS; i++)
+				{
+					int value;
+					hash_map_concurrent_pop(map, ("w" + std::to_string(t) + "_" + std::to_string(i)).c_str(), &value);
+				}
+			}
+		});
+	}
+	for (int t = 0; t < 2; t++)
+	{
+		threads.emplace_back([map, t, &errors]() {
+			for (int round = 0; round < 10; round++)
+			{
+				for (int i = 0; i < KEYS; i++)
+				{
+					int value = -1;
+					if (hash_map_concurrent_get(map, ("stable" + std::to_string(i)).c_str(), &value) != OK || 
+					    value != i)
+					{
+						errors[2 + t]++;
+					}
+				}
+			}
+		});
+	}
+	for (auto& thread : threads)
+	{
+		thread.join();
+	}
+	EXPECT_EQ(errors[2], 0);
+	EXPECT_EQ(errors[3], 0);
+	EXPECT_EQ(hash_map_concurrent_size(map), KEYS);
+	hash_map_concurrent_dtor(map);
+}
+
+TEST(HashMapConcurrentTest, churn_reclaims_memory)
+{
+	hash_map_concurrent_t* map = hash_map_concurrent_ctor(4);
+	ASSERT_NE(map, nullptr);
+	const int KEYS = 2000;
+	std::atomic<bool> done(false);
+	std::vector<int> errors(2, 0);
+	hash_map_concurrent_put(map, "stable", 7);
+	std::vector<std::thread> readers;
+	for (int t = 0; t < 2; t++)
+	{
+		readers.emplace_back([map, t, &done, &errors]() {
+			while (!done.load())
+			{
+				int value = -1;
+				if (hash_map_concurrent_get(map, "stable", &value) != OK || value != 7)
+				{
+					errors[t]++;
+				}
+			}
+		});
+	}
+	// indexy, pole zaznamu a bloky areny se opakovane nahrazuji, vyrazena 
+	// pamet se ale prubezne uvolnuje
+	for (int round = 0; round < 200; round++)
+	{
+		for (int i = 0; i < KEYS; i++)
+		{
+			hash_map_concurrent_put(map, ("churn" + std::to_string(i)).c_str(), i);
+		}
+		for (int i = 0; i < KEYS; i++)
+		{
+			int value;
+			hash_map_concurrent_pop(map, ("churn" + std::to_string(i)).c_str(), &value);
+		}
+	}
+	done = true;
+	for (auto& thread : readers)
+	{
+		thread.join();
+	}
+	EXPECT_EQ(errors[0], 0);
+	EXPECT_EQ(errors[1], 0);
+	EXPECT_EQ(hash_map_concurrent_size(map), 1);
+	// neuvolnena zustava jen pamet vyrazena behem poslednich cteni
+	for (size_t i = 0; i < map->shard_count; i++)
+	{
+		EXPECT_LT(map->shards[i].map->retired_count, 2*(size_t)HASH_MAP_RECLAIM_THRESHOLD);
+	}
+	hash_map_concurrent_dtor(map);
+}
+
+TEST(HashMapConcurrentTest, sliding_window)
+{
+	// jediny shard, ve kterem posuvne okno novych klicu zanechava vic 
+	// dummy objektu nez zivych zaznamu a index se prestavuje
+	hash_map_concurrent_t* map = hash_map_concurrent_ctor(1);
+	ASSERT_NE(map, nullptr);
+	const int KEYS = 200000;
+	const int WINDOW = 1000;
+	for (int i = 0; i < 100; i++)
+	{
+		hash_map_concurrent_put(map, ("stable" + std::to_string(i)).c_str(), i);
+	}
+	std::atomic<bool> done(false);
+	std::vector<int> errors(4, 0);
+	std::vector<std::thread> readers;
+	for (int t = 0; t < 4; t++)
+	{
+		readers.emplace_back([map, t, &done, &errors]() {
+			for (unsigned i = t; !done.load(); i += 7)
+			{
+				int value = -1;
+				int key = (int)(i % KEYS);
+				if (hash_map_concurrent_get(map, ("w" + std::to_string(key)).c_str(), &value) == OK && 
+				    value != key)
+				{
+					errors[t]++;
+				}
+				if (hash_map_concurrent_get(map, ("stable" + std::to_string(key % 100)).c_str(), &value) != OK || 
+				    value != key % 100)
+				{
+					errors[t]++;
+				}
+			}
+		});
+	}
+	// prestaveni indexu bez zmeny velikosti alokuje nove pole, stare mohou 
+	// ctenari jeste prochazet
+	hash_map_t* shard = map->shards[0].map;
+	int rebuilds = 0;
+	for (int i = 0; i < KEYS; i++)
+	{
+		hash_map_item_t** index = shard->index;
+		size_t allocated = shard->allocated;
+		hash_map_concurrent_put(map, ("w" + std::to_string(i)).c_str(), i);
+		if (shard->index != index && shard->allocated == allocated)
+		{
+			rebuilds++;
+		}
+		if (i >= WINDOW)
+		{
+			int value;
+			hash_map_concurrent_pop(map, ("w" + std::to_string(i - WINDOW)).c_str(), &value);
+		}
+	}
+	done = true;
+	for (auto& thread : readers)
+	{
+		thread.join();
+	}
+	for (int t = 0; t < 4; t++)
+	{
+		EXPECT_EQ(errors[t], 0);
+	}
+	EXPECT_GT(rebuilds, 0);
+	EXPECT_EQ(hash_map_concurrent_size(map), WINDOW + 100);
+	hash_map_concurrent_dtor(map);
+}
+
+TEST(HashMapConcurrentTest, shared_readers_one_writer)
+{
+	hash_map_t* map = hash_map_ctor();
+	ASSERT_NE(map, nullptr);
+	ASSERT_EQ(hash_map_set_read_policy(map, HASH_MAP_READ_SHARED), OK);
+	const int KEYS = 2000;
+	for (int i = 0; i < KEYS; i++)
+	{
+		hash_map_put(map, ("stable" + std::to_string(i)).c_str(), i);
+	}
+
+	std::vector<std::thread> threads;
+	std::vector<int> errors(3, 0);
+	// jediny zapisovatel vklada a odstranuje vlastni klice, index se 
+	// pritom zvetsuje, zmensuje i prestavuje
+	threads.emplace_back([map]() {
+		for (int round = 0; round < 5; round++)
+		{
+			for (int i = 0; i < KEYS; i++)
+			{
+				hash_map_add(map, ("w_" + std::to_string(i)).c_str(), 1);
+			}
+			for (int i = 0; i < KEYS; i++)
+			{
+				int value;
+				hash_map_pop(map, ("w_" + std::to_string(i)).c_str(), &value);
+			}
+		}
+	});
+	for (int t = 0; t < 3; t++)
+	{
+		threads.emplace_back([map, t, &errors]() {
+			for (int round = 0; round < 10; round++)
+			{
+				for (int i = 0; i < KEYS; i++)
+				{
+					int value = -1;
+					if (hash_map_get(map, ("stable" + std::to_string(i)).c_str(), &value) != OK || 
+					    value != i)
+					{
+						errors[t]++;
+					}
+				}
+			}
+		});
+	}
+	for (auto& thread : threads)
+	{
+		thread.join();
+	}
+	EXPECT_EQ(errors[0], 0);
+	EXPECT_EQ(errors[1], 0);
+	EXPECT_EQ(errors[2], 0);
+	EXPECT_EQ(hash_map_size(map), KEYS);
+	// bez ctenaru se pri dalsim vyrazeni uvolni vse, co se nahromadilo
+	int value;
+	hash_map_put(map, "last", 1);
+	hash_map_pop(map, "last", &value);
+	EXPECT_LT(map->retired_count, (size_t)HASH_MAP_RECLAIM_THRESHOLD);
+	hash_map_dtor(map);
+}
+
 /*** Konec souboru white_box_tests.cpp ***/